@@ -10,16 +10,24 @@
 #include <bitset>
 #include <string>
 #include <map>
-#include <set>
 #include <iomanip>
 #include <sstream>
+#include "FileReplayTransport.h"
+#include "SyncScanner.h"
+#include "SyncPairing.h"
+#include "Deinterleave.h"
+#include "LineParser.h"
+#include "FrameBuffer.h"
+#include "FramePool.h"
+#include "FrameViewer.h"
+#include "Metrics.h"
 #include <gdiplus.h>
 #pragma comment(lib, "gdiplus.lib")
 
 // Global variables for watchdog
 std::atomic<bool> g_programRunning(true);
-std::atomic<long> g_totalBytesTransferred(0);
-std::atomic<long> g_lastBytesTransferred(0);
+std::atomic<long long> g_totalBytesTransferred(0);
+std::atomic<long long> g_lastBytesTransferred(0);
 std::atomic<bool> g_watchdogActive(false);
 std::atomic<int> g_programStage(0);  // Track program stage: 0=init, 1=setup, 2=transfer
 std::atomic<long long> g_lastProgressTime(0);  // Last time progress was made
@@ -35,425 +43,6 @@ const size_t ANALYSIS_BUFFER_SIZE = 2 * 1024 * 1024; // 2 MB for analysis
 // Global buffer to store received data for analysis
 std::vector<unsigned char> g_analysisBuffer;
 
-// Add these declarations near the top, before any function definitions
-std::vector<bool> createSAVPattern();
-std::vector<bool> createEAVPattern();
-std::vector<bool> createSAVIPattern();
-std::vector<bool> createEAVIPattern();
-struct VideoLine;  // Forward declaration
-struct VideoFrame; // Forward declaration
-
-// Helper functions for data analysis
-std::vector<bool> createSAVPattern();  // Add these declarations
-std::vector<bool> createEAVPattern();  // near the other function declarations
-
-// Add this forward declaration near the top of the file, with the other forward declarations
-void applyAdaptiveHistogramEqualization(BYTE* imageData, int width, int height, int tileSize);
-
-// Add this global variable near the top with the other globals
-bool g_applyHistogramEqualization = false; // Toggle for histogram equalization
-
-// Implement a grayscale-specific adaptive histogram equalization
-void applyHistogramEqualization(BYTE* grayImageData, int width, int height) {
-    if (!grayImageData || width <= 0 || height <= 0) return;
-    
-    // Create temporary buffer for the processed image
-    BYTE* equalizedImage = new BYTE[width * height];
-    memset(equalizedImage, 0, width * height);
-    
-    // Define tile size for adaptive processing
-    const int tileSize = 32; // Can be adjusted based on image details
-    const int numTilesX = (width + tileSize - 1) / tileSize;
-    const int numTilesY = (height + tileSize - 1) / tileSize;
-    
-    // Process each tile separately
-    for (int tileY = 0; tileY < numTilesY; tileY++) {
-        for (int tileX = 0; tileX < numTilesX; tileX++) {
-            // Tile boundaries
-            int startX = tileX * tileSize;
-            int startY = tileY * tileSize;
-            int endX = (startX + tileSize < width) ? (startX + tileSize) : width;
-            int endY = (startY + tileSize < height) ? (startY + tileSize) : height;
-            
-            // Calculate histogram for this tile
-            int histogram[256] = {0};
-            for (int y = startY; y < endY; y++) {
-                for (int x = startX; x < endX; x++) {
-                    histogram[grayImageData[y * width + x]]++;
-                }
-            }
-            
-            // Calculate cumulative distribution function (CDF)
-            int cdf[256] = {0};
-            cdf[0] = histogram[0];
-            for (int i = 1; i < 256; i++) {
-                cdf[i] = cdf[i - 1] + histogram[i];
-            }
-            
-            // Skip empty tiles
-            if (cdf[255] == 0) continue;
-            
-            // Normalize CDF to create lookup table
-            float scale = 255.0f / cdf[255];
-            BYTE lut[256] = {0};
-            for (int i = 0; i < 256; i++) {
-                int value = static_cast<int>(cdf[i] * scale);
-                lut[i] = (value > 255) ? 255 : static_cast<BYTE>(value);
-            }
-            
-            // Apply equalization to this tile
-            for (int y = startY; y < endY; y++) {
-                for (int x = startX; x < endX; x++) {
-                    equalizedImage[y * width + x] = lut[grayImageData[y * width + x]];
-                }
-            }
-        }
-    }
-    
-    // Copy the equalized image back to the original buffer
-    memcpy(grayImageData, equalizedImage, width * height);
-    
-    // Clean up
-    delete[] equalizedImage;
-}
-
-// Convert a hex string to a vector of bits
-std::vector<bool> hexToBinaryVector(const std::string& hexStr, int numBits) {
-    std::vector<bool> result(numBits, false);
-    unsigned long value = std::stoul(hexStr, nullptr, 16);
-    
-    for (int i = 0; i < numBits; ++i) {
-        result[numBits - 1 - i] = (value >> i) & 1;
-    }
-    
-    return result;
-}
-
-// Get code pattern for specific sync codes
-std::vector<bool> getCode(const std::string& code) {
-    std::vector<bool> result(8, false);
-    
-    if (code == "sav") {
-        // SAV: Start of Active Video (0x80)
-        result = {1, 0, 0, 0, 0, 0, 0, 0};  // 0x80
-    } else if (code == "savi") {
-        // SAVI: Start of Active Video Invalid (0xAB)
-        result = {1, 0, 1, 0, 1, 0, 1, 1};  // 0xAB
-    } else if (code == "eav") {
-        // EAV: End of Active Video (0x9D)
-        result = {1, 0, 0, 1, 1, 1, 0, 1};  // 0x9D
-    } else if (code == "eavi") {
-        // EAVI: End of Active Video Invalid (0xB6)
-        result = {1, 0, 1, 1, 0, 1, 1, 0};  // 0xB6
-    }
-    
-    return result;
-}
-
-// Convert uint32 data to bits with specified endianness (optimized version)
-std::vector<uint8_t> lookAtBits(const std::vector<uint32_t>& data, bool useGPU, 
-                               const std::string& endian, bool vector, const std::string& bitDepth) {
-    // Determine number of bits based on bitDepth
-    int numBits = 32;  // For uint32
-    if (bitDepth == "uint16") numBits = 16;
-    else if (bitDepth == "uint8") numBits = 8;
-    
-    // Create bit order array based on endianness
-    std::vector<int> bitOrder(numBits);
-    if (endian == "big") {
-        for (int i = 0; i < numBits; i++) bitOrder[i] = numBits - i;
-    } else {
-        for (int i = 0; i < numBits; i++) bitOrder[i] = i + 1;
-    }
-    
-    // Process each element for each bit position (like MATLAB's bitget)
-    std::vector<uint8_t> result;
-    result.reserve(data.size() * numBits);
-    
-    for (size_t i = 0; i < data.size(); i++) {
-            uint32_t value = data[i];
-        for (int bit = 0; bit < numBits; bit++) {
-            result.push_back((value >> (bitOrder[bit] - 1)) & 1);
-        }
-    }
-    
-    return result;
-}
-
-// Find pattern in bit stream (similar to MATLAB's strfind)
-// Optimized version using Knuth-Morris-Pratt algorithm for better performance
-std::vector<size_t> findPattern(const std::vector<bool>& data, const std::vector<bool>& pattern) {
-    std::vector<size_t> indices;
-    
-    if (pattern.empty() || pattern.size() > data.size()) {
-        return indices;
-    }
-    
-    // For very small patterns, use a simple search
-    if (pattern.size() <= 4) {
-        for (size_t i = 0; i <= data.size() - pattern.size(); ++i) {
-            bool match = true;
-            for (size_t j = 0; j < pattern.size(); ++j) {
-                if (data[i + j] != pattern[j]) {
-                    match = false;
-                    break;
-                }
-            }
-            
-            if (match) {
-                indices.push_back(i);
-            }
-        }
-        return indices;
-    }
-    
-    // For larger patterns, use KMP algorithm
-    // Compute the failure function
-    std::vector<size_t> failure(pattern.size(), 0);
-    size_t j = 0;
-    
-    for (size_t i = 1; i < pattern.size(); ++i) {
-        if (pattern[i] == pattern[j]) {
-            failure[i] = j + 1;
-            j++;
-        } else if (j > 0) {
-            j = failure[j - 1];
-            i--; // Retry with the new j
-        }
-    }
-    
-    // Search for the pattern
-    j = 0;
-    for (size_t i = 0; i < data.size(); ++i) {
-        if (data[i] == pattern[j]) {
-            j++;
-            if (j == pattern.size()) {
-                // Pattern found
-                indices.push_back(i - pattern.size() + 1);
-                j = failure[j - 1];
-            }
-        } else if (j > 0) {
-            j = failure[j - 1];
-            i--; // Retry with the new j
-        }
-    }
-    
-    return indices;
-}
-
-// Find intersection of two vectors (similar to MATLAB's intersect)
-std::vector<size_t> intersect(const std::vector<size_t>& a, const std::vector<size_t>& b) {
-    std::vector<size_t> result;
-    std::set<size_t> setA(a.begin(), a.end());
-    
-    for (const auto& val : b) {
-        if (setA.find(val) != setA.end()) {
-            result.push_back(val);
-        }
-    }
-    
-    std::sort(result.begin(), result.end());
-    return result;
-}
-
-// Match start and end indices (similar to MATLAB's matchIdxs function)
-void matchIdxs(std::vector<size_t>& start, std::vector<size_t>& stop) {
-    // This function pairs each start (sav) index with an end (eav) index.
-    // If no valid eav is found (i.e. none within the expected window),
-    // it assigns a pseudo eav at (sav + 1488) bits.
-    const size_t lowerBound = 2500/2;
-    const size_t upperBound = 3500/2;
-    const size_t defaultBits = 1488;  // if no eav is found, use sav + 1488 bits
-
-    std::vector<size_t> newStart;
-    std::vector<size_t> newStop;
-    
-    for (size_t i = 0; i < start.size(); ++i) {
-        size_t s = start[i];
-        bool foundMatch = false;
-        
-        for (size_t j = 0; j < stop.size(); ++j) {
-            size_t diff = stop[j] > s ? stop[j] - s : 0;
-            if (diff >= lowerBound && diff <= upperBound) {
-                // Found a valid match
-                newStart.push_back(s);
-                newStop.push_back(stop[j]);
-                foundMatch = true;
-                break;
-            }
-        }
-        
-        if (!foundMatch) {
-            // No matching eav found: assign a pseudo eav at sav + 1488 bits
-            newStart.push_back(s);
-            newStop.push_back(s + defaultBits);
-        }
-    }
-    
-    // Update the original vectors
-    start = newStart;
-    stop = newStop;
-}
-
-// New function to find initial sync pattern across all channels
-std::vector<size_t> findInitialSync(const std::vector<std::vector<bool>>& channels, 
-                                   const std::vector<bool>& savPattern) {
-    const size_t numChannels = channels.size();
-    if (numChannels != 4) return {};
-
-    std::cout << "\nSearching for initial sync pattern..." << std::endl;
-    std::cout << "Pattern length: " << savPattern.size() << " bits" << std::endl;
-    std::cout << "Looking in " << channels[0].size() << " bits per channel" << std::endl;
-
-    // Search first channel for SAV
-    std::vector<size_t> initialIndices;
-    size_t searchLimit = std::min<size_t>(channels[0].size() - savPattern.size(), 1000000);  // Limit initial search
-    
-    for (size_t i = 0; i <= searchLimit; i++) {
-        if (i % 1000000 == 0) {  // Progress update every million positions
-            std::cout << "Searching at position " << i << "..." << std::endl;
-        }
-        
-        bool match = true;
-        for (size_t j = 0; j < savPattern.size(); j++) {
-            if (channels[0][i + j] != savPattern[j]) {
-                match = false;
-                break;
-            }
-        }
-        
-        if (match) {
-            std::cout << "Found potential sync at position " << i << " in channel 1" << std::endl;
-            
-            // Print the matching bits
-            std::cout << "Matched pattern: ";
-            for (size_t j = 0; j < savPattern.size(); j++) {
-                std::cout << (channels[0][i + j] ? "1" : "0");
-                if ((j + 1) % 8 == 0) std::cout << " ";
-            }
-            std::cout << std::endl;
-            
-            // Verify this SAV exists at same position in all channels
-            bool allChannelsMatch = true;
-            for (size_t ch = 1; ch < numChannels; ch++) {
-                bool channelMatch = true;
-                for (size_t j = 0; j < savPattern.size(); j++) {
-                    if (channels[ch][i + j] != savPattern[j]) {
-                        channelMatch = false;
-                        break;
-                    }
-                }
-                if (!channelMatch) {
-                    std::cout << "Pattern mismatch in channel " << (ch + 1) << std::endl;
-                    allChannelsMatch = false;
-                    break;
-                }
-                std::cout << "Pattern matched in channel " << (ch + 1) << std::endl;
-            }
-            
-            if (allChannelsMatch) {
-                std::cout << "Found valid sync across all channels at position " << i << std::endl;
-                initialIndices.push_back(i);
-                break;
-            }
-        }
-    }
-    
-    return initialIndices;
-}
-
-// New function to validate and extract sync positions using known spacing
-std::vector<std::pair<size_t, size_t>> extractSyncPositions(
-    const std::vector<std::vector<bool>>& channels,
-    const std::vector<bool>& savPattern,
-    const std::vector<bool>& eavPattern,
-    size_t initialPos) {
-    
-    const size_t BITS_PER_BYTE = 8;
-    const size_t SYNC_SIZE = savPattern.size();
-    const size_t MIN_DATA_BYTES = 180;
-    const size_t MAX_DATA_BYTES = 186;  // Increased to 186 based on observed data
-    
-    std::vector<std::pair<size_t, size_t>> syncPairs;
-    size_t currentPos = initialPos;
-    size_t maxSearch = std::min<size_t>(channels[0].size(), 100000ULL);  // Limit search to first 100K positions
-    
-    while (currentPos < maxSearch) {
-        // Verify SAV at current position
-        bool validSAV = true;
-        for (const auto& channel : channels) {
-            for (size_t i = 0; i < savPattern.size(); i++) {
-                if (currentPos + i >= channel.size() || channel[currentPos + i] != savPattern[i]) {
-                    validSAV = false;
-                    break;
-                }
-            }
-            if (!validSAV) break;
-        }
-        
-        if (!validSAV) {
-            currentPos++;
-            continue;
-        }
-        
-        // Look for EAV
-        bool foundEAV = false;
-        size_t eavPos = 0;
-        
-        for (size_t dataBytes = MIN_DATA_BYTES; dataBytes <= MAX_DATA_BYTES; dataBytes++) {
-            size_t testPos = currentPos + (dataBytes * BITS_PER_BYTE);
-            if (testPos + eavPattern.size() > channels[0].size()) break;
-            
-            bool validAtPos = true;
-            for (const auto& channel : channels) {
-                for (size_t i = 0; i < eavPattern.size(); i++) {
-                    if (channel[testPos + i] != eavPattern[i]) {
-                        validAtPos = false;
-                        break;
-                    }
-                }
-                if (!validAtPos) break;
-            }
-            
-            if (validAtPos) {
-                foundEAV = true;
-                eavPos = testPos;
-                break;
-            }
-        }
-        
-        if (foundEAV) {
-            syncPairs.push_back({currentPos, eavPos});
-            currentPos = eavPos + eavPattern.size();  // Skip to after this EAV
-        } else {
-            currentPos++;  // No EAV found, try next position
-        }
-        
-        // Print progress every 10000 positions
-        if (syncPairs.size() % 10 == 0) {
-            std::cout << "Found " << syncPairs.size() << " valid lines so far..." << std::endl;
-        }
-    }
-    
-    return syncPairs;
-}
-
-// Add these new structures to help organize frame data
-struct VideoLine {
-    std::vector<uint8_t> channel1;
-    std::vector<uint8_t> channel2;
-    std::vector<uint8_t> channel3;
-    std::vector<uint8_t> channel4;
-    std::vector<uint8_t> interleavedData;
-    size_t startIndex;
-    size_t endIndex;
-};
-
-struct VideoFrame {
-    std::vector<VideoLine> lines;
-    int frameNumber;
-};
-
 // Add these global variables for the display window
 HWND g_displayWindow = NULL;
 HDC g_memoryDC = NULL;
@@ -541,49 +130,16 @@ void CleanupDisplay() {
     g_displayInitialized = false;
 }
 
-// Modify the displayFrameImage function to use the correct pixel count
-void displayFrameImage(const VideoFrame& frame, int frameNumber) {
-    if (frame.lines.empty()) {
-        std::cout << "Cannot display empty frame" << std::endl;
+// Copies a finished texture into the window's bitmap and repaints. Runs on
+// the viewer's present thread, which owns the window.
+void presentTexture(const ViewerTexture& texture) {
+    // 178 bytes per channel x 4 channels = 712 pixels, interleaved by the parser
+    const int width = texture.width;
+    const int height = texture.height;
+    if (width == 0 || height == 0 || !g_displayInitialized) {
         return;
     }
     
-    // Use the proper calculation for pixel count - 178 bytes per channel × 4 channels = 712 pixels
-    const int bytesPerChannel = 178; // From SAV/EAV analysis (1488 bits / 8 = 186 bytes, minus sync = 178)
-    const int width = bytesPerChannel * 4; // All 4 channels interleaved = 712 pixels
-    
-    // Calculate image dimensions with safety limits
-    int height = static_cast<int>(frame.lines.size());
-    // Limit excessive image height to prevent memory issues
-    const int MAX_HEIGHT = 2000;
-    if (height > MAX_HEIGHT) {
-        std::cout << "Warning: Limiting frame height from " << height << " to " << MAX_HEIGHT << " lines" << std::endl;
-        height = MAX_HEIGHT;
-    }
-    
-    // Safety check for memory allocation
-    size_t requiredMemory = static_cast<size_t>(width) * static_cast<size_t>(height);
-    if (requiredMemory > 100 * 1024 * 1024) { // 100MB limit
-        std::cout << "Warning: Image too large to display safely (" << 
-                  (requiredMemory / (1024 * 1024)) << " MB). Skipping display." << std::endl;
-        return;
-    }
-    
-    if (width == 0) {
-        std::cout << "Warning: Line has no data, cannot create image" << std::endl;
-        return;
-    }
-    
-    std::cout << "Displaying Frame " << frameNumber 
-              << " (" << width << "x" << height << ") with all 4 channels interleaved" << std::endl;
-    
-    // Initialize display window if needed
-    if (!g_displayInitialized) {
-        if (!InitializeDisplayWindow()) {
-            return;
-        }
-    }
-    
     // Check if we need to recreate the bitmap (if dimensions changed)
     if (g_currentWidth != width || g_currentHeight != height) {
         // Clean up existing resources
@@ -653,326 +209,130 @@ void displayFrameImage(const VideoFrame& frame, int frameNumber) {
     }
     
     // Update window title with frame info
-    std::string title = "Frame " + std::to_string(frameNumber) + 
+    std::string title = "Frame " + std::to_string(texture.frameNumber) + 
                         " (" + std::to_string(width) + "x" + std::to_string(height) + ")";
     SetWindowTextA(g_displayWindow, title.c_str());
     
-    // Fill bitmap data from frame - use all 4 channels interleaved
+    // The texture is already interleaved row by row at the bitmap's width,
+    // and its palette is laid out as the DIB's colour table
     if (g_displayBuffer) {
-        ZeroMemory(g_displayBuffer, width * height);
-        
-        for (int y = 0; y < height; y++) {
-            if (y >= static_cast<int>(frame.lines.size())) break;
-            
-            const auto& line = frame.lines[static_cast<size_t>(y)];
-            
-            // Check if we have all channel data
-            if (line.channel1.empty() || line.channel2.empty() || 
-                line.channel3.empty() || line.channel4.empty()) {
-                continue;  // Skip if any channel is missing
-            }
-            
-            // Calculate max pixel value for this line
-            size_t ch1Size = line.channel1.size();
-            size_t ch2Size = line.channel2.size();
-            size_t ch3Size = line.channel3.size();
-            size_t ch4Size = line.channel4.size();
-            size_t pixelsPerChannel = ch1Size;
-            if (ch2Size < pixelsPerChannel) pixelsPerChannel = ch2Size;
-            if (ch3Size < pixelsPerChannel) pixelsPerChannel = ch3Size;
-            if (ch4Size < pixelsPerChannel) pixelsPerChannel = ch4Size;
-            
-            // Interleave channel data according to the specified pattern
-            // ch1: pixels 0, 4, 8, ...
-            // ch2: pixels 1, 5, 9, ...
-            // ch3: pixels 2, 6, 10, ...
-            // ch4: pixels 3, 7, 11, ...
-            for (size_t i = 0; i < pixelsPerChannel; i++) {
-                // Each value from channel1 goes to position 0, 4, 8, ...
-                g_displayBuffer[y * width + (i * 4)]     = line.channel1[i];
-                // Each value from channel2 goes to position 1, 5, 9, ...
-                g_displayBuffer[y * width + (i * 4 + 1)] = line.channel2[i];
-                // Each value from channel3 goes to position 2, 6, 10, ...
-                g_displayBuffer[y * width + (i * 4 + 2)] = line.channel3[i];
-                // Each value from channel4 goes to position 3, 7, 11, ...
-                g_displayBuffer[y * width + (i * 4 + 3)] = line.channel4[i];
-            }
-        }
-    }
-    
-    // Apply histogram equalization only if enabled
-    if (g_applyHistogramEqualization) {
-        std::cout << "Applying histogram equalization to enhance image contrast..." << std::endl;
-    applyHistogramEqualization(g_displayBuffer, width, height);
-    } else {
-        std::cout << "Displaying raw image data without enhancement..." << std::endl;
+        memcpy(g_displayBuffer, texture.pixels.data(), static_cast<size_t>(width) * height);
+        SetDIBColorTable(g_memoryDC, 0, 256, reinterpret_cast<const RGBQUAD*>(texture.palette.data()));
     }
     
     // Force window to repaint
     InvalidateRect(g_displayWindow, NULL, FALSE);
     UpdateWindow(g_displayWindow);
-    
-    // Process any pending messages
-    MSG msg;
-    while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
-        // Add keyboard handler for toggling histogram equalization
-        if (msg.message == WM_KEYDOWN) {
-            if (msg.wParam == 'H' || msg.wParam == 'h') {
-                g_applyHistogramEqualization = !g_applyHistogramEqualization;
-                std::cout << "Histogram equalization " 
-                          << (g_applyHistogramEqualization ? "enabled" : "disabled") << std::endl;
-                
-                // Re-process the current image with the new setting
-                if (g_applyHistogramEqualization) {
-                    applyHistogramEqualization(g_displayBuffer, width, height);
-                } else {
-                    // Redisplay the image (we'll need to reload the original data)
-                    // For simplicity, just signal to redraw for now
-                }
-                InvalidateRect(g_displayWindow, NULL, FALSE);
-            }
-        }
-        
-        TranslateMessage(&msg);
-        DispatchMessage(&msg);
-        
-        if (msg.message == WM_QUIT) {
-            g_displayInitialized = false;
-            break;
-        }
-    }
 }
 
-// Modify the displayAllFrames function to display each frame for 5 seconds
-void displayAllFrames(const std::vector<VideoFrame>& frames) {
-    std::cout << "\n===== Displaying Frame Images =====\n" << std::endl;
-    
-    if (frames.empty()) {
-        std::cout << "No frames to display" << std::endl;
-        return;
+// One line describing how frames are being shown
+std::string describeDisplaySettings(const DisplaySettings& settings) {
+    static const char* const PALETTE_NAMES[] = { "gray", "hot", "rainbow" };
+    std::ostringstream text;
+    text << "Display: level " << settings.level << ", window " << settings.window
+         << ", gamma " << settings.gamma << ", equalization " << (settings.equalize ? "on" : "off")
+         << ", palette " << PALETTE_NAMES[static_cast<int>(settings.palette)];
+    return text.str();
+}
+
+// The viewer window as a FrameViewer surface: created, pumped and drawn on
+// the viewer's present thread at the monitor's refresh rate. Keys change the
+// attached viewer's display settings, which re-renders the frame on show:
+//   H           equalization on/off
+//   C           next palette
+//   G           next gamma
+//   Up/Down     level up/down
+//   Left/Right  narrower/wider window
+//   R           back to the defaults
+class GdiSurface : public ViewerSurface {
+public:
+    // Set before the viewer is started
+    void Attach(FrameViewer* viewer) {
+        m_viewer = viewer;
     }
     
-    // Initialize the display window once
-    if (!g_displayInitialized) {
-        if (!InitializeDisplayWindow()) {
-            return;
-        }
+    bool Open() override {
+        return InitializeDisplayWindow();
     }
     
-    // Display frames with a 5 second delay between them
-    for (const auto& frame : frames) {
-        displayFrameImage(frame, frame.frameNumber);
-        
-        // Display each frame for 5 seconds as requested
-        std::cout << "Showing frame " << frame.frameNumber << " for 5 seconds..." << std::endl;
-        
-        // Handle window messages while waiting to ensure UI responsiveness
-        DWORD startTime = GetTickCount();
-        const DWORD displayTime = 5000; // 5 seconds in milliseconds (changed from 1000)
-        
-        while (GetTickCount() - startTime < displayTime) {
-            // Process window messages while waiting
-            MSG msg;
-            while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
-                TranslateMessage(&msg);
-                DispatchMessage(&msg);
-                
-                if (msg.message == WM_QUIT) {
-                    g_displayInitialized = false;
-                    break;
-                }
-            }
-            
-            if (!g_displayInitialized) break;
-            
-            // Short sleep to avoid maxing out CPU
-            Sleep(10);
-        }
-        
-        // Check if window was closed
-        if (!g_displayInitialized) {
-            break;
-        }
+    void Close() override {
+        CleanupDisplay();
     }
     
-    std::cout << "All " << frames.size() << " frames have been displayed" << std::endl;
-    std::cout << "Press Enter in the console to continue..." << std::endl;
-    std::cin.get(); // Wait for user to press Enter
-    
-    // Clean up display resources
-    CleanupDisplay();
-}
-
-// Modified extractFrames function
-std::vector<VideoFrame> extractFrames(
-    const std::vector<std::vector<bool>>& channels,
-    const std::vector<size_t>& savIndices,
-    const std::vector<size_t>& eavIndices,
-    const std::vector<size_t>& saviIndices,
-    const std::vector<size_t>& eaviIndices) {
-    
-    std::vector<VideoFrame> frames;
-    const size_t patternLen = 32;
-    const size_t NORMAL_LINE_GAP = 1776;  // Normal gap between SAV markers
-    const size_t FRAME_BOUNDARY_THRESHOLD = 2 * NORMAL_LINE_GAP;  // Threshold to detect frame boundaries
-    
-    // Add safety checks
-    if (channels.empty() || channels[0].empty()) {
-        std::cout << "Error: No channel data available" << std::endl;
-        return frames;
+    double RefreshHz() override {
+        HDC hdc = GetDC(g_displayWindow);
+        const int hz = GetDeviceCaps(hdc, VREFRESH);
+        ReleaseDC(g_displayWindow, hdc);
+        return hz > 1 ? hz : 60.0;  // 0 and 1 mean the hardware default
     }
     
-    // Create sorted copies of indices
-    std::vector<size_t> sortedSav = savIndices;
-    std::vector<size_t> sortedEav = eavIndices;
-    std::sort(sortedSav.begin(), sortedSav.end());
-    std::sort(sortedEav.begin(), sortedEav.end());
-    
-    // Initialize first frame
-    VideoFrame currentFrame;
-    currentFrame.frameNumber = 1;
-    
-    std::cout << "\nAnalyzing line spacing..." << std::endl;
-    
-    // Process SAV positions
-    for (size_t i = 0; i < sortedSav.size(); i++) {
-        size_t savPos = sortedSav[i];
-        
-        // Check if this is a frame boundary by looking at gap to next SAV
-        bool isFrameBoundary = false;
-        if (i < sortedSav.size() - 1) {
-            size_t gap = sortedSav[i + 1] - savPos;
-            if (gap > FRAME_BOUNDARY_THRESHOLD) {
-                std::cout << "Found frame boundary at SAV[" << i << "] - Gap: " << gap << " bits" << std::endl;
-                isFrameBoundary = true;
+    bool Poll() override {
+        MSG msg;
+        while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_KEYDOWN && m_viewer) {
+                handleKey(msg.wParam);
             }
-        }
-        
-        // Find corresponding EAV
-        auto eavIt = std::upper_bound(sortedEav.begin(), sortedEav.end(), savPos);
-        if (eavIt == sortedEav.end()) continue;
-        size_t eavPos = *eavIt;
-        
-        // Create and add line
-        VideoLine line;
-        line.startIndex = savPos;
-        line.endIndex = eavPos;
-        
-        // Extract data between SAV and EAV for each channel
-        std::vector<std::vector<uint8_t>> channelBytes(4);
-        
-        for (size_t ch = 0; ch < channels.size(); ch++) {
-            size_t start = savPos + patternLen;
-            size_t end = eavPos;
-            
-            if (start >= end || end > channels[ch].size()) continue;
             
-            // Convert bits to bytes - MODIFIED FOR LITTLE-ENDIAN
-            std::vector<uint8_t> bytes;
-            for (size_t pos = start; pos < end; pos += 8) {
-                if (pos + 8 > end) break;
-                
-                uint8_t byte = 0;
-                for (size_t bit = 0; bit < 8; bit++) {
-                    // Little-endian: least significant bit first
-                    // Use OR with shifted bit position instead of shifting the byte
-                    byte |= (channels[ch][pos + bit] ? 1 : 0) << bit;
-                }
-                channelBytes[ch].push_back(byte);
-            }
-            
-            // Add this after the bit-to-byte conversion loop to see sample values
-            if (ch == 0 && bytes.size() > 0 && bytes.size() % 100 == 0) {
-                std::cout << "Channel " << ch << " byte samples (little-endian): ";
-                for (int i = 0; i < std::min<size_t>(10, bytes.size()); i++) {
-                    std::cout << std::hex << std::setw(2) << std::setfill('0') 
-                              << static_cast<int>(bytes[i]) << " ";
-                }
-                std::cout << std::dec << std::endl;
-                
-                // Also calculate what the big-endian version would be for comparison
-                std::cout << "Same bytes if big-endian: ";
-                for (int i = 0; i < std::min<size_t>(10, bytes.size()); i++) {
-                    uint8_t bigEndianByte = 0;
-                    for (int bit = 0; bit < 8; bit++) {
-                        bigEndianByte = (bigEndianByte << 1) | ((bytes[i] >> bit) & 1);
-                    }
-                    std::cout << std::hex << std::setw(2) << std::setfill('0') 
-                              << static_cast<int>(bigEndianByte) << " ";
-                }
-                std::cout << std::dec << std::endl;
-            }
-        }
-        
-        // Now interleave the channels like in MATLAB
-        // First, determine the min length to ensure we don't go out of bounds
-        size_t minLength = SIZE_MAX;
-        for (const auto& chBytes : channelBytes) {
-            minLength = (chBytes.size() < minLength) ? chBytes.size() : minLength;
-        }
-        
-        if (minLength == 0) continue; // Skip if any channel has no data
-        
-        // Interleave the channels into a single vector
-        std::vector<uint8_t> interleavedData(minLength * 4);
-        for (size_t idx = 0; idx < minLength; idx++) {
-            for (size_t ch = 0; ch < 4; ch++) {
-                interleavedData[idx * 4 + ch] = channelBytes[ch][idx];
+            if (msg.message == WM_QUIT) {
+                g_displayInitialized = false;
+                break;
             }
-        }
-        
-        // Store the interleaved data in the line
-        line.channel1 = channelBytes[0]; // Keep individual channels for compatibility
-        line.channel2 = channelBytes[1];
-        line.channel3 = channelBytes[2];
-        line.channel4 = channelBytes[3];
-        line.interleavedData = interleavedData; // Add new field for interleaved data
-        
-        currentFrame.lines.push_back(line);
-        
-        // If this was a frame boundary, complete the current frame and start a new one
-        if (isFrameBoundary && !currentFrame.lines.empty()) {
-            frames.push_back(currentFrame);
-            std::cout << "Completed frame " << currentFrame.frameNumber 
-                      << " with " << currentFrame.lines.size() << " lines" << std::endl;
             
-            // Start new frame
-            currentFrame = VideoFrame();
-            currentFrame.frameNumber = frames.size() + 1;
-        }
-        
-        // Print progress less frequently
-        if (currentFrame.lines.size() % 1000 == 0) {
-            std::cout << "Current frame: Processed " << currentFrame.lines.size() << " lines" << std::endl;
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
         }
+        return g_displayInitialized;
     }
     
-    // Add last frame if it has any lines
-    if (!currentFrame.lines.empty()) {
-        frames.push_back(currentFrame);
+    void Present(const ViewerTexture& texture) override {
+        presentTexture(texture);
     }
-    
-    // Print detailed frame summary
-    std::cout << "\nDetailed Frame Summary:" << std::endl;
-    for (const auto& frame : frames) {
-        std::cout << "Frame " << frame.frameNumber << ": " << frame.lines.size() 
-                  << " lines (Start: " << frame.lines.front().startIndex 
-                  << ", End: " << frame.lines.back().endIndex 
-                  << ", First line length: " << (frame.lines.back().endIndex - frame.lines.front().startIndex)
-                  << " bits)" << std::endl;
-        
-        // Print the first few line gaps in this frame
-        if (!frame.lines.empty() && frame.lines.size() > 1) {
-            std::cout << "  First few line gaps in frame " << frame.frameNumber << ":" << std::endl;
-            for (size_t i = 0; i < std::min<size_t>(5, frame.lines.size() - 1); i++) {
-                size_t gap = frame.lines[i + 1].startIndex - frame.lines[i].startIndex;
-                std::cout << "    Line " << i << " to " << (i + 1) << ": " << gap << " bits" << std::endl;
+
+private:
+    void handleKey(WPARAM key) {
+        static const double GAMMAS[] = { 1.0, 1.5, 2.2, 0.6 };
+        DisplaySettings settings = m_viewer->Settings();
+        switch (key) {
+        case 'H':
+            settings.equalize = !settings.equalize;
+            break;
+        case 'C':
+            settings.palette = static_cast<DisplayPalette>((static_cast<int>(settings.palette) + 1) % 3);
+            break;
+        case 'G': {
+            size_t next = 0;
+            for (size_t i = 0; i < 4; i++) {
+                if (GAMMAS[i] == settings.gamma) {
+                    next = (i + 1) % 4;
+                }
             }
+            settings.gamma = GAMMAS[next];
+            break;
         }
+        case VK_UP:
+            settings.level = std::min<int>(settings.level + 8, 255);
+            break;
+        case VK_DOWN:
+            settings.level = std::max<int>(settings.level - 8, 0);
+            break;
+        case VK_LEFT:
+            settings.window = std::max<int>(settings.window - 16, 16);
+            break;
+        case VK_RIGHT:
+            settings.window = std::min<int>(settings.window + 16, 512);
+            break;
+        case 'R':
+            settings = DisplaySettings();
+            break;
+        default:
+            return;
+        }
+        m_viewer->SetSettings(settings);
+        std::cout << describeDisplaySettings(settings) << std::endl;
     }
-    
-    return frames;
-}
+
+    FrameViewer* m_viewer = nullptr;
+};
 
 // Modified analyzeData function to detect frame boundaries properly
 void analyzeData(bool quickAnalysis) {
@@ -991,30 +351,38 @@ void analyzeData(bool quickAnalysis) {
     std::vector<uint32_t> data(numElements);
     memcpy(data.data(), g_analysisBuffer.data(), g_analysisBuffer.size());
     
-    // Convert to bits
-    std::vector<uint8_t> rawBits = lookAtBits(data, false, "little", false, "uint32");
-    std::vector<bool> bits(rawBits.begin(), rawBits.end());
-    
-    // Create patterns for SAV and EAV
-    std::vector<bool> savPattern = createSAVPattern();
-    std::vector<bool> eavPattern = createEAVPattern();
+    // Turn the 4 bit-interleaved channels into display pixels, one byte per
+    // channel per input word (earliest bit in the MSB); every line is a
+    // slice of these
+    std::vector<uint8_t> pixels(numElements * 4);
+    InterleaveChannels(data.data(), numElements, pixels.data());
+    std::vector<uint8_t> channel0Bytes(numElements);
+    PickChannel(pixels.data(), numElements, 0, channel0Bytes.data());
     
     std::cout << "Searching for SAV/EAV patterns in channel 0 to determine frame structure..." << std::endl;
     
-    // Split the bits into 4 channels
-    std::vector<std::vector<bool>> channelBits(4);
-    for (size_t i = 0; i < bits.size(); i++) {
-        channelBits[i % 4].push_back(bits[i]);
-    }
-    
     // Search for patterns in only the first channel for efficiency
-    std::vector<size_t> savPositions = findPattern(channelBits[0], savPattern);
-    std::vector<size_t> eavPositions = findPattern(channelBits[0], eavPattern);
+    std::vector<SyncMark> marks;
+    SyncScanner scanner;
+    scanner.Feed(channel0Bytes.data(), channel0Bytes.size(), marks);
+    
+    std::vector<size_t> savPositions;
+    std::vector<size_t> eavPositions;
+    for (const SyncMark& mark : marks) {
+        if (mark.code == SyncCode::SAV) {
+            savPositions.push_back(static_cast<size_t>(mark.bit));
+        } else if (mark.code == SyncCode::EAV) {
+            eavPositions.push_back(static_cast<size_t>(mark.bit));
+        }
+    }
     
     std::cout << "Found " << savPositions.size() << " SAV markers in channel 0" << std::endl;
     std::cout << "Found " << eavPositions.size() << " EAV markers in channel 0" << std::endl;
     std::cout << "Using channel 0 markers for frame structure analysis..." << std::endl;
 
+    // Index of the EAV that ends each SAV's line, eavPositions.size() if none
+    const std::vector<size_t> eavAfterSav = FirstAfter(savPositions, eavPositions);
+
     // Analyze a sample of SAV/EAV pairs to get actual pixel counts
     if (!savPositions.empty() && !eavPositions.empty()) {
         std::cout << "\n=== Analyzing SAV/EAV Pixel Data ===\n" << std::endl;
@@ -1027,12 +395,10 @@ void analyzeData(bool quickAnalysis) {
         
         for (size_t i = 0; i < savPositions.size() && samplesFound < samplesToShow; i++) {
             // Find the corresponding EAV that comes after this SAV
-            auto eavIt = std::upper_bound(eavPositions.begin(), eavPositions.end(), savPositions[i]);
-            
-            if (eavIt != eavPositions.end()) {
+            if (eavAfterSav[i] < eavPositions.size()) {
                 // Calculate distance in bits and bytes
                 size_t savPos = savPositions[i];
-                size_t eavPos = *eavIt;
+                size_t eavPos = eavPositions[eavAfterSav[i]];
                 size_t distanceBits = eavPos - savPos;
                 size_t distanceBytes = (distanceBits - 64) / 8; // Subtract SAV/EAV markers (each 32 bits) and convert to bytes
                 
@@ -1059,9 +425,8 @@ void analyzeData(bool quickAnalysis) {
             size_t sampleLimit = std::min<size_t>(savPositions.size(), 50);
             
             for (size_t i = 0; i < sampleLimit; i++) {
-                auto eavIt = std::upper_bound(eavPositions.begin(), eavPositions.end(), savPositions[i]);
-                if (eavIt != eavPositions.end()) {
-                    size_t distanceBits = *eavIt - savPositions[i];
+                if (eavAfterSav[i] < eavPositions.size()) {
+                    size_t distanceBits = eavPositions[eavAfterSav[i]] - savPositions[i];
                     
                     // Only include reasonable distances
                     if (distanceBits > 100 && distanceBits < 5000) {
@@ -1140,9 +505,6 @@ void analyzeData(bool quickAnalysis) {
     std::cout << "\nDetected " << frameStartIndices.size() 
               << " potential frames in channel 0 data" << std::endl;
 
-    // Create frame(s) based on the detected boundaries
-    std::vector<VideoFrame> frames;
-
     // Add memory safety check
     size_t totalEstimatedLines = 0;
     for (size_t frameIdx = 0; frameIdx < frameStartIndices.size(); frameIdx++) {
@@ -1167,6 +529,19 @@ void analyzeData(bool quickAnalysis) {
     std::cout << "\nProcessing and displaying " << frameStartIndices.size() << " frames one at a time..." << std::endl;
     
     try {
+        // Frames go to the viewer through a small pool; the viewer shows
+        // each on its own thread while this one waits out FRAME_HOLD
+        const auto FRAME_HOLD = std::chrono::seconds(5);
+        FramePool framePool(2);
+        GdiSurface surface;
+        FrameViewer viewer(framePool, surface);
+        surface.Attach(&viewer);
+        if (!viewer.Start()) {
+            std::cout << "Failed to create display window" << std::endl;
+            return;
+        }
+        const size_t channelBitCount = numElements * 8;
+
         // Process each frame individually
         for (size_t frameIdx = 0; frameIdx < frameStartIndices.size(); frameIdx++) {
             size_t startIdx = frameStartIndices[frameIdx];
@@ -1176,10 +551,13 @@ void analyzeData(bool quickAnalysis) {
             int frameRows = static_cast<int>(endIdx - startIdx);
             std::cout << "Processing frame " << (frameIdx + 1) << " with " << frameRows << " rows" << std::endl;
             
-            // Create a single frame
-            VideoFrame frame;
-            frame.frameNumber = static_cast<int>(frameIdx + 1);
-            frame.lines.reserve(frameRows); // Reserve space but don't allocate yet
+            // Start the next frame
+            FrameBuffer* frame = framePool.Acquire();
+            if (!frame) {
+                break;  // Cannot happen with one producer and one viewer
+            }
+            frame->Reset(frameRows);
+            frame->SetFrameNumber(static_cast<int>(frameIdx + 1));
             
             // Process lines in smaller batches to avoid memory issues
             const size_t BATCH_SIZE = 100; // Process 100 lines at a time
@@ -1198,89 +576,59 @@ void analyzeData(bool quickAnalysis) {
                 for (size_t i = batchStart; i < batchEnd; i++) {
                     if (i >= savPositions.size()) break;
                     
-                    VideoLine line;
-                    line.startIndex = savPositions[i];
+                    LineView line;
+                    line.startBit = savPositions[i];
+                    line.newFrame = (i == startIdx);
                     
                     // Find corresponding EAV
-                    size_t eavIdx = 0;
-                    for (size_t j = 0; j < eavPositions.size(); j++) {
-                        if (eavPositions[j] > savPositions[i]) {
-                            eavIdx = j;
-                            break;
-                        }
-                    }
+                    const size_t eavIdx = eavAfterSav[i];
+                    line.hasEav = eavIdx < eavPositions.size();
                     
-                    if (eavIdx < eavPositions.size()) {
-                        line.endIndex = eavPositions[eavIdx];
+                    if (line.hasEav) {
+                        line.endBit = eavPositions[eavIdx];
                     } else {
                         // If no EAV found, use SAV + estimated active video width
-                        line.endIndex = savPositions[i] + 1456; // Using detected row width in bits
+                        line.endBit = savPositions[i] + 1456; // Using detected row width in bits
                     }
                     
-                    // Extract data directly from the deinterleaved channels
+                    // The payload stays in the interleaved capture; the
+                    // frame copies it from there straight into its row
                     size_t dataStartBit = savPositions[i] + 32;  // Skip SAV marker (32 bits)
-                    size_t dataEndBit = (eavIdx < eavPositions.size()) ? 
-                                       eavPositions[eavIdx] : (savPositions[i] + 1456);
+                    size_t dataEndBit = static_cast<size_t>(line.endBit);
+                    size_t bytes = dataEndBit > dataStartBit ? (dataEndBit - dataStartBit + 7) / 8 : 0;
                     
-                    // Initialize vectors for each channel's data with proper capacity
-                    size_t expectedBytes = (dataEndBit - dataStartBit + 7) / 8;
-                    line.channel1.reserve(expectedBytes);
-                    line.channel2.reserve(expectedBytes);
-                    line.channel3.reserve(expectedBytes);
-                    line.channel4.reserve(expectedBytes);
+                    // Only whole bytes inside the capture
+                    const size_t available = channelBitCount >= dataStartBit + 8 ?
+                                             (channelBitCount - dataStartBit) / 8 : 0;
+                    if (bytes > available) bytes = available;
                     
-                    // Extract data from each channel and convert bits to bytes
-                    for (size_t ch = 0; ch < channelBits.size(); ch++) {
-                        std::vector<uint8_t>* targetChannel = nullptr;
-                        switch (ch) {
-                            case 0: targetChannel = &line.channel1; break;
-                            case 1: targetChannel = &line.channel2; break;
-                            case 2: targetChannel = &line.channel3; break;
-                            case 3: targetChannel = &line.channel4; break;
-                            default: continue; // Shouldn't happen
-                        }
-                        
-                        // Convert bits to bytes
-                        for (size_t pos = dataStartBit; pos < dataEndBit; pos += 8) {
-                            if (pos + 8 > channelBits[ch].size()) break;
-                            
-                            uint8_t byte = 0;
-                            for (size_t bit = 0; bit < 8; bit++) {
-                                // Big-endian: most significant bit first
-                                byte |= (channelBits[ch][pos + bit] ? 1 : 0) << (7 - bit);
-                            }
-                            targetChannel->push_back(byte);
-                        }
-                    }
+                    line.pixels = pixels.data();
+                    line.payloadBit = dataStartBit;
+                    line.bytes = bytes;
                     
-                    frame.lines.push_back(line);
+                    frame->AppendLine(line);
                 }
             }
             
-            if (!frame.lines.empty()) {
-                std::cout << "Frame " << frameIdx + 1 << " has " << frame.lines.size() << " lines" << std::endl;
-                
-                // Create a special display function that only displays this one frame
-                std::cout << "Displaying frame " << frameIdx + 1 << "..." << std::endl;
-                
-                // Display this frame
-                std::vector<VideoFrame> singleFrame;
-                singleFrame.push_back(frame);
-                displayAllFrames(singleFrame);
-                
-                // Clear memory immediately
-                singleFrame.clear();
+            if (frame->Empty()) {
+                framePool.Discard(frame);
+                continue;
             }
+            std::cout << "Frame " << frameIdx + 1 << " has " << frame->Height() << " lines" << std::endl;
             
-            // Force cleanup of this frame's data before processing the next frame
-            frame.lines.clear();
-            frame.lines.shrink_to_fit();
-            
-            // Force a garbage collection to free memory before next frame
-            std::cout << "Memory cleared after frame " << frameIdx + 1 << std::endl;
+            // Display this frame
+            std::cout << "Showing frame " << frameIdx + 1 << " for 5 seconds..." << std::endl;
+            framePool.Publish(frame);
+            if (viewer.WaitForClose(FRAME_HOLD)) {
+                break;  // Window closed
+            }
         }
         
         std::cout << "All " << frameStartIndices.size() << " frames have been processed and displayed" << std::endl;
+        if (viewer.Running()) {
+            std::cout << "Close the viewer window to continue..." << std::endl;
+            viewer.WaitForClose();
+        }
         
     } catch (const std::exception& e) {
         std::cerr << "Error during frame processing: " << e.what() << std::endl;
@@ -1303,7 +651,7 @@ void watchdogThread() {
     const int MAX_INIT_SECONDS = 30;              // 30 seconds max for initialization
 
     int inactivityCounter = 0;
-    long lastBytesTransferred = 0;
+    long long lastBytesTransferred = 0;
     int lastStage = 0;
 
     // Get current time as initial progress time
@@ -1343,7 +691,7 @@ void watchdogThread() {
         }
         else if (currentStage == 2) {
             // In transfer stage, check bytes transferred
-            long currentBytes = g_totalBytesTransferred.load();
+            long long currentBytes = g_totalBytesTransferred.load();
 
             if (currentBytes > lastBytesTransferred) {
                 // Progress in data transfer
@@ -1409,41 +757,6 @@ void resetEndpoint() {
     }
 }
 
-// Helper function to create pattern with given code
-std::vector<bool> createPattern(const std::string& codeType) {
-    std::vector<bool> code1 = hexToBinaryVector("FF", 8);
-    std::vector<bool> code2 = hexToBinaryVector("00", 8);
-    std::vector<bool> code3 = hexToBinaryVector("00", 8);
-    std::vector<bool> code = getCode(codeType);
-    
-    std::vector<bool> pattern;
-    pattern.insert(pattern.end(), code1.begin(), code1.end());
-    pattern.insert(pattern.end(), code2.begin(), code2.end());
-    pattern.insert(pattern.end(), code3.begin(), code3.end());
-    pattern.insert(pattern.end(), code.begin(), code.end());
-    
-    return pattern;
-}
-
-// Helper function to create SAV pattern
-std::vector<bool> createSAVPattern() {
-    return createPattern("sav");
-}
-
-// Helper function to create EAV pattern
-std::vector<bool> createEAVPattern() {
-    return createPattern("eav");
-}
-
-// Add these helper functions
-std::vector<bool> createSAVIPattern() {
-    return createPattern("savi");
-}
-
-std::vector<bool> createEAVIPattern() {
-    return createPattern("eavi");
-}
-
 // Global variable to store GDI+ token
 ULONG_PTR g_gdiplusToken = 0;
 
@@ -1460,9 +773,226 @@ void ShutdownGDIPlus() {
     }
 }
 
-int main() {
+// Live mode: every acquisition buffer goes through the line parser as soon
+// as it completes and each frame goes to the viewer once its last line is
+// in, so the stream can run indefinitely instead of stopping at
+// ANALYSIS_BUFFER_SIZE.
+bool g_liveMode = false;
+LineParser g_lineParser;
+
+// Finished frames go through a fixed pool to the viewer, which shows them
+// from its own threads and always skips to the newest, so the parser never
+// waits for the window. A running stream allocates nothing: one frame is
+// being filled, one waits in the viewer's mailbox, one is being copied out.
+const int LIVE_POOL_FRAMES = 3;
+std::unique_ptr<FramePool> g_framePool;            // Created with the first buffer
+std::unique_ptr<FramePublisher> g_framePublisher;  // Lines go straight from the parser into its frames
+GdiSurface g_liveSurface;
+std::unique_ptr<FrameViewer> g_liveViewer;
+
+// Parse cost over the whole run, for the summary at the end
+double g_liveParseSeconds = 0.0;
+int g_liveBuffers = 0;
+
+// Transfers as both acquisition loops see them; the parser, frame pool and
+// viewer report to the same registry. Printed once a second and, with
+// --metrics <file>, exported as well.
+MetricCounter& g_usbCompletions = MetricsRegistry::Global().Counter("usb_completions_total", "Bulk transfers completed");
+MetricCounter& g_usbBytes = MetricsRegistry::Global().Counter("usb_bytes_total", "Bytes received over USB");
+MetricCounter& g_usbShortTransfers = MetricsRegistry::Global().Counter("usb_short_transfers_total", "Transfers ended early by a short packet");
+MetricCounter& g_usbFailedTransfers = MetricsRegistry::Global().Counter("usb_failed_transfers_total", "Transfers aborted or failed");
+MetricsReporter g_metricsReporter;
+std::chrono::steady_clock::time_point g_metricsLastReport = std::chrono::steady_clock::now();
+
+// Counts one finished transfer (0 bytes for a failed one) and prints the
+// metrics line when a second has passed
+void recordTransfer(size_t transferred) {
+    if (transferred == 0) {
+        g_usbFailedTransfers.Add();
+    } else {
+        g_usbCompletions.Add();
+        g_usbBytes.Add(transferred);
+        if (transferred < static_cast<size_t>(BUFFER_SIZE)) {
+            g_usbShortTransfers.Add();
+        }
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - g_metricsLastReport >= std::chrono::seconds(1)) {
+        std::cout << "Metrics: " << g_metricsReporter.Tick() << std::endl;
+        g_metricsLastReport = now;
+    }
+}
+
+bool liveViewClosed() {
+    return g_liveViewer && !g_liveViewer->Running();
+}
+
+// Sets up the pool and opens the viewer window on its own thread
+void startLiveView() {
+    g_framePool = std::make_unique<FramePool>(LIVE_POOL_FRAMES);
+    g_liveViewer = std::make_unique<FrameViewer>(*g_framePool, g_liveSurface);
+    g_liveSurface.Attach(g_liveViewer.get());
+    g_framePublisher = std::make_unique<FramePublisher>(*g_framePool);
+    if (!g_liveViewer->Start()) {
+        std::cout << "Failed to create display window" << std::endl;
+    }
+}
+
+// Parses one completed acquisition buffer. Returns false once the viewer
+// window has been closed.
+bool processLiveBuffer(const unsigned char* data, size_t bytes) {
+    auto start = std::chrono::steady_clock::now();
+    if (g_liveBuffers == 0) {
+        startLiveView();
+    }
+
+    g_lineParser.Feed(reinterpret_cast<const uint32_t*>(data), bytes / sizeof(uint32_t), *g_framePublisher);
+    g_liveParseSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    g_liveBuffers++;
+
+    return !liveViewClosed();
+}
+
+// End of the stream: show whatever the parser still holds, and keep it on
+// screen until the window is closed
+void finishLiveView() {
+    if (!g_framePool) {
+        return;  // No buffer ever arrived
+    }
+    g_lineParser.Flush(*g_framePublisher);
+    g_framePublisher->Finish();
+    if (g_liveViewer->Running()) {
+        std::cout << "Stream ended. Close the viewer window to exit..." << std::endl;
+        g_liveViewer->WaitForClose();
+    }
+    g_liveViewer->Stop();
+
+    const LineParserStats& stats = g_lineParser.Stats();
+    const FrameViewerStats view = g_liveViewer->Stats();
+    std::cout << "Live view: " << stats.lines << " lines (" << stats.linesWithoutEav << " without EAV), "
+              << stats.frames << " frames, " << view.produced << " produced, " << view.presented
+              << " presented" << std::endl;
+    const FramePoolStats poolStats = g_framePool->Stats();
+    std::cout << "Frame pool: " << poolStats.published << " published, " << poolStats.starved
+              << " lost waiting for a free frame (" << g_framePublisher->LostLines() << " lines)" << std::endl;
+    for (const FrameConsumerStats& consumer : poolStats.consumers) {
+        std::cout << "  " << consumer.name << ": " << consumer.delivered << " taken, "
+                  << consumer.dropped << " dropped" << std::endl;
+    }
+    if (g_liveBuffers > 0) {
+        std::cout << "Parse cost: " << (g_liveParseSeconds * 1e6 / g_liveBuffers) << " us per buffer over "
+                  << g_liveBuffers << " buffers" << std::endl;
+    }
+}
+
+// Offline mode: plays a saved capture through the same NUM_BUFFERS x BUFFER_SIZE
+// ring the FX3 loop uses and fills g_analysisBuffer from it, so analyzeData
+// can be run (and timed) without a device. In live mode the buffers go to
+// the line parser instead, until the capture ends or the viewer is closed.
+bool replayCapture(const std::string& path, double bytesPerSecond, bool loop) {
+    ReplayConfig config;
+    config.bytesPerSecond = bytesPerSecond;
+    config.loop = loop;
+
+    FileReplayTransport transport(path, config);
+    if (!transport.Open() || !transport.Configure(NUM_BUFFERS, BUFFER_SIZE)) {
+        std::cerr << "Failed to set up replay of " << path << std::endl;
+        return false;
+    }
+
+    std::vector<std::vector<unsigned char>> buffers(NUM_BUFFERS, std::vector<unsigned char>(BUFFER_SIZE));
+    g_analysisBuffer.reserve(ANALYSIS_BUFFER_SIZE);
+
+    for (int i = 0; i < NUM_BUFFERS; i++) {
+        transport.Submit(i, buffers[i].data(), BUFFER_SIZE);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int currentBuffer = 0;
+    size_t replayedBytes = 0;
+    while (g_liveMode || g_analysisBuffer.size() < ANALYSIS_BUFFER_SIZE) {
+        size_t transferred = 0;
+        if (transport.Reap(currentBuffer, FX3_BUFFER_TIMEOUT, transferred) != TransferStatus::Completed) {
+            break;  // End of the capture
+        }
+        recordTransfer(transferred);
+
+        size_t bytesToWrite = (transferred & ~size_t(0x3));  // Align to 4-byte boundary
+        replayedBytes += bytesToWrite;
+        if (g_liveMode) {
+            if (!processLiveBuffer(buffers[currentBuffer].data(), bytesToWrite)) {
+                break;  // Viewer closed
+            }
+        } else {
+            g_analysisBuffer.insert(g_analysisBuffer.end(),
+                                    buffers[currentBuffer].begin(),
+                                    buffers[currentBuffer].begin() + bytesToWrite);
+        }
+
+        transport.Submit(currentBuffer, buffers[currentBuffer].data(), BUFFER_SIZE);
+        currentBuffer = (currentBuffer + 1) % NUM_BUFFERS;
+    }
+    transport.Abort();
+    if (g_liveMode) {
+        finishLiveView();
+    }
+
+    double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double megabytes = replayedBytes / (1024.0 * 1024.0);
+    std::cout << "Replayed " << megabytes << " MB in " << elapsedSec << " seconds ("
+              << (elapsedSec > 0 ? megabytes / elapsedSec : 0.0) << " MB/s)" << std::endl;
+
+    return replayedBytes > 0;
+}
+
+int main(int argc, char* argv[]) {
     std::cout << "Starting program..." << std::endl;
 
+    // stream0 --replay <file.bin> [--rate <MB/s>] [--loop]
+    // Skips the FX3 entirely and analyzes a saved capture instead.
+    // stream0 [--replay ...] --live
+    // Parses and shows frames while the data arrives instead of analyzing
+    // a 2 MB snapshot afterwards; runs until the viewer window is closed.
+    // stream0 ... --metrics <file>
+    // Exports the once-a-second metrics too: Prometheus text for a .prom
+    // file, JSON lines otherwise.
+    std::string replayPath;
+    double replayRate = 0.0;  // Unthrottled
+    bool replayLoop = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "--rate" && i + 1 < argc) {
+            replayRate = std::stod(argv[++i]) * 1024 * 1024;
+        } else if (arg == "--loop") {
+            replayLoop = true;
+        } else if (arg == "--live") {
+            g_liveMode = true;
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            if (!g_metricsReporter.SetExport(argv[++i])) {
+                return -1;
+            }
+        }
+    }
+
+    if (!replayPath.empty()) {
+        if (!replayCapture(replayPath, replayRate, replayLoop)) {
+            return -1;
+        }
+        if (g_liveMode) {
+            return 0;
+        }
+        try {
+            analyzeData(false);
+        } catch (const std::exception& e) {
+            std::cerr << "Error during data analysis: " << e.what() << std::endl;
+            return -1;
+        }
+        return 0;
+    }
+
     // Start watchdog thread
     std::thread watchdog(watchdogThread);
     watchdog.detach();  // Detach so it can run independently
@@ -1597,7 +1127,7 @@ int main() {
         updateProgress();
 
         std::cout << "Starting data reception..." << std::endl;
-        long totalTransferred = 0;
+        long long totalTransferred = 0;
         int currentBuffer = 0;
         long bytesToTransfer = BUFFER_SIZE;
 
@@ -1609,12 +1139,9 @@ int main() {
         g_watchdogActive.store(true);
 
         // Performance tracking
-        LARGE_INTEGER perfFreq, perfStart, perfNow;
+        LARGE_INTEGER perfFreq, perfStart;
         QueryPerformanceFrequency(&perfFreq);
         QueryPerformanceCounter(&perfStart);
-        QueryPerformanceCounter(&perfNow); // Initialize perfNow to avoid uninitialized variable
-        long long bytesThisInterval = 0;
-        int buffersThisInterval = 0;
 
         // Adaptive timeout
         DWORD currentTimeout = FX3_BUFFER_TIMEOUT;
@@ -1647,7 +1174,7 @@ int main() {
         currentBuffer = 0;
 
         // Single acquisition loop
-        while (g_analysisBuffer.size() < ANALYSIS_BUFFER_SIZE) {
+        while (g_liveMode || g_analysisBuffer.size() < ANALYSIS_BUFFER_SIZE) {
             // Process buffer as before...
             // Wait for current buffer with adaptive timeout
             DWORD waitResult = WaitForSingleObject(ovLapArray[currentBuffer].hEvent, currentTimeout);
@@ -1663,6 +1190,7 @@ int main() {
             
             // Make sure we declare this variable properly
             LONG transferred = static_cast<LONG>(bytesXferred);
+            recordTransfer(transferred > 0 ? static_cast<size_t>(transferred) : 0);
             
             if (transferred > 0) {
                 bufferCycleCount++;
@@ -1673,6 +1201,16 @@ int main() {
                         flushComplete = true;
                         std::cout << "Flush complete. Starting data collection..." << std::endl;
                     }
+                } else if (g_liveMode) {
+                    // Parse before the buffer is handed back to the driver
+                    long bytesToWrite = (transferred & ~0x3);  // Align to 4-byte boundary
+                    totalTransferred += bytesToWrite;
+                    g_totalBytesTransferred.store(totalTransferred);
+
+                    if (!processLiveBuffer(buffers[currentBuffer], static_cast<size_t>(bytesToWrite))) {
+                        std::cout << "Viewer closed. Stopping data collection." << std::endl;
+                        break;  // Exit the transfer loop
+                    }
                 } else {
                     // Save data only after flush phase
                 long bytesToWrite = (transferred & ~0x3);  // Align to 4-byte boundary
@@ -1811,6 +1349,11 @@ int main() {
         std::cout << "Data is now stored in memory buffer for analysis. Buffer size: " 
             << g_analysisBuffer.size() << " bytes." << std::endl;
             
+        if (g_liveMode) {
+            finishLiveView();
+            return 0;
+        }
+
         // Analyze the collected data
         try {
             bool quickAnalysis = false; // Set to false to do full analysis as requested
@@ -11,58 +11,16 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
-#include <algorithm>    // for std::search, std::set_intersection
+#include <algorithm>    // for std::min
 #include <windows.h>
 #include "CyAPI.h"
 #include <string>
+#include "SyncCodes.h"   // from stream2_mt
 
  // -----------------------------------------------------------------------------
  // Utility functions that mimic MATLAB behavior
  // -----------------------------------------------------------------------------
 
- // Convert a hex string (e.g. "9D") into an 8-bit binary vector [1,0,0,1,1,1,0,1] or similar.
-std::vector<uint8_t> hexToBinaryVector(const std::string& hexStr, int totalBits = 8)
-{
-    // Convert hex to integer
-    unsigned int val = std::stoul(hexStr, nullptr, 16);
-
-    // Convert integer to binary vector
-    std::vector<uint8_t> bits(totalBits, 0);
-    for (int i = 0; i < totalBits; ++i)
-    {
-        // Extract bit i.  If we want the MSB first, we read from the top bit down.
-        // For simplicity, let's assume the leftmost bit is the MSB:
-        // bit i (MSB first) = (val >> (totalBits - 1 - i)) & 1
-        // bit i (LSB first) = (val >> i) & 1
-        // Because your MATLAB code sets 'endianness' = 'little' for the raw data,
-        // the "sync codes" themselves in typical SDI are still often shown MSB-first.
-        // Well assume MSB-first for the code pattern:
-        bits[i] = static_cast<uint8_t>((val >> (totalBits - 1 - i)) & 0x1);
-    }
-    return bits;
-}
-
-// A convenience function that returns the 8-bit sync code pattern.
-std::vector<uint8_t> getCode(const std::string& syncCode)
-{
-    //  In MATLAB:
-    //    case 'sav'  -> hexToBinaryVector('80',8);
-    //    case 'eav'  -> hexToBinaryVector('9D',8);
-    //    case 'savi' -> hexToBinaryVector('AB',8);
-    //    case 'eavi' -> hexToBinaryVector('B6',8);
-    if (syncCode == "sav")
-        return hexToBinaryVector("80", 8);
-    else if (syncCode == "eav")
-        return hexToBinaryVector("9D", 8);
-    else if (syncCode == "savi")
-        return hexToBinaryVector("AB", 8);
-    else if (syncCode == "eavi")
-        return hexToBinaryVector("B6", 8);
-
-    // Default empty
-    return std::vector<uint8_t>();
-}
-
 // Convert each element in `data` to a row of bits (vector of 0s/1s).
 // This mimics your `lookAtBits` function.  By default, we assume 16 bits per pixel
 // in little-endian order.  If you need 8-bit data or big-endian, adjust accordingly.
@@ -126,28 +84,37 @@ std::vector<uint8_t> lookAtBits_8(const std::vector<uint8_t>& data, bool littleE
     return bitStream;
 }
 
-// Find all occurrences of `pattern` in `bitStream` (similar to MATLAB's strfind).
-// Return the starting indices (0-based).
-std::vector<size_t> findPattern(const std::vector<uint8_t>& bitStream,
-    const std::vector<uint8_t>& pattern)
+// Find every sync word in `bitStream` (one bit per element, in stream order),
+// like MATLAB's strfind on [code1, code2, code3, getCode(...)] for all four codes
+// at once.  Codes fixes the preamble and code values at compile time, so each bit
+// is one shift into a register and one compare against constants.
+// Fills the 0-based starting indices, ascending.
+template <typename Codes>
+void findSyncWords(const std::vector<uint8_t>& bitStream,
+    std::vector<size_t>& idxSav,
+    std::vector<size_t>& idxSavi,
+    std::vector<size_t>& idxEav,
+    std::vector<size_t>& idxEavi)
 {
-    std::vector<size_t> indices;
-    if (pattern.empty() || bitStream.empty()) return indices;
+    using Words = SyncWords<Codes>;
 
-    // We'll do a naive search using std::search
-    auto it = bitStream.begin();
-    while (true)
+    uint64_t window = 0;
+    for (size_t i = 0; i < bitStream.size(); ++i)
     {
-        it = std::search(it, bitStream.end(), pattern.begin(), pattern.end());
-        if (it == bitStream.end()) break;
+        window = (window << 1) | (bitStream[i] & 1);
+        SyncCode code;
+        if (i + 1 < Words::BITS || !Words::Match(window, code))
+            continue;
 
-        // Found an occurrence
-        size_t pos = std::distance(bitStream.begin(), it);
-        indices.push_back(pos);
-        ++it; // move past this match to look for the next
+        const size_t start = i + 1 - Words::BITS;
+        switch (code)
+        {
+        case SyncCode::SAV:  idxSav.push_back(start); break;
+        case SyncCode::SAVI: idxSavi.push_back(start); break;
+        case SyncCode::EAV:  idxEav.push_back(start); break;
+        case SyncCode::EAVI: idxEavi.push_back(start); break;
+        }
     }
-
-    return indices;
 }
 
 // Intersection of two sorted vectors (similar to MATLAB's intersect).
@@ -372,44 +339,6 @@ int main()
     // Convert to bitstream (16 bits each, little-endian)
     std::vector<uint8_t> bitStream = lookAtBits_16(collectedData, /*littleEndian=*/true);
 
-    // Define the "global" 24-bit prefix from your MATLAB code: 0xFF, 0x00, 0x00 (MSB-first).
-    // In your MATLAB: 
-    //   code1 = hexToBinaryVector('FF',8);
-    //   code2 = hexToBinaryVector('00',8);
-    //   code3 = hexToBinaryVector('00',8);
-    //   patternStartValid   = [code1, code2, code3, getCode('sav')];
-    // We will build these as a single pattern vector:
-    std::vector<uint8_t> code1 = hexToBinaryVector("FF", 8);  // [1,1,1,1,1,1,1,1]
-    std::vector<uint8_t> code2 = hexToBinaryVector("00", 8);  // [0,0,0,0,0,0,0,0]
-    std::vector<uint8_t> code3 = hexToBinaryVector("00", 8);  // [0,0,0,0,0,0,0,0]
-
-    // Build patterns
-    auto sav = getCode("sav");   // hexToBinaryVector("80")
-    auto savi = getCode("savi");  // hexToBinaryVector("AB")
-    auto eav = getCode("eav");   // hexToBinaryVector("9D")
-    auto eavi = getCode("eavi");  // hexToBinaryVector("B6")
-
-    // Concatenate them, e.g. patternStartValid = [code1, code2, code3, sav]
-    auto patternStartValid = code1;
-    patternStartValid.insert(patternStartValid.end(), code2.begin(), code2.end());
-    patternStartValid.insert(patternStartValid.end(), code3.begin(), code3.end());
-    patternStartValid.insert(patternStartValid.end(), sav.begin(), sav.end());
-
-    auto patternStartInvalid = code1;
-    patternStartInvalid.insert(patternStartInvalid.end(), code2.begin(), code2.end());
-    patternStartInvalid.insert(patternStartInvalid.end(), code3.begin(), code3.end());
-    patternStartInvalid.insert(patternStartInvalid.end(), savi.begin(), savi.end());
-
-    auto patternEndValid = code1;
-    patternEndValid.insert(patternEndValid.end(), code2.begin(), code2.end());
-    patternEndValid.insert(patternEndValid.end(), code3.begin(), code3.end());
-    patternEndValid.insert(patternEndValid.end(), eav.begin(), eav.end());
-
-    auto patternEndInvalid = code1;
-    patternEndInvalid.insert(patternEndInvalid.end(), code2.begin(), code2.end());
-    patternEndInvalid.insert(patternEndInvalid.end(), code3.begin(), code3.end());
-    patternEndInvalid.insert(patternEndInvalid.end(), eavi.begin(), eavi.end());
-
     // For your MATLAB code, you do this pattern detection on "bits1" and "bits2".
     // That implies youre de-interleaving or you have two separate channels.
     // For brevity, lets assume we only have one channel in this example:
@@ -417,10 +346,10 @@ int main()
     // --- For demonstration, we do single-channel "bitStream" only:
 
     // 3) Find occurrences
-    auto idxSav = findPattern(bitStream, patternStartValid);
-    auto idxSavi = findPattern(bitStream, patternStartInvalid);
-    auto idxEav = findPattern(bitStream, patternEndValid);
-    auto idxEavi = findPattern(bitStream, patternEndInvalid);
+    //    The patterns are the MATLAB ones, [FF 00 00 code] MSB-first:
+    //    sav = 80, savi = AB, eav = 9D, eavi = B6 (see SyncCodes.h)
+    std::vector<size_t> idxSav, idxSavi, idxEav, idxEavi;
+    findSyncWords<Bt656SyncCodes>(bitStream, idxSav, idxSavi, idxEav, idxEavi);
 
     // Just print how many we found
     std::cout << "Start valid (sav) patterns found: " << idxSav.size() << std::endl;
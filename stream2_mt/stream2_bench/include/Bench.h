@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Shared helpers for the stream2_bench suites. Every suite is a plain
+// function that prints one "suite/case: value unit" line per measurement.
+
+using BenchClock = std::chrono::steady_clock;
+
+inline double SecondsSince(BenchClock::time_point start) {
+    return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+// CPU time consumed so far by the calling thread.
+inline double ThreadCpuSeconds() {
+#ifdef _WIN32
+    FILETIME creation, exitTime, kernel, user;
+    GetThreadTimes(GetCurrentThread(), &creation, &exitTime, &kernel, &user);
+    auto toSeconds = [](const FILETIME& ft) {
+        ULARGE_INTEGER v;
+        v.LowPart = ft.dwLowDateTime;
+        v.HighPart = ft.dwHighDateTime;
+        return static_cast<double>(v.QuadPart) * 100e-9;
+    };
+    return toSeconds(kernel) + toSeconds(user);
+#else
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) * 1e-9;
+#endif
+}
+
+// Suites
+int RunHandoffBench(int argc, char** argv);
+int RunIdleWriterBench(int argc, char** argv);
+int RunSinkBench(int argc, char** argv);
+int RunCaptureBench(int argc, char** argv);
+int RunDeinterleaveBench(int argc, char** argv);
+int RunLineParserBench(int argc, char** argv);
+int RunScanBench(int argc, char** argv);
+int RunPairingBench(int argc, char** argv);
+int RunFrameBench(int argc, char** argv);
+int RunFramePoolBench(int argc, char** argv);
+int RunRowBench(int argc, char** argv);
+int RunViewerBench(int argc, char** argv);
+int RunClaheBench(int argc, char** argv);
+int RunDisplayBench(int argc, char** argv);
+int RunMetricsBench(int argc, char** argv);
+int RunTransportBench(int argc, char** argv);
+int RunCapturesBench(int argc, char** argv);
+int RunSoakBench(int argc, char** argv);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// One "suite/case: value unit" measurement
+struct BenchResult {
+    std::string name;
+    double value = 0.0;
+    std::string unit;
+};
+
+// Reads a suite's output line as a result; false for anything else
+// (messages such as "soak: no frame reached the surface")
+bool ParseBenchLine(const std::string& line, BenchResult& result);
+
+// Passes everything written through it on unchanged and keeps every result
+// line, so suites keep printing to std::cout and need not know about it
+class BenchRecorder : public std::streambuf {
+public:
+    explicit BenchRecorder(std::streambuf* out) : m_out(out) {}
+
+    const std::vector<BenchResult>& Results() const { return m_results; }
+
+protected:
+    int overflow(int c) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+    int sync() override;
+
+private:
+    void Append(const char* s, size_t n);
+
+    std::streambuf* m_out;
+    std::string m_line;
+    std::vector<BenchResult> m_results;
+};
+
+// Results file: a version header, then one tab-separated name, value and
+// unit per line in the order the suites ran. The format only changes
+// together with the header, so files from any two commits compare.
+bool WriteBenchResults(const std::string& path, const std::vector<BenchResult>& results);
+bool ReadBenchResults(const std::string& path, std::vector<BenchResult>& results);
+
+// Prints every result against the baseline's and returns how many got worse
+// by more than tolerance percent or are missing from a suite that ran. Rates
+// count as worse when they drop, times when they grow; counts are shown but
+// never judged.
+int CompareBenchResults(const std::vector<BenchResult>& baseline, const std::vector<BenchResult>& current,
+                        double tolerance, std::ostream& out);
@@ -0,0 +1,125 @@
+#include "../include/Bench.h"
+#include "../include/BenchResults.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Suite {
+    const char* name;
+    int (*run)(int argc, char** argv);
+    const char* description;
+    bool capture = false;  // Takes capture files as its arguments, --capture if none given
+};
+
+const Suite kSuites[] = {
+    { "handoff", RunHandoffBench, "BufferManager reader->writer handoffs per second" },
+    { "idle", RunIdleWriterBench, "Disk writer CPU use on an idle stream and wake-up latency" },
+    { "sink", RunSinkBench, "Disk writers on their own: sustained MB/s and submit latency" },
+    { "capture", RunCaptureBench, "Simulated FX3 capture to disk with each disk writer" },
+    { "deinterleave", RunDeinterleaveBench, "Splitting a capture into its four channels: legacy loop vs kernels", true },
+    { "lineparser", RunLineParserBench, "Streaming SAV/EAV line parser cost per acquisition buffer" },
+    { "scan", RunScanBench, "Offline capture parse on 1..N threads, checked against the streaming parser" },
+    { "pairing", RunPairingBench, "SAV/EAV pairing merges vs the quadratic Vis0 loops, per line" },
+    { "frame", RunFrameBench, "Frame assembly: per-line vectors vs a flat FrameBuffer filled by the parser" },
+    { "framepool", RunFramePoolBench, "Frame pool with a slow display and fast consumers: rate and drops" },
+    { "row", RunRowBench, "Display rows from capture words: legacy bit loops vs interleave and CutRow" },
+    { "viewer", RunViewerBench, "Frame viewer on its own thread: producer hand-off cost, produced vs presented fps" },
+    { "clahe", RunClaheBench, "Tiled histogram equalization of a 712 x 480 frame: legacy vs ClaheEngine on 1..N threads" },
+    { "display", RunDisplayBench, "Display pipeline: cached stages on setting changes, and viewer re-render latency on a toggle" },
+    { "metrics", RunMetricsBench, "Metrics registry: ns per counter/gauge/histogram update on 1..N threads, snapshot and exports" },
+    { "transport", RunTransportBench, "Raw submit/reap rate of the FX3 simulator and file replay, nothing behind them" },
+    { "captures", RunCapturesBench, "Sync scan, deinterleave and frame assembly MB/s on real captures", true },
+    { "soak", RunSoakBench, "Whole live path at a set wire rate: simulator, parser, frame pool and viewer, with drops" },
+};
+
+void PrintUsage() {
+    std::cout << "Usage: stream2_bench [options] [suite] [suite options]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --out <file>        Save the results, to compare a later run against" << std::endl;
+    std::cout << "  --baseline <file>   Compare the results with a saved run" << std::endl;
+    std::cout << "  --tolerance <%>     Change tolerated before a result counts as worse (default 10)" << std::endl;
+    std::cout << "  --capture <file>    Capture for the suites that read one, unless given their own" << std::endl;
+    std::cout << "Suites:" << std::endl;
+    for (const auto& suite : kSuites) {
+        std::cout << "  " << suite.name << " - " << suite.description << std::endl;
+    }
+}
+
+int RunSuite(const Suite& suite, int argc, char** argv, char* capture) {
+    if (suite.capture && argc == 0 && capture) {
+        return suite.run(1, &capture);
+    }
+    return suite.run(argc, argv);
+}
+
+// Runs the named suite, or every suite with default options
+int RunSuites(int argc, char** argv, char* capture) {
+    if (argc < 1) {
+        int result = 0;
+        for (const auto& suite : kSuites) {
+            result |= RunSuite(suite, 0, nullptr, capture);
+        }
+        return result;
+    }
+
+    for (const auto& suite : kSuites) {
+        if (std::strcmp(argv[0], suite.name) == 0) {
+            return RunSuite(suite, argc - 1, argv + 1, capture);
+        }
+    }
+
+    PrintUsage();
+    return -1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string outPath;
+    std::string baselinePath;
+    double tolerance = 10.0;
+    char* capture = nullptr;
+    int first = 1;
+    while (first + 1 < argc && std::strncmp(argv[first], "--", 2) == 0) {
+        if (std::strcmp(argv[first], "--out") == 0) {
+            outPath = argv[first + 1];
+        } else if (std::strcmp(argv[first], "--baseline") == 0) {
+            baselinePath = argv[first + 1];
+        } else if (std::strcmp(argv[first], "--tolerance") == 0) {
+            tolerance = std::atof(argv[first + 1]);
+        } else if (std::strcmp(argv[first], "--capture") == 0) {
+            capture = argv[first + 1];
+        } else {
+            break;
+        }
+        first += 2;
+    }
+
+    // Load the baseline first so a bad path fails before a long run
+    std::vector<BenchResult> baseline;
+    if (!baselinePath.empty() && !ReadBenchResults(baselinePath, baseline)) {
+        return EXIT_FAILURE;
+    }
+
+    BenchRecorder recorder(std::cout.rdbuf());
+    std::streambuf* coutBuffer = std::cout.rdbuf(&recorder);
+    int result = RunSuites(argc - first, argv + first, capture);
+    std::cout.rdbuf(coutBuffer);
+
+    if (!outPath.empty() && !WriteBenchResults(outPath, recorder.Results())) {
+        result = -1;
+    }
+    if (!baselinePath.empty()) {
+        std::cout << "Against " << baselinePath << ":" << std::endl;
+        if (CompareBenchResults(baseline, recorder.Results(), tolerance, std::cout) > 0) {
+            result = -1;
+        }
+    }
+    // Suites fail with -1, which Windows would report as a negative exit code
+    // that "if errorlevel 1" takes for success
+    return (result == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,207 @@
+#include "../include/BenchResults.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+
+namespace {
+
+const char* const kResultsHeader = "# stream2_bench results 1";
+
+enum class Better { Higher, Lower, Neither };
+
+bool StartsWith(const std::string& text, const char* prefix) {
+    return text.compare(0, std::char_traits<char>::length(prefix), prefix) == 0;
+}
+
+bool EndsWith(const std::string& text, const char* suffix) {
+    const size_t length = std::char_traits<char>::length(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+// Which way a unit improves: rates and speedups up, times and CPU use down
+Better BetterWay(const std::string& unit) {
+    if (EndsWith(unit, "/s") || unit == "fps" || unit == "x") {
+        return Better::Higher;
+    }
+    if (unit == "ns" || unit == "us" || unit == "ms" || unit == "s" || unit == "%" ||
+        StartsWith(unit, "ns/") || StartsWith(unit, "us/") || StartsWith(unit, "ms/")) {
+        return Better::Lower;
+    }
+    return Better::Neither;
+}
+
+} // namespace
+
+bool ParseBenchLine(const std::string& line, BenchResult& result) {
+    const size_t colon = line.find(": ");
+    if (colon == std::string::npos || colon == 0) {
+        return false;
+    }
+    const std::string name = line.substr(0, colon);
+    if (name.find('/') == std::string::npos || name.find_first_of(" \t") != std::string::npos) {
+        return false;
+    }
+
+    const char* text = line.c_str() + colon + 2;
+    char* end = nullptr;
+    const double value = std::strtod(text, &end);
+    if (end == text || (*end != '\0' && *end != ' ')) {
+        return false;
+    }
+    std::string unit = (*end == ' ') ? std::string(end + 1) : std::string();
+    while (!unit.empty() && (unit.back() == ' ' || unit.back() == '\r')) {
+        unit.pop_back();
+    }
+
+    result.name = name;
+    result.value = value;
+    result.unit = unit;
+    return true;
+}
+
+int BenchRecorder::overflow(int c) {
+    if (c == traits_type::eof()) {
+        return traits_type::not_eof(c);
+    }
+    const char ch = traits_type::to_char_type(c);
+    Append(&ch, 1);
+    return m_out->sputc(ch);
+}
+
+std::streamsize BenchRecorder::xsputn(const char* s, std::streamsize n) {
+    Append(s, static_cast<size_t>(n));
+    return m_out->sputn(s, n);
+}
+
+int BenchRecorder::sync() {
+    return m_out->pubsync();
+}
+
+void BenchRecorder::Append(const char* s, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (s[i] != '\n') {
+            m_line += s[i];
+            continue;
+        }
+        BenchResult result;
+        if (ParseBenchLine(m_line, result)) {
+            m_results.push_back(result);
+        }
+        m_line.clear();
+    }
+}
+
+bool WriteBenchResults(const std::string& path, const std::vector<BenchResult>& results) {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to create results file " << path << std::endl;
+        return false;
+    }
+    file.precision(6);
+    file << kResultsHeader << "\n";
+    for (const BenchResult& result : results) {
+        file << result.name << "\t" << result.value << "\t" << result.unit << "\n";
+    }
+    file.flush();
+    if (!file) {
+        std::cerr << "Failed to write results file " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ReadBenchResults(const std::string& path, std::vector<BenchResult>& results) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open results file " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    if (!std::getline(file, line) || line != kResultsHeader) {
+        std::cerr << path << " is not a stream2_bench results file" << std::endl;
+        return false;
+    }
+
+    results.clear();
+    while (std::getline(file, line)) {
+        const size_t nameEnd = line.find('\t');
+        const size_t valueEnd = (nameEnd == std::string::npos) ? nameEnd : line.find('\t', nameEnd + 1);
+        if (valueEnd == std::string::npos) {
+            continue;
+        }
+        BenchResult result;
+        result.name = line.substr(0, nameEnd);
+        result.value = std::strtod(line.c_str() + nameEnd + 1, nullptr);
+        result.unit = line.substr(valueEnd + 1);
+        results.push_back(result);
+    }
+    return true;
+}
+
+int CompareBenchResults(const std::vector<BenchResult>& baseline, const std::vector<BenchResult>& current,
+                        double tolerance, std::ostream& out) {
+    // A case that ran more than once is compared on its last run
+    std::map<std::string, const BenchResult*> before;
+    for (const BenchResult& result : baseline) {
+        before[result.name] = &result;
+    }
+
+    std::ostringstream line;
+    line.setf(std::ios::fixed);
+    int worse = 0;
+    size_t compared = 0;
+    std::set<std::string> seen;
+    for (const BenchResult& result : current) {
+        seen.insert(result.name);
+        const auto it = before.find(result.name);
+        if (it == before.end()) {
+            out << result.name << ": " << result.value << " " << result.unit << " (new)" << std::endl;
+            continue;
+        }
+        const BenchResult& old = *it->second;
+        ++compared;
+        out << result.name << ": " << old.value << " -> " << result.value << " " << result.unit;
+
+        const Better better = BetterWay(result.unit);
+        bool regressed = false;
+        if (old.value != 0.0) {
+            const double change = (result.value - old.value) / std::fabs(old.value) * 100.0;
+            line.str("");
+            line.precision(1);
+            line << (change >= 0.0 ? "+" : "") << change << "%";
+            out << " (" << line.str() << ")";
+            regressed = (better == Better::Higher && change < -tolerance) ||
+                        (better == Better::Lower && change > tolerance);
+        } else {
+            regressed = better == Better::Lower && result.value > 0.0;
+        }
+        if (regressed) {
+            out << " worse";
+            ++worse;
+        }
+        out << std::endl;
+    }
+
+    // A case gone from a suite that ran is a failure too; suites left out of
+    // this run are not
+    std::set<std::string> suites;
+    for (const BenchResult& result : current) {
+        suites.insert(result.name.substr(0, result.name.find('/')));
+    }
+    int missing = 0;
+    for (const BenchResult& result : baseline) {
+        if (seen.insert(result.name).second && suites.count(result.name.substr(0, result.name.find('/')))) {
+            out << result.name << ": missing" << std::endl;
+            ++missing;
+        }
+    }
+
+    out << compared << " results compared, " << worse << " worse by more than " << tolerance << "%, "
+        << missing << " missing" << std::endl;
+    return worse + missing;
+}
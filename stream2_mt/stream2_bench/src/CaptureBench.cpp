@@ -0,0 +1,87 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/DataStreamer.h"
+#include "../../stream2_mt/include/DirectFileSink.h"
+#include "../../stream2_mt/include/SimulatedFx3Transport.h"
+#include "../../stream2_mt/include/StreamFileSink.h"
+#include "../../stream2_mt/include/UringFileSink.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+// One full DataStreamer capture from an unthrottled simulator into sink.
+// Reports end-to-end MB/s (including the final flush) and p99 Submit() time.
+bool MeasureCapture(std::unique_ptr<FileSink> sink, const std::string& path,
+                    size_t totalBytes, int depth, size_t transferSize) {
+    SimulatorConfig config;
+    config.pattern = SimulatorPattern::Counter;  // Cheapest to generate
+    config.bytesPerSecond = 0.0;
+
+    const std::string name = std::string("capture/") + sink->Name();
+    DataStreamer streamer(std::make_unique<SimulatedFx3Transport>(config));
+    if (!streamer.SetQueueConfig(depth, transferSize) || !streamer.SetFileSink(std::move(sink))) {
+        return false;
+    }
+
+    // DataStreamer reports its setup on stdout; keep the suite output to
+    // measurement lines
+    std::ostringstream setupLog;
+    std::streambuf* coutBuffer = std::cout.rdbuf(setupLog.rdbuf());
+    const bool initialized = streamer.Initialize(totalBytes, path);
+    std::cout.rdbuf(coutBuffer);
+    if (!initialized) {
+        return false;
+    }
+
+    const auto start = BenchClock::now();
+    if (!streamer.StartStreaming()) {
+        return false;
+    }
+    while (!streamer.IsComplete() && streamer.IsRunning()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    const bool complete = streamer.IsComplete();
+    streamer.StopStreaming();
+    const double seconds = SecondsSince(start);
+
+    std::cout << name << "_rate: " << streamer.BytesWritten() / (1024.0 * 1024.0) / seconds << " MB/s" << std::endl;
+    std::cout << name << "_submit_p99: " << streamer.WriteLatency().Percentile(99) << " us" << std::endl;
+    return complete;
+}
+
+} // namespace
+
+// Usage: capture [MB] [scratch file] [depth] [transfer KB]
+//
+// Same pipeline as stream2_mt --sim --rate 0, once per disk writer. On a
+// machine where the simulator outruns the disk this is the disk writer's
+// sustained rate; otherwise all writers top out at the simulator's rate.
+int RunCaptureBench(int argc, char** argv) {
+    const size_t megabytes = (argc > 0) ? std::strtoull(argv[0], nullptr, 10) : 1024;
+    const std::string path = (argc > 1) ? argv[1] : "stream2_bench_capture.bin";
+    const int depth = (argc > 2) ? std::atoi(argv[2]) : 8;
+    const size_t transferSize = ((argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 256) * 1024;
+    const size_t totalBytes = megabytes * 1024 * 1024;
+
+    int result = 0;
+    if (!MeasureCapture(std::make_unique<StreamFileSink>(), path, totalBytes, depth, transferSize)) {
+        result = -1;
+    }
+    if (!MeasureCapture(std::make_unique<DirectFileSink>(), path, totalBytes, depth, transferSize)) {
+        result = -1;
+    }
+#ifdef __linux__
+    if (!MeasureCapture(std::make_unique<UringFileSink>(), path, totalBytes, depth, transferSize)) {
+        result = -1;
+    }
+#endif
+
+    std::remove(path.c_str());
+    return result;
+}
@@ -0,0 +1,122 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/CaptureScanner.h"
+#include "../../stream2_mt/include/Deinterleave.h"
+#include "../../stream2_mt/include/FramePool.h"
+#include "../../stream2_mt/include/LineParser.h"
+#include "../../stream2_mt/include/MappedFile.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The captures are small, so each stage runs over and over for at least
+// this long and the best pass counts
+const double kMinSeconds = 0.25;
+const int kMinRepeats = 3;
+
+template<typename Pass>
+double BestSeconds(Pass pass) {
+    double best = 1e30;
+    double total = 0.0;
+    for (int repeat = 0; repeat < kMinRepeats || total < kMinSeconds; ++repeat) {
+        const auto start = BenchClock::now();
+        pass();
+        const double seconds = SecondsSince(start);
+        best = std::min<double>(best, seconds);
+        total += seconds;
+    }
+    return best;
+}
+
+// File name without directory or extension, as the case name
+std::string CaseName(const std::string& path) {
+    const size_t slash = path.find_last_of("/\\");
+    std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    const size_t dot = name.rfind('.');
+    if (dot != std::string::npos && dot > 0) {
+        name.erase(dot);
+    }
+    return name;
+}
+
+bool MeasureCapture(const std::string& path) {
+    MappedFile capture;
+    if (!capture.Open(path)) {
+        std::cerr << "captures: cannot open " << path << std::endl;
+        return false;
+    }
+    const uint32_t* words = reinterpret_cast<const uint32_t*>(capture.Data());
+    const size_t count = capture.Size() / sizeof(uint32_t);
+    const double megabytes = count * sizeof(uint32_t) / (1024.0 * 1024.0);
+    const std::string name = "captures/" + CaseName(path);
+    if (count == 0) {
+        std::cerr << "captures: " << path << " is empty" << std::endl;
+        return false;
+    }
+
+    // Sync scan and line pairing of the whole capture, on one thread
+    CaptureScanConfig config;
+    config.threads = 1;
+    CaptureScan scan;
+    const double scanSeconds = BestSeconds([&]() { scan = ScanCapture(words, count, config); });
+
+    // Splitting it into the four channels
+    std::vector<std::vector<uint8_t>> channels(4, std::vector<uint8_t>(count));
+    uint8_t* const out[4] = { channels[0].data(), channels[1].data(), channels[2].data(), channels[3].data() };
+    const double deinterleaveSeconds = BestSeconds([&]() { DeinterleaveChannels(words, count, out); });
+
+    // Frame assembly as the live view does it: acquisition buffers through
+    // the parser straight into pool frames
+    const size_t bufferWords = 65280 / 4;
+    FramePool pool(3);
+    LineParserStats parsed;
+    const double frameSeconds = BestSeconds([&]() {
+        LineParser parser;
+        FramePublisher publisher(pool);
+        for (size_t offset = 0; offset < count; offset += bufferWords) {
+            parser.Feed(words + offset, std::min<size_t>(bufferWords, count - offset), publisher);
+        }
+        parser.Flush(publisher);
+        publisher.Finish();
+        parsed = parser.Stats();
+    });
+
+    std::cout << name << "_scan: " << megabytes / scanSeconds << " MB/s" << std::endl;
+    std::cout << name << "_deinterleave: " << megabytes / deinterleaveSeconds << " MB/s" << std::endl;
+    std::cout << name << "_frames: " << megabytes / frameSeconds << " MB/s" << std::endl;
+    std::cout << name << "_lines: " << parsed.lines << " lines" << std::endl;
+    std::cout << name << "_frame_count: " << parsed.frames << " frames" << std::endl;
+
+    if (parsed.lines != scan.lines.size()) {
+        std::cerr << "captures: " << path << " scans to " << scan.lines.size() << " lines but parses to "
+                  << parsed.lines << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// Usage: captures <capture files...>
+//
+// Sync scan, deinterleave and frame assembly rates on real captures, such as
+// the ones checked in next to Vis0. Rates are input MB/s; the line and frame
+// counts pin down the parse itself, so a change in them between two runs is
+// a behaviour change, not noise.
+int RunCapturesBench(int argc, char** argv) {
+    if (argc < 1) {
+        std::cerr << "captures: no capture given; name some, or pass --capture to stream2_bench" << std::endl;
+        return -1;
+    }
+
+    int result = 0;
+    for (int i = 0; i < argc; ++i) {
+        if (!MeasureCapture(argv[i])) {
+            result = -1;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,206 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/Clahe.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int kWidth = 712;   // FrameBuffer::ROW_PIXELS
+const int kHeight = 480;
+const int kTile = 32;
+const double kClip = 3.0;
+
+// What Vis0 did before ClaheEngine: a fresh buffer per call and one hard
+// LUT per 32 x 32 tile
+void LegacyEqualize(uint8_t* image, int width, int height) {
+    uint8_t* equalized = new uint8_t[width * height];
+    std::memset(equalized, 0, width * height);
+    const int tilesX = (width + kTile - 1) / kTile;
+    const int tilesY = (height + kTile - 1) / kTile;
+    for (int tileY = 0; tileY < tilesY; tileY++) {
+        for (int tileX = 0; tileX < tilesX; tileX++) {
+            const int startX = tileX * kTile;
+            const int startY = tileY * kTile;
+            const int endX = std::min<int>(startX + kTile, width);
+            const int endY = std::min<int>(startY + kTile, height);
+            int histogram[256] = { 0 };
+            for (int y = startY; y < endY; y++) {
+                for (int x = startX; x < endX; x++) {
+                    histogram[image[y * width + x]]++;
+                }
+            }
+            int cdf[256] = { 0 };
+            cdf[0] = histogram[0];
+            for (int i = 1; i < 256; i++) {
+                cdf[i] = cdf[i - 1] + histogram[i];
+            }
+            const float scale = 255.0f / cdf[255];
+            uint8_t lut[256];
+            for (int i = 0; i < 256; i++) {
+                const int value = static_cast<int>(cdf[i] * scale);
+                lut[i] = value > 255 ? 255 : static_cast<uint8_t>(value);
+            }
+            for (int y = startY; y < endY; y++) {
+                for (int x = startX; x < endX; x++) {
+                    equalized[y * width + x] = lut[image[y * width + x]];
+                }
+            }
+        }
+    }
+    std::memcpy(image, equalized, width * height);
+    delete[] equalized;
+}
+
+// CLAHE written out plainly: clipped LUT per tile, then each pixel blended
+// from its four nearest tile centres in floating point
+std::vector<uint8_t> ReferenceClahe(const std::vector<uint8_t>& image, int width, int height) {
+    const int tilesX = (width + kTile - 1) / kTile;
+    const int tilesY = (height + kTile - 1) / kTile;
+    std::vector<double> luts(static_cast<size_t>(tilesX) * tilesY * 256);
+    for (int ty = 0; ty < tilesY; ++ty) {
+        for (int tx = 0; tx < tilesX; ++tx) {
+            std::vector<uint32_t> histogram(256, 0);
+            uint32_t count = 0;
+            for (int y = ty * kTile; y < std::min<int>((ty + 1) * kTile, height); ++y) {
+                for (int x = tx * kTile; x < std::min<int>((tx + 1) * kTile, width); ++x) {
+                    ++histogram[image[static_cast<size_t>(y) * width + x]];
+                    ++count;
+                }
+            }
+            const uint32_t limit = std::max<uint32_t>(static_cast<uint32_t>(kClip * count / 256), 1);
+            uint32_t excess = 0;
+            for (auto& bin : histogram) {
+                if (bin > limit) {
+                    excess += bin - limit;
+                    bin = limit;
+                }
+            }
+            uint32_t residual = excess % 256;
+            for (auto& bin : histogram) {
+                bin += excess / 256;
+            }
+            const uint32_t step = residual > 0 ? std::max<uint32_t>(256 / residual, 1) : 1;
+            for (uint32_t i = 0; i < 256 && residual > 0; i += step, --residual) {
+                ++histogram[i];
+            }
+            uint32_t sum = 0;
+            for (int i = 0; i < 256; ++i) {
+                sum += histogram[i];
+                luts[(static_cast<size_t>(ty) * tilesX + tx) * 256 + i] = std::min<double>(std::floor((sum * 255.0 + count / 2) / count), 255.0);
+            }
+        }
+    }
+
+    const auto around = [](int pixel, int tiles, int& first, int& second, double& weight) {
+        const double position = (pixel + 0.5) / kTile - 0.5;
+        if (position <= 0.0) {
+            first = second = 0;
+            weight = 0.0;
+        } else if (position >= tiles - 1) {
+            first = second = tiles - 1;
+            weight = 0.0;
+        } else {
+            first = static_cast<int>(position);
+            second = first + 1;
+            weight = position - first;
+        }
+    };
+    std::vector<uint8_t> out(image.size());
+    for (int y = 0; y < height; ++y) {
+        int t0, t1;
+        double wy;
+        around(y, tilesY, t0, t1, wy);
+        for (int x = 0; x < width; ++x) {
+            int l, r;
+            double wx;
+            around(x, tilesX, l, r, wx);
+            const int v = image[static_cast<size_t>(y) * width + x];
+            const auto lut = [&](int ty, int tx) { return luts[(static_cast<size_t>(ty) * tilesX + tx) * 256 + v]; };
+            const double upper = lut(t0, l) * (1 - wx) + lut(t0, r) * wx;
+            const double lower = lut(t1, l) * (1 - wx) + lut(t1, r) * wx;
+            out[static_cast<size_t>(y) * width + x] = static_cast<uint8_t>(std::lround(upper * (1 - wy) + lower * wy));
+        }
+    }
+    return out;
+}
+
+// Best of repeats runs of fn over a fresh copy of source, in milliseconds
+double BestMs(int repeats, std::vector<uint8_t>& work, const std::vector<uint8_t>& source, void (*fn)(uint8_t*, void*), void* context) {
+    double best = 1e30;
+    for (int i = 0; i < repeats; ++i) {
+        std::memcpy(work.data(), source.data(), source.size());
+        const auto start = BenchClock::now();
+        fn(work.data(), context);
+        best = std::min<double>(best, SecondsSince(start) * 1000.0);
+    }
+    return best;
+}
+
+} // namespace
+
+// Usage: clahe [repeats]
+//
+// Equalizes a 712 x 480 frame with the per-tile LUTs Vis0 used to apply and
+// with ClaheEngine (32-pixel tiles, clip 3) on one thread and on one per
+// core. Reports the best time per frame and the frame rate it would
+// sustain, and checks the engine against a plain floating-point CLAHE.
+int RunClaheBench(int argc, char** argv) {
+    const int repeats = (argc > 0) ? std::atoi(argv[0]) : 50;
+
+    // A dim frame with a gradient, noise and a flat band, as a live view gets
+    std::mt19937 rng(5);
+    std::vector<uint8_t> source(static_cast<size_t>(kWidth) * kHeight);
+    for (int y = 0; y < kHeight; ++y) {
+        for (int x = 0; x < kWidth; ++x) {
+            int value = 20 + x / 16 + y / 12 + static_cast<int>(rng() % 9);
+            if (y >= 200 && y < 240) {
+                value = 40;  // Flat: every pixel in one bin
+            }
+            source[static_cast<size_t>(y) * kWidth + x] = static_cast<uint8_t>(value);
+        }
+    }
+    std::vector<uint8_t> work(source.size());
+
+    const auto report = [](const std::string& name, double ms) {
+        std::cout << "clahe/" << name << ": " << ms << " ms/frame (" << 1000.0 / ms << " fps)" << std::endl;
+    };
+
+    report("legacy", BestMs(repeats, work, source, [](uint8_t* image, void*) { LegacyEqualize(image, kWidth, kHeight); }, nullptr));
+
+    int result = 0;
+    const std::vector<uint8_t> expected = ReferenceClahe(source, kWidth, kHeight);
+    const unsigned cores = std::max<unsigned>(std::thread::hardware_concurrency(), 1u);
+    std::vector<unsigned> threadCounts = { 1 };
+    if (cores > 1) {
+        threadCounts.push_back(cores);
+    }
+    for (unsigned threads : threadCounts) {
+        ClaheConfig config;
+        config.tileSize = kTile;
+        config.clipLimit = kClip;
+        config.threads = threads;
+        ClaheEngine engine(config);
+        const double ms = BestMs(repeats, work, source, [](uint8_t* image, void* context) {
+            static_cast<ClaheEngine*>(context)->Apply(image, kWidth, kHeight);
+        }, &engine);
+        report("engine_" + std::to_string(threads) + "t", ms);
+
+        int worst = 0;
+        for (size_t i = 0; i < work.size(); ++i) {
+            worst = std::max<int>(worst, std::abs(static_cast<int>(work[i]) - static_cast<int>(expected[i])));
+        }
+        if (worst > 1) {
+            std::cerr << "clahe: " << threads << " threads off the reference by " << worst << std::endl;
+            result = -1;
+        }
+    }
+    return result;
+}
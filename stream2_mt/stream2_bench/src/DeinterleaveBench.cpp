@@ -0,0 +1,139 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/Deinterleave.h"
+#include "../../stream2_mt/include/SyncScanner.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int kRepeats = 5;
+
+// The split analyzeData used before the packed scanner: one byte per bit,
+// copied into a vector<bool>, then dealt bit by bit into four channels
+std::vector<std::vector<bool>> LegacySplit(const std::vector<uint32_t>& data) {
+    std::vector<uint8_t> rawBits;
+    rawBits.reserve(data.size() * 32);
+    for (uint32_t value : data) {
+        for (int bit = 0; bit < 32; ++bit) {
+            rawBits.push_back((value >> bit) & 1);
+        }
+    }
+
+    std::vector<bool> bits(rawBits.begin(), rawBits.end());
+    std::vector<std::vector<bool>> channelBits(4);
+    for (size_t i = 0; i < bits.size(); ++i) {
+        channelBits[i % 4].push_back(bits[i]);
+    }
+    return channelBits;
+}
+
+bool LegacyMatches(const std::vector<std::vector<bool>>& channelBits,
+                   const std::vector<std::vector<uint8_t>>& reference) {
+    for (int c = 0; c < 4; ++c) {
+        for (size_t k = 0; k < channelBits[c].size(); ++k) {
+            if (channelBits[c][k] != (((reference[c][k / 8] >> (7 - k % 8)) & 1) != 0)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void PrintRate(const std::string& name, size_t bytes, double seconds) {
+    std::cout << "deinterleave/" << name << ": " << bytes / (1024.0 * 1024.0) / seconds << " MB/s" << std::endl;
+}
+
+} // namespace
+
+// Usage: deinterleave <capture file>
+//
+// Splits a capture into its four channels with the legacy vector<bool> loop
+// and with every deinterleave kernel this CPU supports. Rates are input MB/s,
+// best of several runs; every result is checked against ExtractChannel().
+int RunDeinterleaveBench(int argc, char** argv) {
+    if (argc < 1) {
+        std::cerr << "deinterleave: no capture given; name one, or pass --capture to stream2_bench" << std::endl;
+        return -1;
+    }
+    const std::string path = argv[0];
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "deinterleave: cannot open " << path << std::endl;
+        return -1;
+    }
+    const std::vector<char> raw((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::vector<uint32_t> data(raw.size() / sizeof(uint32_t));
+    std::memcpy(data.data(), raw.data(), data.size() * sizeof(uint32_t));
+    const size_t bytes = data.size() * sizeof(uint32_t);
+    if (data.empty()) {
+        std::cerr << "deinterleave: " << path << " is empty" << std::endl;
+        return -1;
+    }
+
+    std::vector<std::vector<uint8_t>> reference(4, std::vector<uint8_t>(data.size()));
+    for (int c = 0; c < 4; ++c) {
+        ExtractChannel(data.data(), data.size(), c, reference[c].data());
+    }
+
+    int result = 0;
+
+    // The legacy split allocates ~40 bytes per input byte; once is enough
+    {
+        const auto start = BenchClock::now();
+        const std::vector<std::vector<bool>> channelBits = LegacySplit(data);
+        PrintRate("legacy", bytes, SecondsSince(start));
+        if (!LegacyMatches(channelBits, reference)) {
+            std::cerr << "deinterleave: legacy split disagrees with ExtractChannel" << std::endl;
+            result = -1;
+        }
+    }
+
+    {
+        std::vector<uint8_t> out(data.size());
+        double best = 1e30;
+        for (int repeat = 0; repeat < kRepeats; ++repeat) {
+            const auto start = BenchClock::now();
+            for (int c = 0; c < 4; ++c) {
+                ExtractChannel(data.data(), data.size(), c, out.data());
+            }
+            const double seconds = SecondsSince(start);
+            if (seconds < best) {
+                best = seconds;
+            }
+        }
+        PrintRate("extract_channel", bytes, best);
+    }
+
+    const DeinterleaveKernel kernels[] = {
+        DeinterleaveKernel::Scalar, DeinterleaveKernel::Bmi2, DeinterleaveKernel::Avx2,
+    };
+    std::vector<std::vector<uint8_t>> channels(4, std::vector<uint8_t>(data.size()));
+    uint8_t* const out[4] = { channels[0].data(), channels[1].data(), channels[2].data(), channels[3].data() };
+    for (DeinterleaveKernel kernel : kernels) {
+        if (!DeinterleaveKernelSupported(kernel)) {
+            continue;
+        }
+        double best = 1e30;
+        for (int repeat = 0; repeat < kRepeats; ++repeat) {
+            const auto start = BenchClock::now();
+            DeinterleaveChannelsWith(kernel, data.data(), data.size(), out);
+            const double seconds = SecondsSince(start);
+            if (seconds < best) {
+                best = seconds;
+            }
+        }
+        PrintRate(DeinterleaveKernelName(kernel), bytes, best);
+        if (channels != reference) {
+            std::cerr << "deinterleave: " << DeinterleaveKernelName(kernel)
+                      << " disagrees with ExtractChannel" << std::endl;
+            result = -1;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,145 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/FrameViewer.h"
+#include "../../stream2_mt/include/LatencyHistogram.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int kWidth = 712;   // FrameBuffer::ROW_PIXELS
+const int kHeight = 480;
+
+// Renders after a settings change, best of repeats, and whether any stage
+// other than those expected was worked out again
+struct Step {
+    const char* name;
+    void (*change)(DisplaySettings&);
+    bool tone;       // Tone pass expected
+    bool equalize;   // CLAHE pass expected
+};
+
+const Step kSteps[] = {
+    { "plain", [](DisplaySettings&) {}, false, false },
+    { "equalize_on", [](DisplaySettings& s) { s.equalize = true; }, false, true },
+    { "equalize_off", [](DisplaySettings& s) { s.equalize = false; }, false, false },
+    { "equalize_on_again", [](DisplaySettings& s) { s.equalize = true; }, false, false },
+    { "palette", [](DisplaySettings& s) { s.palette = DisplayPalette::Hot; }, false, false },
+    { "window_level", [](DisplaySettings& s) { s.level = 64; s.window = 128; }, true, true },
+    { "gamma", [](DisplaySettings& s) { s.gamma = 2.2; }, true, true },
+    { "equalize_off_again", [](DisplaySettings& s) { s.equalize = false; }, false, false },
+};
+
+// Time from SetSettings() to the re-rendered texture being finished, with
+// one frame held and none coming in
+int MeasureViewerToggle(const std::vector<uint8_t>& frame, int toggles) {
+    FramePool pool(3);
+    HeadlessSurface surface(60.0);
+    FrameViewer viewer(pool, surface);
+    if (!viewer.Start()) {
+        std::cerr << "display: headless surface did not open" << std::endl;
+        return -1;
+    }
+
+    FrameBuffer* buffer = pool.Acquire();
+    for (int y = 0; y < kHeight; ++y) {
+        LineView line = {};
+        line.pixels = frame.data() + static_cast<size_t>(y) * kWidth;
+        line.bytes = kWidth / 4;
+        buffer->AppendLine(line);
+    }
+    buffer->SetFrameNumber(1);
+    pool.Publish(buffer);
+    while (viewer.Stats().uploaded < 1) {
+        std::this_thread::yield();
+    }
+
+    LatencyHistogram latency;
+    DisplaySettings settings = viewer.Settings();
+    for (int i = 0; i < toggles; ++i) {
+        const uint64_t before = viewer.Stats().uploaded;
+        settings.equalize = !settings.equalize;
+        const auto start = BenchClock::now();
+        viewer.SetSettings(settings);
+        while (viewer.Stats().uploaded == before) {
+            std::this_thread::yield();
+        }
+        latency.Record(SecondsSince(start) * 1e6);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));  // Last texture to the surface
+    viewer.Stop();
+
+    std::cout << "display/viewer_toggle_p50: " << latency.Percentile(50) << " us" << std::endl;
+    std::cout << "display/viewer_toggle_max: " << latency.Max() << " us" << std::endl;
+    if (surface.Offscreen().frameNumber != 1) {
+        std::cerr << "display: the held frame was not re-rendered" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+} // namespace
+
+// Usage: display [repeats]
+//
+// Holds one 712 x 480 frame in a DisplayPipeline and steps through setting
+// changes: equalization off and on, palette, window/level and gamma. Reports
+// the best render time after each and checks that only the stages a change
+// touches were worked out again, so toggles cost a copy. Then measures how
+// long a FrameViewer holding that frame takes to re-render it on a toggle.
+int RunDisplayBench(int argc, char** argv) {
+    const int repeats = (argc > 0) ? std::atoi(argv[0]) : 20;
+
+    std::mt19937 rng(9);
+    std::vector<uint8_t> frame(static_cast<size_t>(kWidth) * kHeight);
+    for (int y = 0; y < kHeight; ++y) {
+        for (int x = 0; x < kWidth; ++x) {
+            frame[static_cast<size_t>(y) * kWidth + x] = static_cast<uint8_t>(30 + x / 12 + y / 10 + rng() % 7);
+        }
+    }
+
+    int result = 0;
+    ViewerTexture texture;
+    DisplaySettings settings;
+    for (const Step& step : kSteps) {
+        step.change(settings);
+
+        // The first render after the change does the work; best of a fresh
+        // pipeline per repeat
+        double best = 1e30;
+        DisplayStageCounts work;
+        for (int i = 0; i < repeats; ++i) {
+            DisplayPipeline pipeline;
+            pipeline.SetFrame(frame.data(), kWidth, kHeight, 1);
+            DisplaySettings previous;
+            for (const Step& earlier : kSteps) {
+                if (&earlier == &step) {
+                    break;
+                }
+                earlier.change(previous);
+                pipeline.SetSettings(previous);
+                pipeline.Render(texture);
+            }
+            const DisplayStageCounts before = pipeline.Counts();
+            const auto start = BenchClock::now();
+            pipeline.SetSettings(settings);
+            pipeline.Render(texture);
+            best = std::min<double>(best, SecondsSince(start) * 1e6);
+            work.tone = pipeline.Counts().tone - before.tone;
+            work.equalize = pipeline.Counts().equalize - before.equalize;
+        }
+        std::cout << "display/" << step.name << ": " << best << " us" << std::endl;
+        if ((work.tone != 0) != step.tone || (work.equalize != 0) != step.equalize) {
+            std::cerr << "display: " << step.name << " ran tone " << work.tone << "x, equalize "
+                      << work.equalize << "x" << std::endl;
+            result = -1;
+        }
+    }
+
+    result |= MeasureViewerToggle(frame, repeats);
+    return result;
+}
@@ -0,0 +1,130 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/FrameBuffer.h"
+#include "../../stream2_mt/include/Fx3PatternGenerator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// Vis0's per-line frame layout before FrameBuffer
+struct LegacyLine {
+    std::vector<uint8_t> channel1;
+    std::vector<uint8_t> channel2;
+    std::vector<uint8_t> channel3;
+    std::vector<uint8_t> channel4;
+    std::vector<uint8_t> interleavedData;
+    size_t startIndex;
+    size_t endIndex;
+};
+
+struct LegacyFrame {
+    std::vector<LegacyLine> lines;
+};
+
+// Fills a bitmap the way displayFrameImage did from LegacyLine
+void LegacyFill(const LegacyFrame& frame, std::vector<uint8_t>& bitmap) {
+    const int width = FrameBuffer::ROW_PIXELS;
+    std::memset(bitmap.data(), 0, bitmap.size());
+    for (size_t y = 0; y < frame.lines.size(); ++y) {
+        const LegacyLine& line = frame.lines[y];
+        const size_t pixels = std::min<size_t>(line.channel1.size(), width / 4);
+        for (size_t i = 0; i < pixels; ++i) {
+            bitmap[y * width + i * 4] = line.channel1[i];
+            bitmap[y * width + i * 4 + 1] = line.channel2[i];
+            bitmap[y * width + i * 4 + 2] = line.channel3[i];
+            bitmap[y * width + i * 4 + 3] = line.channel4[i];
+        }
+    }
+}
+
+class FrameCounter : public LineSink {
+public:
+    explicit FrameCounter(FrameBuffer& frame) : m_frame(frame) {}
+
+    void OnLine(const LineView& line) override {
+        if (line.newFrame || m_frame.Full()) {
+            m_frame.Clear();
+            ++frames;
+        }
+        m_frame.AppendLine(line);
+    }
+
+    size_t frames = 0;
+
+private:
+    FrameBuffer& m_frame;
+};
+
+} // namespace
+
+// Usage: frame [MB]
+//
+// Assembles frames from simulated video fed one acquisition buffer at a
+// time, first the old way (ParsedLine copies moved into five vectors per
+// line, then interleaved into the bitmap) and then straight into a
+// FrameBuffer from the parser. Reports the cost per line of each and checks
+// the last frame's pixels agree.
+int RunFrameBench(int argc, char** argv) {
+    const size_t megabytes = (argc > 0) ? std::strtoull(argv[0], nullptr, 10) : 64;
+    const size_t bufferWords = 65280 / 4;
+
+    std::vector<uint32_t> data(megabytes * 1024 * 1024 / 4);
+    Fx3PatternGenerator generator;
+    generator.Fill(reinterpret_cast<unsigned char*>(data.data()), data.size() * 4);
+
+    std::vector<uint8_t> legacyBitmap(static_cast<size_t>(FrameBuffer::ROW_PIXELS) * FrameBuffer::DEFAULT_LINES);
+    size_t legacyLines = 0;
+    double legacySeconds = 0.0;
+    {
+        LineParser parser;
+        std::vector<ParsedLine> parsed;
+        LegacyFrame frame;
+        const auto start = BenchClock::now();
+        for (size_t offset = 0; offset < data.size(); offset += bufferWords) {
+            parser.Feed(data.data() + offset, std::min<size_t>(bufferWords, data.size() - offset), parsed);
+            for (ParsedLine& line : parsed) {
+                if (line.newFrame || frame.lines.size() >= static_cast<size_t>(FrameBuffer::DEFAULT_LINES)) {
+                    LegacyFill(frame, legacyBitmap);
+                    frame.lines.clear();
+                }
+                LegacyLine legacy;
+                legacy.startIndex = static_cast<size_t>(line.startBit);
+                legacy.endIndex = static_cast<size_t>(line.endBit);
+                legacy.channel1 = std::move(line.channels[0]);
+                legacy.channel2 = std::move(line.channels[1]);
+                legacy.channel3 = std::move(line.channels[2]);
+                legacy.channel4 = std::move(line.channels[3]);
+                frame.lines.push_back(legacy);
+                ++legacyLines;
+            }
+            parsed.clear();
+        }
+        LegacyFill(frame, legacyBitmap);
+        legacySeconds = SecondsSince(start);
+    }
+
+    FrameBuffer frame;
+    FrameCounter sink(frame);
+    LineParser parser;
+    const auto start = BenchClock::now();
+    for (size_t offset = 0; offset < data.size(); offset += bufferWords) {
+        parser.Feed(data.data() + offset, std::min<size_t>(bufferWords, data.size() - offset), sink);
+    }
+    const double seconds = SecondsSince(start);
+    const size_t lines = parser.Stats().lines;
+
+    std::cout << "frame/legacy_lines: " << legacySeconds * 1e9 / static_cast<double>(legacyLines) << " ns/line" << std::endl;
+    std::cout << "frame/frame_buffer: " << seconds * 1e9 / static_cast<double>(lines) << " ns/line" << std::endl;
+    std::cout << "frame/frames: " << sink.frames << " frames" << std::endl;
+
+    if (lines != legacyLines ||
+        std::memcmp(legacyBitmap.data(), frame.Pixels(), static_cast<size_t>(frame.Width()) * frame.Height()) != 0) {
+        std::cerr << "frame: FrameBuffer disagrees with the per-line frame" << std::endl;
+        return -1;
+    }
+    return 0;
+}
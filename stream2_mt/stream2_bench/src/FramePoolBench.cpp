@@ -0,0 +1,100 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/FramePool.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int kPoolFrames = 6;
+
+// Takes frames until the producer is done and its queue is empty, spending
+// workUs on each as if it were drawing or writing it
+void RunConsumer(FramePool& pool, int id, int workUs, const std::atomic<bool>& producing) {
+    for (;;) {
+        FrameBuffer* frame = pool.WaitForFrame(id, std::chrono::milliseconds(10));
+        if (!frame) {
+            if (!producing.load()) {
+                break;
+            }
+            continue;
+        }
+        if (workUs > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(workUs));
+        }
+        pool.Release(frame);
+    }
+}
+
+} // namespace
+
+// Usage: framepool [frames] [display us per frame]
+//
+// One producer fills and publishes frames as fast as it can while three
+// consumers take them: a display that needs 5 ms per frame by default, a
+// recorder that keeps up, and a stats reader with a deeper queue. Reports
+// the publish rate and what each consumer got or lost, and checks that every
+// frame comes back to the pool.
+int RunFramePoolBench(int argc, char** argv) {
+    const int frames = (argc > 0) ? std::atoi(argv[0]) : 2000;
+    const int displayUs = (argc > 1) ? std::atoi(argv[1]) : 5000;
+
+    FramePool pool(kPoolFrames);
+    const int display = pool.AddConsumer("display", 1);
+    const int recorder = pool.AddConsumer("recorder", 2);
+    const int stats = pool.AddConsumer("stats", 3);
+
+    std::atomic<bool> producing(true);
+    std::vector<std::thread> consumers;
+    consumers.emplace_back(RunConsumer, std::ref(pool), display, displayUs, std::cref(producing));
+    consumers.emplace_back(RunConsumer, std::ref(pool), recorder, 0, std::cref(producing));
+    consumers.emplace_back(RunConsumer, std::ref(pool), stats, 0, std::cref(producing));
+
+    // A row of pixels to append, as the parser would
+    std::vector<uint8_t> pixels(FrameBuffer::ROW_PIXELS, 0x80);
+    LineView line = {};
+    line.pixels = pixels.data();
+    line.bytes = pixels.size() / 4;
+
+    int published = 0;
+    const auto start = BenchClock::now();
+    while (published < frames) {
+        FrameBuffer* frame = pool.Acquire();
+        if (!frame) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (int y = 0; y < 480; ++y) {
+            frame->AppendLine(line);
+        }
+        frame->SetFrameNumber(++published);
+        pool.Publish(frame);
+    }
+    const double seconds = SecondsSince(start);
+    producing = false;
+    for (auto& thread : consumers) {
+        thread.join();
+    }
+
+    const FramePoolStats poolStats = pool.Stats();
+    std::cout << "framepool/publish_rate: " << published / seconds << " frames/s" << std::endl;
+    std::cout << "framepool/starved: " << poolStats.starved << " acquires" << std::endl;
+    int result = 0;
+    for (const FrameConsumerStats& consumer : poolStats.consumers) {
+        std::cout << "framepool/" << consumer.name << "_delivered: " << consumer.delivered << " frames" << std::endl;
+        std::cout << "framepool/" << consumer.name << "_dropped: " << consumer.dropped << " frames" << std::endl;
+        if (consumer.delivered + consumer.dropped != poolStats.published) {
+            std::cerr << "framepool: " << consumer.name << " lost track of frames" << std::endl;
+            result = -1;
+        }
+    }
+    if (pool.FreeFrames() != static_cast<size_t>(kPoolFrames)) {
+        std::cerr << "framepool: " << kPoolFrames - pool.FreeFrames() << " frames never came back" << std::endl;
+        result = -1;
+    }
+    return result;
+}
@@ -0,0 +1,136 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/BufferManager.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace {
+
+// The queue-and-mutex BufferManager this project used before the SPSC rings,
+// kept here as the baseline.
+class MutexBufferManager {
+public:
+    MutexBufferManager(size_t bufferSize, int numBuffers) {
+        for (int i = 0; i < numBuffers; ++i) {
+            auto buffer = std::make_unique<Buffer>();
+            buffer->data = std::make_unique<unsigned char[]>(bufferSize);
+            buffer->size = bufferSize;
+            buffer->bytesUsed = 0;
+
+            m_emptyBuffers.push(buffer.get());
+            m_allBuffers.push_back(std::move(buffer));
+        }
+    }
+
+    Buffer* GetEmptyBuffer() {
+        std::lock_guard<std::mutex> lock(m_emptyMutex);
+        if (m_emptyBuffers.empty()) {
+            return nullptr;
+        }
+        Buffer* buffer = m_emptyBuffers.front();
+        m_emptyBuffers.pop();
+        return buffer;
+    }
+
+    void QueueFullBuffer(Buffer* buffer) {
+        std::lock_guard<std::mutex> lock(m_fullMutex);
+        m_fullBuffers.push(buffer);
+    }
+
+    Buffer* GetFullBuffer() {
+        std::lock_guard<std::mutex> lock(m_fullMutex);
+        if (m_fullBuffers.empty()) {
+            return nullptr;
+        }
+        Buffer* buffer = m_fullBuffers.front();
+        m_fullBuffers.pop();
+        return buffer;
+    }
+
+    void ReturnEmptyBuffer(Buffer* buffer) {
+        std::lock_guard<std::mutex> lock(m_emptyMutex);
+        buffer->bytesUsed = 0;
+        m_emptyBuffers.push(buffer);
+    }
+
+private:
+    std::queue<Buffer*> m_emptyBuffers;
+    std::queue<Buffer*> m_fullBuffers;
+    std::vector<std::unique_ptr<Buffer>> m_allBuffers;
+    std::mutex m_emptyMutex;
+    std::mutex m_fullMutex;
+};
+
+// Runs a reader-shaped producer and a writer-shaped consumer against the
+// manager for `seconds` and returns completed round trips per second.
+template <typename Manager>
+double MeasureHandoffs(int numBuffers, double seconds) {
+    Manager manager(4096, numBuffers);
+    std::atomic<bool> running(true);
+    std::atomic<bool> started(false);
+    size_t handoffs = 0;
+
+    std::thread writer([&]() {
+        while (!started.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        size_t count = 0;
+        while (running.load(std::memory_order_relaxed)) {
+            Buffer* buffer = manager.GetFullBuffer();
+            if (!buffer) {
+                std::this_thread::yield();
+                continue;
+            }
+            manager.ReturnEmptyBuffer(buffer);
+            ++count;
+        }
+        handoffs = count;
+    });
+
+    std::thread reader([&]() {
+        while (!started.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        while (running.load(std::memory_order_relaxed)) {
+            Buffer* buffer = manager.GetEmptyBuffer();
+            if (!buffer) {
+                std::this_thread::yield();
+                continue;
+            }
+            buffer->bytesUsed = buffer->size;
+            manager.QueueFullBuffer(buffer);
+        }
+    });
+
+    const auto start = BenchClock::now();
+    started.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    running.store(false, std::memory_order_relaxed);
+    reader.join();
+    writer.join();
+
+    return static_cast<double>(handoffs) / SecondsSince(start);
+}
+
+} // namespace
+
+// Usage: handoff [seconds]
+int RunHandoffBench(int argc, char** argv) {
+    const double seconds = (argc > 0) ? std::atof(argv[0]) : 2.0;
+    const int depths[] = { 4, 64 };
+
+    for (int depth : depths) {
+        const double mutexRate = MeasureHandoffs<MutexBufferManager>(depth, seconds);
+        const double spscRate = MeasureHandoffs<BufferManager>(depth, seconds);
+
+        std::cout << "handoff/mutex/depth" << depth << ": " << mutexRate << " handoffs/s" << std::endl;
+        std::cout << "handoff/spsc/depth" << depth << ": " << spscRate << " handoffs/s" << std::endl;
+        std::cout << "handoff/speedup/depth" << depth << ": " << (spscRate / mutexRate) << " x" << std::endl;
+    }
+
+    return 0;
+}
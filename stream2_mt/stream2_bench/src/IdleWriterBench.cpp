@@ -0,0 +1,99 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/BufferManager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// CPU share used by a DiskWriterThread-shaped consumer while no data arrives.
+// blocking=false reproduces the old GetFullBuffer()/continue loop.
+double MeasureIdleCpu(bool blocking, double seconds) {
+    BufferManager manager(4096, 4);
+    std::atomic<bool> running(true);
+    double cpuSeconds = 0.0;
+
+    std::thread writer([&]() {
+        const double cpuStart = ThreadCpuSeconds();
+        while (running.load(std::memory_order_relaxed)) {
+            Buffer* buffer = blocking
+                ? manager.WaitForFullBuffer(std::chrono::milliseconds(100))
+                : manager.GetFullBuffer();
+            if (!buffer) {
+                continue;
+            }
+            manager.ReturnEmptyBuffer(buffer);
+        }
+        cpuSeconds = ThreadCpuSeconds() - cpuStart;
+    });
+
+    const auto start = BenchClock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    running.store(false, std::memory_order_relaxed);
+    manager.WakeAll();
+    writer.join();
+
+    return 100.0 * cpuSeconds / SecondsSince(start);
+}
+
+// Time from QueueFullBuffer() to the blocked writer holding the buffer.
+std::vector<double> MeasureWakeLatency(int samples) {
+    BufferManager manager(4096, 4);
+    std::atomic<int64_t> queuedAt(0);
+    std::vector<double> latenciesUs;
+    latenciesUs.reserve(samples);
+
+    auto nowNs = []() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            BenchClock::now().time_since_epoch()).count();
+    };
+
+    std::thread writer([&]() {
+        for (int i = 0; i < samples; ++i) {
+            Buffer* buffer = nullptr;
+            while (!buffer) {
+                buffer = manager.WaitForFullBuffer(std::chrono::milliseconds(100));
+            }
+            latenciesUs.push_back((nowNs() - queuedAt.load()) / 1000.0);
+            manager.ReturnEmptyBuffer(buffer);
+        }
+    });
+
+    for (int i = 0; i < samples; ++i) {
+        // Long enough gap that the writer is asleep, not spinning
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        Buffer* buffer = nullptr;
+        while (!buffer) {
+            buffer = manager.WaitForEmptyBuffer(std::chrono::milliseconds(100));
+        }
+        queuedAt.store(nowNs());
+        manager.QueueFullBuffer(buffer);
+    }
+    writer.join();
+
+    std::sort(latenciesUs.begin(), latenciesUs.end());
+    return latenciesUs;
+}
+
+} // namespace
+
+// Usage: idle [seconds] [wake samples]
+int RunIdleWriterBench(int argc, char** argv) {
+    const double seconds = (argc > 0) ? std::atof(argv[0]) : 2.0;
+    const int samples = (argc > 1) ? std::atoi(argv[1]) : 500;
+
+    std::cout << "idle/spin_writer_cpu: " << MeasureIdleCpu(false, seconds) << " %" << std::endl;
+    std::cout << "idle/blocking_writer_cpu: " << MeasureIdleCpu(true, seconds) << " %" << std::endl;
+
+    const std::vector<double> latencies = MeasureWakeLatency(samples);
+    if (!latencies.empty()) {
+        std::cout << "idle/wake_latency_p50: " << latencies[latencies.size() / 2] << " us" << std::endl;
+        std::cout << "idle/wake_latency_p99: " << latencies[latencies.size() * 99 / 100] << " us" << std::endl;
+    }
+
+    return 0;
+}
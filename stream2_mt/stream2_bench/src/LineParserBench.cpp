@@ -0,0 +1,48 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/Fx3PatternGenerator.h"
+#include "../../stream2_mt/include/LineParser.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Usage: lineparser [MB] [buffer bytes]
+//
+// Feeds simulated video to LineParser one acquisition buffer at a time, the
+// way Vis0's live mode does, and reports the parse cost per buffer next to
+// the time that buffer takes to arrive at the sensor's 297 MB/s.
+int RunLineParserBench(int argc, char** argv) {
+    const size_t megabytes = (argc > 0) ? std::strtoull(argv[0], nullptr, 10) : 64;
+    const size_t bufferBytes = ((argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 65280) & ~size_t(3);
+    const double SENSOR_BYTES_PER_SECOND = 297.0 * 1024 * 1024;
+    if (bufferBytes == 0) {
+        std::cerr << "lineparser: buffer size must be at least 4 bytes" << std::endl;
+        return -1;
+    }
+
+    // Pre-generate a ring of buffers so the generator stays out of the timing
+    const size_t ringBuffers = 64;
+    std::vector<uint32_t> ring(ringBuffers * bufferBytes / 4);
+    Fx3PatternGenerator generator;
+    generator.Fill(reinterpret_cast<unsigned char*>(ring.data()), ring.size() * 4);
+
+    LineParser parser;
+    std::vector<ParsedLine> lines;
+    const size_t buffers = megabytes * 1024 * 1024 / bufferBytes;
+    const size_t wordsPerBuffer = bufferBytes / 4;
+
+    const auto start = BenchClock::now();
+    for (size_t i = 0; i < buffers; ++i) {
+        lines.clear();
+        parser.Feed(ring.data() + (i % ringBuffers) * wordsPerBuffer, wordsPerBuffer, lines);
+    }
+    const double seconds = SecondsSince(start);
+
+    const double parseUs = seconds * 1e6 / static_cast<double>(buffers);
+    const double arrivalUs = static_cast<double>(bufferBytes) * 1e6 / SENSOR_BYTES_PER_SECOND;
+    std::cout << "lineparser/rate: " << buffers * bufferBytes / (1024.0 * 1024.0) / seconds << " MB/s" << std::endl;
+    std::cout << "lineparser/per_buffer: " << parseUs << " us" << std::endl;
+    std::cout << "lineparser/arrival_interval: " << arrivalUs << " us" << std::endl;
+    std::cout << "lineparser/lines: " << parser.Stats().lines << " lines" << std::endl;
+    return 0;
+}
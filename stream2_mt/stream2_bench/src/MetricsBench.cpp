@@ -0,0 +1,114 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/Metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// One counter all threads add to, as a plain std::atomic would be used
+struct SharedCounter {
+    alignas(64) std::atomic<uint64_t> value{ 0 };
+    void Add() { value.fetch_add(1, std::memory_order_relaxed); }
+};
+
+// Runs body(events) on each of threads threads at once and returns the
+// wall time per event per thread, in nanoseconds
+template<typename Body>
+double NsPerEvent(unsigned threads, uint64_t events, Body body) {
+    std::vector<std::thread> workers;
+    const auto start = BenchClock::now();
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&body, events]() { body(events); });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return SecondsSince(start) * 1e9 / static_cast<double>(events) / threads;
+}
+
+} // namespace
+
+// Usage: metrics [events per thread]
+//
+// Cost of one update on the hot path: MetricCounter::Add, MetricGauge::Set
+// and MetricHistogram::Record on one thread and on several, next to a single
+// shared atomic counter. Then checks that a snapshot adds every thread's
+// cells up and that both exports carry the result.
+int RunMetricsBench(int argc, char** argv) {
+    const uint64_t events = (argc > 0) ? std::strtoull(argv[0], nullptr, 10) : 20000000;
+    const unsigned cores = std::max<unsigned>(std::thread::hardware_concurrency(), 1u);
+
+    MetricsRegistry registry;
+    MetricCounter& counter = registry.Counter("bench_events_total", "Events");
+    MetricGauge& gauge = registry.Gauge("bench_level", "Level");
+    MetricHistogram& histogram = registry.Histogram("bench_latency_us", "Latency");
+    SharedCounter shared;
+
+    std::vector<unsigned> threadCounts = { 1 };
+    if (cores > 1) {
+        threadCounts.push_back(cores);
+    }
+    int result = 0;
+    for (unsigned threads : threadCounts) {
+        const std::string suffix = "_" + std::to_string(threads) + "t";
+        const uint64_t before = counter.Value();
+        const double counterNs = NsPerEvent(threads, events, [&counter](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                counter.Add();
+            }
+        });
+        const double sharedNs = NsPerEvent(threads, events, [&shared](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                shared.Add();
+            }
+        });
+        const double gaugeNs = NsPerEvent(threads, events, [&gauge](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                gauge.Set(static_cast<int64_t>(i));
+            }
+        });
+        const double histogramNs = NsPerEvent(threads, events, [&histogram](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                histogram.Record(i & 4095);
+            }
+        });
+        std::cout << "metrics/counter" << suffix << ": " << counterNs << " ns/event" << std::endl;
+        std::cout << "metrics/shared_atomic" << suffix << ": " << sharedNs << " ns/event" << std::endl;
+        std::cout << "metrics/gauge" << suffix << ": " << gaugeNs << " ns/event" << std::endl;
+        std::cout << "metrics/histogram" << suffix << ": " << histogramNs << " ns/event" << std::endl;
+
+        if (counter.Value() - before != events * threads) {
+            std::cerr << "metrics: counter lost events on " << threads << " threads" << std::endl;
+            result = -1;
+        }
+    }
+
+    const auto start = BenchClock::now();
+    const MetricsSnapshot snapshot = registry.Snapshot();
+    std::cout << "metrics/snapshot: " << SecondsSince(start) * 1e6 << " us" << std::endl;
+
+    const MetricSample* total = snapshot.Find("bench_events_total");
+    const MetricSample* latency = snapshot.Find("bench_latency_us");
+    if (!total || !latency || latency->histogram.count != counter.Value() || latency->histogram.max != 4095) {
+        std::cerr << "metrics: snapshot does not match the updates" << std::endl;
+        result = -1;
+    }
+    std::ostringstream json;
+    std::ostringstream prometheus;
+    WriteMetricsJson(snapshot, json);
+    WriteMetricsPrometheus(snapshot, prometheus);
+    const std::string count = std::to_string(counter.Value());
+    if (json.str().find("\"bench_events_total\":" + count) == std::string::npos ||
+        prometheus.str().find("\nbench_events_total " + count + "\n") == std::string::npos) {
+        std::cerr << "metrics: exports do not carry the counter" << std::endl;
+        result = -1;
+    }
+    return result;
+}
@@ -0,0 +1,153 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/SyncPairing.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The lookups Vis0 used before SyncPairing, kept to check and time against
+
+std::vector<size_t> LegacyIntersect(const std::vector<size_t>& a, const std::vector<size_t>& b) {
+    std::vector<size_t> result;
+    std::set<size_t> setA(a.begin(), a.end());
+    for (const auto& val : b) {
+        if (setA.find(val) != setA.end()) {
+            result.push_back(val);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+void LegacyMatchIdxs(std::vector<size_t>& start, std::vector<size_t>& stop) {
+    std::vector<size_t> newStop;
+    for (size_t s : start) {
+        bool foundMatch = false;
+        for (size_t j = 0; j < stop.size(); ++j) {
+            const size_t diff = stop[j] > s ? stop[j] - s : 0;
+            if (diff >= 1250 && diff <= 1750) {
+                newStop.push_back(stop[j]);
+                foundMatch = true;
+                break;
+            }
+        }
+        if (!foundMatch) {
+            newStop.push_back(s + 1488);
+        }
+    }
+    stop = newStop;
+}
+
+// analyzeData's per-SAV EAV search; only SAVs that have a later EAV are
+// asked, since the old loop fell back to EAV 0 otherwise
+std::vector<size_t> LegacyFirstAfter(const std::vector<size_t>& keys, const std::vector<size_t>& values) {
+    std::vector<size_t> result(keys.size(), values.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        for (size_t j = 0; j < values.size(); ++j) {
+            if (values[j] > keys[i]) {
+                result[i] = j;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+// SAV/EAV positions of a capture with the given number of lines: 1776 bits
+// per line, a vertical gap every 480 lines, and the occasional EAV lost or
+// late so the fallback paths run too
+void MakePositions(size_t lines, std::vector<size_t>& sav, std::vector<size_t>& eav) {
+    std::mt19937_64 rng(1);
+    size_t bit = 4096;
+    for (size_t i = 0; i < lines; ++i) {
+        if (i % 480 == 0) {
+            bit += 20 * 1776;
+        }
+        sav.push_back(bit);
+        const unsigned roll = static_cast<unsigned>(rng() % 1000);
+        if (roll >= 10) {
+            eav.push_back(bit + (roll < 15 ? 1760 : 1456));
+        }
+        bit += 1776;
+    }
+}
+
+void PrintPerLine(const std::string& name, size_t lines, double seconds) {
+    std::cout << "pairing/" << name << ": " << seconds * 1e9 / static_cast<double>(lines) << " ns/line" << std::endl;
+}
+
+template <typename Fn>
+double Time(Fn&& fn) {
+    const auto start = BenchClock::now();
+    fn();
+    return SecondsSince(start);
+}
+
+} // namespace
+
+// Usage: pairing [lines] [legacy lines]
+//
+// Pairs SAV and EAV positions for 1M lines (default) with the SyncPairing
+// merges, and the first 20000 (default) with the quadratic loops they
+// replace, whose cost per line grows with the capture. Both are reported in
+// ns per line and every merge result is checked against the old code on the
+// shared prefix and against binary search on the whole set.
+int RunPairingBench(int argc, char** argv) {
+    const size_t lines = (argc > 0) ? std::strtoull(argv[0], nullptr, 10) : 1000000;
+    size_t legacyLines = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 20000;
+    if (legacyLines > lines) {
+        legacyLines = lines;
+    }
+
+    std::vector<size_t> sav;
+    std::vector<size_t> eav;
+    MakePositions(lines, sav, eav);
+    int result = 0;
+
+    std::vector<size_t> after;
+    PrintPerLine("first_after", lines, Time([&]() { after = FirstAfter(sav, eav); }));
+    std::vector<size_t> start = sav;
+    std::vector<size_t> stop = eav;
+    PrintPerLine("match", lines, Time([&]() { MatchSyncPairs(start, stop); }));
+    std::vector<size_t> shifted(eav.size());
+    std::transform(eav.begin(), eav.end(), shifted.begin(), [](size_t bit) { return bit - 1456; });
+    std::vector<size_t> common;
+    PrintPerLine("intersect", lines, Time([&]() { common = IntersectSorted(sav, shifted); }));
+
+    for (size_t i = 0; i < sav.size(); ++i) {
+        const size_t first = static_cast<size_t>(std::upper_bound(eav.begin(), eav.end(), sav[i]) - eav.begin());
+        const auto next = std::lower_bound(eav.begin(), eav.end(), sav[i] + 1250);
+        const size_t partner = (next != eav.end() && *next <= sav[i] + 1750) ? *next : sav[i] + 1488;
+        if (after[i] != first || stop[i] != partner) {
+            std::cerr << "pairing: merge disagrees with binary search at line " << i << std::endl;
+            result = -1;
+            break;
+        }
+    }
+    std::cout << "pairing/lines: " << lines << " lines" << std::endl;
+
+    // The old loops on a prefix; EAVs past it are kept so every prefix SAV
+    // sees the same candidates
+    const std::vector<size_t> legacySav(sav.begin(), sav.begin() + static_cast<std::ptrdiff_t>(legacyLines));
+    std::vector<size_t> legacyAfter;
+    PrintPerLine("legacy_first_after", legacyLines, Time([&]() { legacyAfter = LegacyFirstAfter(legacySav, eav); }));
+    std::vector<size_t> legacyStart = legacySav;
+    std::vector<size_t> legacyStop = eav;
+    PrintPerLine("legacy_match", legacyLines, Time([&]() { LegacyMatchIdxs(legacyStart, legacyStop); }));
+    std::vector<size_t> legacyCommon;
+    PrintPerLine("legacy_intersect", lines, Time([&]() { legacyCommon = LegacyIntersect(sav, shifted); }));
+    std::cout << "pairing/legacy_lines: " << legacyLines << " lines" << std::endl;
+
+    if (!std::equal(legacyAfter.begin(), legacyAfter.end(), after.begin()) ||
+        !std::equal(legacyStop.begin(), legacyStop.end(), stop.begin()) || legacyCommon != common) {
+        std::cerr << "pairing: merge disagrees with the old loops" << std::endl;
+        result = -1;
+    }
+    return result;
+}
@@ -0,0 +1,125 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/Deinterleave.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const size_t kLineBytes = 178;           // Per channel
+const size_t kRowPixels = 4 * kLineBytes;
+const size_t kLineWords = kLineBytes + 1;  // Covers any bit offset
+const size_t kFrameRows = 480;
+const int kRepeats = 5;
+
+// What Vis0 did per line before FrameBuffer: gather each channel's payload
+// bit by bit out of its vector<bool>, then deal the bytes into the row
+void LegacyRow(const std::vector<std::vector<bool>>& channelBits, size_t bit, uint8_t* row) {
+    for (size_t c = 0; c < 4; ++c) {
+        for (size_t i = 0; i < kLineBytes; ++i) {
+            uint8_t byte = 0;
+            for (size_t b = 0; b < 8; ++b) {
+                if (channelBits[c][bit + i * 8 + b]) {
+                    byte |= static_cast<uint8_t>(0x80u >> b);
+                }
+            }
+            row[i * 4 + c] = byte;
+        }
+    }
+}
+
+template <typename Fn>
+double BestOf(Fn&& fn) {
+    double best = 1e30;
+    for (int repeat = 0; repeat < kRepeats; ++repeat) {
+        const auto start = BenchClock::now();
+        fn();
+        const double seconds = SecondsSince(start);
+        if (seconds < best) {
+            best = seconds;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+// Usage: row [lines]
+//
+// Builds 712-pixel display rows from capture words at random bit offsets:
+// with the legacy vector<bool> loops, and with each InterleaveChannels
+// kernel this CPU supports followed by CutRow. cut_row is CutRow alone on a
+// capture interleaved up front, which is all the parser does per line.
+// Rates are output MB/s into one frame's rows; every result is checked
+// against the legacy loops.
+int RunRowBench(int argc, char** argv) {
+    const size_t lines = (argc > 0) ? std::strtoull(argv[0], nullptr, 10) : 100000;
+
+    std::mt19937_64 rng(11);
+    std::vector<uint32_t> words(4 * 1024 * 1024);
+    for (auto& word : words) {
+        word = static_cast<uint32_t>(rng());
+    }
+    std::vector<std::vector<bool>> channelBits(4, std::vector<bool>(words.size() * 8));
+    for (size_t k = 0; k < words.size() * 8; ++k) {
+        const uint32_t word = words[k / 8];
+        for (size_t c = 0; c < 4; ++c) {
+            channelBits[c][k] = ((word >> (4 * (k % 8) + c)) & 1) != 0;
+        }
+    }
+    std::vector<size_t> offsets(lines);
+    for (auto& offset : offsets) {
+        offset = static_cast<size_t>(rng() % ((words.size() - kLineWords) * 8));
+    }
+
+    const double megabytes = lines * kRowPixels / (1024.0 * 1024.0);
+    std::vector<uint8_t> expected(lines * kRowPixels);
+    std::vector<uint8_t> out(lines * kRowPixels);
+    std::vector<uint8_t> frame(kFrameRows * kRowPixels);
+    int result = 0;
+
+    // Timed runs fill one frame's rows over and over, as FrameBuffer does;
+    // a last pass keeps every row for the check. The legacy loops go first
+    // and give the expected rows.
+    bool haveExpected = false;
+    const auto measure = [&](const std::string& name, auto&& buildRow) {
+        const double seconds = BestOf([&]() {
+            for (size_t i = 0; i < lines; ++i) {
+                buildRow(i, frame.data() + (i % kFrameRows) * kRowPixels);
+            }
+        });
+        std::cout << "row/" << name << ": " << megabytes / seconds << " MB/s" << std::endl;
+
+        std::vector<uint8_t>& dest = haveExpected ? out : expected;
+        for (size_t i = 0; i < lines; ++i) {
+            buildRow(i, dest.data() + i * kRowPixels);
+        }
+        if (haveExpected && out != expected) {
+            std::cerr << "row: " << name << " disagrees with the bit loops" << std::endl;
+            result = -1;
+        }
+        haveExpected = true;
+    };
+
+    measure("legacy", [&](size_t i, uint8_t* row) { LegacyRow(channelBits, offsets[i], row); });
+
+    std::vector<uint8_t> linePixels(4 * kLineWords);
+    const DeinterleaveKernel kernels[] = { DeinterleaveKernel::Scalar, DeinterleaveKernel::Avx2 };
+    for (DeinterleaveKernel kernel : kernels) {
+        if (!DeinterleaveKernelSupported(kernel)) {
+            continue;
+        }
+        measure(std::string("interleave_") + DeinterleaveKernelName(kernel), [&](size_t i, uint8_t* row) {
+            InterleaveChannelsWith(kernel, words.data() + offsets[i] / 8, kLineWords, linePixels.data());
+            CutRow(linePixels.data(), offsets[i] % 8, kLineBytes, row);
+        });
+    }
+
+    std::vector<uint8_t> pixels(words.size() * 4);
+    InterleaveChannels(words.data(), words.size(), pixels.data());
+    measure("cut_row", [&](size_t i, uint8_t* row) { CutRow(pixels.data(), offsets[i], kLineBytes, row); });
+    return result;
+}
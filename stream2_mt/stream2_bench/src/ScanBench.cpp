@@ -0,0 +1,140 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/CaptureScanner.h"
+#include "../../stream2_mt/include/Fx3PatternGenerator.h"
+#include "../../stream2_mt/include/MappedFile.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int kRepeats = 3;
+
+bool SameScan(const CaptureScan& a, const CaptureScan& b) {
+    if (a.marks.size() != b.marks.size() || a.lines.size() != b.lines.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.marks.size(); ++i) {
+        if (a.marks[i].bit != b.marks[i].bit || a.marks[i].code != b.marks[i].code) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < a.lines.size(); ++i) {
+        const LineSpan& x = a.lines[i];
+        const LineSpan& y = b.lines[i];
+        if (x.startBit != y.startBit || x.endBit != y.endBit || x.hasEav != y.hasEav || x.newFrame != y.newFrame) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// Usage: scan [capture file | MB] [max threads]
+//
+// Parses a whole capture with ScanCapture() on 1, 2, 4... threads up to the
+// core count and reports input MB/s, best of several runs. Without a file it
+// generates 256 MB of simulated video. Every result is checked against the
+// single-threaded scan, and the lines against the streaming LineParser.
+int RunScanBench(int argc, char** argv) {
+    MappedFile capture;
+    std::vector<uint32_t> generated;
+    const uint32_t* words = nullptr;
+    size_t count = 0;
+
+    const std::string source = (argc > 0) ? argv[0] : "256";
+    char* end = nullptr;
+    const unsigned long long megabytes = std::strtoull(source.c_str(), &end, 10);
+    if (end != source.c_str() && *end == '\0') {
+        generated.resize(static_cast<size_t>(megabytes) * 1024 * 1024 / 4);
+        Fx3PatternGenerator generator;
+        generator.Fill(reinterpret_cast<unsigned char*>(generated.data()), generated.size() * 4);
+        words = generated.data();
+        count = generated.size();
+    } else {
+        if (!capture.Open(source)) {
+            return -1;
+        }
+        words = reinterpret_cast<const uint32_t*>(capture.Data());
+        count = capture.Size() / 4;
+    }
+    if (count == 0) {
+        std::cerr << "scan: nothing to scan" << std::endl;
+        return -1;
+    }
+    const double megabytesIn = count * 4 / (1024.0 * 1024.0);
+
+    unsigned maxThreads = (argc > 1) ? static_cast<unsigned>(std::atoi(argv[1])) : std::thread::hardware_concurrency();
+    if (maxThreads == 0) {
+        maxThreads = 1;
+    }
+
+    int result = 0;
+    CaptureScan reference;
+    for (unsigned threads = 1;; threads *= 2) {
+        if (threads > maxThreads) {
+            threads = maxThreads;
+        }
+        CaptureScanConfig config;
+        config.threads = threads;
+
+        double best = 1e30;
+        CaptureScan scan;
+        for (int repeat = 0; repeat < kRepeats; ++repeat) {
+            const auto start = BenchClock::now();
+            scan = ScanCapture(words, count, config);
+            const double seconds = SecondsSince(start);
+            if (seconds < best) {
+                best = seconds;
+            }
+        }
+        std::cout << "scan/threads_" << threads << ": " << megabytesIn / best << " MB/s" << std::endl;
+
+        if (threads == 1) {
+            reference = std::move(scan);
+        } else if (!SameScan(scan, reference)) {
+            std::cerr << "scan: " << threads << " threads disagree with one" << std::endl;
+            result = -1;
+        }
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+    std::cout << "scan/lines: " << reference.lines.size() << " lines" << std::endl;
+
+    // The streaming parser, one acquisition buffer at a time, must agree
+    LineParser parser;
+    std::vector<ParsedLine> lines;
+    const size_t bufferWords = 65280 / 4;
+    size_t next = 0;
+    bool matches = true;
+    const auto compare = [&]() {
+        for (const ParsedLine& line : lines) {
+            if (next >= reference.lines.size()) {
+                matches = false;
+                break;
+            }
+            const LineSpan& want = reference.lines[next++];
+            matches = matches && line.startBit == want.startBit && line.endBit == want.endBit &&
+                      line.hasEav == want.hasEav && line.newFrame == want.newFrame;
+        }
+        lines.clear();
+    };
+    for (size_t offset = 0; offset < count && matches; offset += bufferWords) {
+        parser.Feed(words + offset, std::min<size_t>(bufferWords, count - offset), lines);
+        compare();
+    }
+    parser.Flush(lines);
+    compare();
+    if (!matches || next != reference.lines.size()) {
+        std::cerr << "scan: LineParser disagrees with ScanCapture" << std::endl;
+        result = -1;
+    }
+    return result;
+}
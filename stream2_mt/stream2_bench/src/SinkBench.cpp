@@ -0,0 +1,111 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/BufferManager.h"
+#include "../../stream2_mt/include/DirectFileSink.h"
+#include "../../stream2_mt/include/LatencyHistogram.h"
+#include "../../stream2_mt/include/StreamFileSink.h"
+#include "../../stream2_mt/include/UringFileSink.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+
+const size_t kBufferSize = 512 * 512;  // DataStreamer's default transfer
+const int kNumBuffers = 8;
+
+// Pushes totalBytes through one sink the way DiskWriterThread does: buffers
+// come off a BufferManager built with the sink's allocator, go to Submit()
+// and come back through the release callback. Prints sustained MB/s
+// (including Close) and Submit() latency.
+bool MeasureSink(FileSink& sink, const std::string& path, size_t totalBytes) {
+    BufferManager manager(kBufferSize, kNumBuffers, sink.Allocator());
+
+    // Give every buffer distinct contents once, outside the timed loop
+    for (int i = 0; i < kNumBuffers; ++i) {
+        Buffer* buffer = manager.GetEmptyBuffer();
+        for (size_t j = 0; j < kBufferSize; ++j) {
+            buffer->data[j] = static_cast<unsigned char>(i * 31 + j);
+        }
+        manager.QueueFullBuffer(buffer);
+        manager.ReturnEmptyBuffer(manager.GetFullBuffer());
+    }
+
+    if (!sink.Open(path, totalBytes)) {
+        return false;
+    }
+
+    const FileSink::ReleaseFn release = [&manager](Buffer* buffer) {
+        manager.ReturnEmptyBuffer(buffer);
+    };
+
+    LatencyHistogram latency;
+    const auto start = BenchClock::now();
+    for (size_t written = 0; written < totalBytes; written += kBufferSize) {
+        // Every buffer may be in flight; wait for the disk to return one
+        Buffer* buffer = manager.GetEmptyBuffer();
+        while (!buffer && sink.Reap(true)) {
+            buffer = manager.GetEmptyBuffer();
+        }
+        if (!buffer) {
+            sink.Close();
+            return false;
+        }
+
+        const auto writeStart = BenchClock::now();
+        const bool ok = sink.Submit(buffer, kBufferSize, release);
+        latency.Record(SecondsSince(writeStart) * 1e6);
+        if (!ok) {
+            sink.Close();
+            return false;
+        }
+    }
+    const bool closed = sink.Close();
+    const double seconds = SecondsSince(start);
+
+    const std::string name = std::string("sink/") + sink.Name();
+    std::cout << name << "_rate: " << totalBytes / (1024.0 * 1024.0) / seconds << " MB/s" << std::endl;
+    std::cout << name << "_submit_p50: " << latency.Percentile(50) << " us" << std::endl;
+    std::cout << name << "_submit_p99: " << latency.Percentile(99) << " us" << std::endl;
+    std::cout << name << "_submit_max: " << latency.Max() << " us" << std::endl;
+    return closed;
+}
+
+} // namespace
+
+// Usage: sink [MB] [scratch file]
+//
+// The ofstream numbers only show the page cache unless the run is larger
+// than the kernel lets dirty data grow; use a few GB for a fair comparison.
+int RunSinkBench(int argc, char** argv) {
+    const size_t megabytes = (argc > 0) ? std::strtoull(argv[0], nullptr, 10) : 1024;
+    const std::string path = (argc > 1) ? argv[1] : "stream2_bench_sink.bin";
+    const size_t totalBytes = megabytes * 1024 * 1024;
+
+    int result = 0;
+    {
+        StreamFileSink sink;
+        if (!MeasureSink(sink, path, totalBytes)) {
+            result = -1;
+        }
+    }
+    {
+        DirectFileSink sink;
+        if (!MeasureSink(sink, path, totalBytes)) {
+            result = -1;
+        }
+    }
+#ifdef __linux__
+    {
+        UringFileSink sink;
+        if (!MeasureSink(sink, path, totalBytes)) {
+            result = -1;
+        }
+    }
+#endif
+
+    std::remove(path.c_str());
+    return result;
+}
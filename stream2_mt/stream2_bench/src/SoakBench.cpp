@@ -0,0 +1,99 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/FramePool.h"
+#include "../../stream2_mt/include/FrameViewer.h"
+#include "../../stream2_mt/include/LatencyHistogram.h"
+#include "../../stream2_mt/include/LineParser.h"
+#include "../../stream2_mt/include/SimulatedFx3Transport.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Usage: soak [seconds] [MB/s] [depth]
+//
+// The whole live path held at a wire rate: the FX3 simulator producing video
+// at MB/s, Vis0's acquisition buffers reaped in order and parsed straight
+// into pool frames, and a headless viewer rendering and presenting them.
+// Fails if the host ever left the device without a queued transfer long
+// enough for it to drop data, or if nothing reached the surface. The share
+// of the wire rate dropped is reported in %, so a baseline comparison flags
+// a run that stopped keeping up even where the exit code is not checked.
+int RunSoakBench(int argc, char** argv) {
+    const double seconds = (argc > 0) ? std::atof(argv[0]) : 10.0;
+    const double rate = (argc > 1) ? std::atof(argv[1]) : 297.0;
+    const int depth = (argc > 2) ? std::atoi(argv[2]) : 4;
+    const size_t bufferBytes = 65280;  // Vis0's acquisition buffer
+
+    SimulatorConfig config;
+    config.bytesPerSecond = rate * 1024 * 1024;
+    SimulatedFx3Transport transport(config);
+    if (!transport.Open() || !transport.Configure(depth, bufferBytes)) {
+        std::cerr << "soak: cannot set up the simulator" << std::endl;
+        return -1;
+    }
+
+    FramePool pool(3);
+    FramePublisher publisher(pool);
+    HeadlessSurface surface;
+    FrameViewer viewer(pool, surface);
+    if (!viewer.Start()) {
+        std::cerr << "soak: viewer did not start" << std::endl;
+        return -1;
+    }
+
+    std::vector<std::vector<unsigned char>> buffers(depth, std::vector<unsigned char>(bufferBytes));
+    for (int slot = 0; slot < depth; ++slot) {
+        transport.Submit(slot, buffers[slot].data(), bufferBytes);
+    }
+
+    LineParser parser;
+    LatencyHistogram feedLatency;
+    size_t received = 0;
+    int slot = 0;
+    int result = 0;
+    const auto start = BenchClock::now();
+    while (SecondsSince(start) < seconds) {
+        size_t transferred = 0;
+        if (transport.Reap(slot, 1000, transferred) != TransferStatus::Completed) {
+            std::cerr << "soak: transfer on slot " << slot << " did not complete" << std::endl;
+            result = -1;
+            break;
+        }
+        const auto feedStart = BenchClock::now();
+        parser.Feed(reinterpret_cast<const uint32_t*>(buffers[slot].data()), transferred / 4, publisher);
+        feedLatency.Record(SecondsSince(feedStart) * 1e6);
+        received += transferred;
+
+        transport.Submit(slot, buffers[slot].data(), bufferBytes);
+        slot = (slot + 1) % depth;
+    }
+    const double elapsed = SecondsSince(start);
+    transport.Abort();
+    parser.Flush(publisher);
+    publisher.Finish();
+    viewer.Stop();
+
+    const FrameViewerStats view = viewer.Stats();
+    const uint64_t dropped = transport.DroppedBytes();
+    std::cout << "soak/rate: " << received / (1024.0 * 1024.0) / elapsed << " MB/s" << std::endl;
+    std::cout << "soak/dropped: " << dropped << " bytes" << std::endl;
+    std::cout << "soak/dropped_share: " << (dropped * 100.0) / std::max<double>(static_cast<double>(received + dropped), 1.0)
+              << " %" << std::endl;
+    std::cout << "soak/feed_p50: " << feedLatency.Percentile(50) << " us" << std::endl;
+    std::cout << "soak/feed_p99: " << feedLatency.Percentile(99) << " us" << std::endl;
+    std::cout << "soak/feed_max: " << feedLatency.Max() << " us" << std::endl;
+    std::cout << "soak/produced: " << view.produced / view.seconds << " fps" << std::endl;
+    std::cout << "soak/presented: " << view.presented / view.seconds << " fps" << std::endl;
+    std::cout << "soak/lost_lines: " << publisher.LostLines() << " lines" << std::endl;
+
+    if (dropped > 0) {
+        std::cerr << "soak: the pipeline did not keep up with " << rate << " MB/s" << std::endl;
+        result = -1;
+    }
+    if (view.presented == 0) {
+        std::cerr << "soak: no frame reached the surface" << std::endl;
+        result = -1;
+    }
+    return result;
+}
@@ -0,0 +1,112 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/FileReplayTransport.h"
+#include "../../stream2_mt/include/Fx3PatternGenerator.h"
+#include "../../stream2_mt/include/SimulatedFx3Transport.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Keeps every slot of transport queued and reaps whichever finishes first
+// until totalBytes have come in, with nothing behind it. Reports transfers
+// and MB/s.
+bool MeasureReaps(BulkInTransport& transport, const std::string& name, size_t totalBytes,
+                  int depth, size_t transferSize) {
+    // File replay announces the capture on stdout; keep the suite output to
+    // measurement lines
+    std::ostringstream openLog;
+    std::streambuf* coutBuffer = std::cout.rdbuf(openLog.rdbuf());
+    const bool opened = transport.Open();
+    std::cout.rdbuf(coutBuffer);
+    if (!opened || !transport.Configure(depth, transferSize)) {
+        std::cerr << "transport: cannot set up " << transport.Name() << std::endl;
+        return false;
+    }
+
+    std::vector<std::vector<unsigned char>> buffers(depth, std::vector<unsigned char>(transferSize));
+    for (int slot = 0; slot < depth; ++slot) {
+        if (!transport.Submit(slot, buffers[slot].data(), transferSize)) {
+            std::cerr << "transport: " << transport.Name() << " refused a transfer" << std::endl;
+            return false;
+        }
+    }
+
+    size_t received = 0;
+    uint64_t transfers = 0;
+    const auto start = BenchClock::now();
+    while (received < totalBytes) {
+        int slot = -1;
+        size_t transferred = 0;
+        if (transport.ReapAny(1000, slot, transferred) != TransferStatus::Completed ||
+            !transport.Submit(slot, buffers[slot].data(), transferSize)) {
+            std::cerr << "transport: " << transport.Name() << " stopped after " << transfers << " transfers" << std::endl;
+            transport.Abort();
+            return false;
+        }
+        received += transferred;
+        ++transfers;
+    }
+    const double seconds = SecondsSince(start);
+    transport.Abort();
+    transport.Close();
+
+    std::cout << "transport/" << name << "_reaps: " << transfers / seconds << " transfers/s" << std::endl;
+    std::cout << "transport/" << name << "_rate: " << received / (1024.0 * 1024.0) / seconds << " MB/s" << std::endl;
+    return true;
+}
+
+} // namespace
+
+// Usage: transport [MB] [depth] [transfer KB] [scratch file]
+//
+// Raw submit/reap rate of the transports that need no board: the FX3
+// simulator left unpaced, and file replay of a looped scratch capture. This
+// is the ceiling everything behind the transport has to stay under.
+int RunTransportBench(int argc, char** argv) {
+    const size_t megabytes = (argc > 0) ? std::strtoull(argv[0], nullptr, 10) : 1024;
+    const int depth = (argc > 1) ? std::atoi(argv[1]) : 4;
+    const size_t transferSize = ((argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 64) * 1024;
+    const std::string path = (argc > 3) ? argv[3] : "stream2_bench_replay.bin";
+    const size_t totalBytes = megabytes * 1024 * 1024;
+
+    int result = 0;
+    {
+        SimulatorConfig config;
+        config.pattern = SimulatorPattern::Counter;  // Cheapest to generate
+        config.bytesPerSecond = 0.0;
+        SimulatedFx3Transport transport(config);
+        if (!MeasureReaps(transport, "simulator", totalBytes, depth, transferSize)) {
+            result = -1;
+        }
+    }
+
+    // 16 MB of video, replayed round and round
+    {
+        std::vector<unsigned char> video(16 * 1024 * 1024);
+        Fx3PatternGenerator generator;
+        generator.Fill(video.data(), video.size());
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(video.data()), static_cast<std::streamsize>(video.size()));
+        if (!file) {
+            std::cerr << "transport: cannot write " << path << std::endl;
+            return -1;
+        }
+    }
+    {
+        ReplayConfig config;
+        config.loop = true;
+        FileReplayTransport transport(path, config);
+        if (!MeasureReaps(transport, "replay", totalBytes, depth, transferSize)) {
+            result = -1;
+        }
+    }
+
+    std::remove(path.c_str());
+    return result;
+}
@@ -0,0 +1,121 @@
+#include "../include/Bench.h"
+#include "../../stream2_mt/include/FrameViewer.h"
+#include "../../stream2_mt/include/LatencyHistogram.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int kPoolFrames = 3;  // As in Vis0's live view
+const int kFrameRows = 480;
+
+// A headless surface that takes presentMs per present, like a blit to a
+// window on a busy desktop
+class SlowSurface : public HeadlessSurface {
+public:
+    explicit SlowSurface(int presentMs) : m_presentMs(presentMs) {}
+
+    void Present(const ViewerTexture& texture) override {
+        HeadlessSurface::Present(texture);
+        std::this_thread::sleep_for(std::chrono::milliseconds(m_presentMs));
+    }
+
+private:
+    int m_presentMs;
+};
+
+// Publishes frames at fps through a viewer on surface (or none) and reports
+// how long each hand-off took the producer and what reached the surface
+int Measure(const std::string& name, int frames, double fps, HeadlessSurface* surface) {
+    FramePool pool(kPoolFrames);
+    std::unique_ptr<FrameViewer> viewer;
+    if (surface) {
+        viewer = std::make_unique<FrameViewer>(pool, *surface);
+        if (!viewer->Start()) {
+            std::cerr << "viewer: " << name << " surface did not open" << std::endl;
+            return -1;
+        }
+    }
+
+    std::vector<uint8_t> pixels(FrameBuffer::ROW_PIXELS, 0x80);
+    LineView line = {};
+    line.pixels = pixels.data();
+    line.bytes = pixels.size() / 4;
+
+    // Acquire + fill + publish per frame, paced to fps
+    LatencyHistogram handoff;
+    int lost = 0;
+    const auto period = std::chrono::duration_cast<BenchClock::duration>(std::chrono::duration<double>(1.0 / fps));
+    auto next = BenchClock::now();
+    for (int i = 1; i <= frames; ++i) {
+        std::this_thread::sleep_until(next);
+        next += period;
+
+        const auto start = BenchClock::now();
+        FrameBuffer* frame = pool.Acquire();
+        if (!frame) {
+            ++lost;
+            continue;
+        }
+        for (int y = 0; y < kFrameRows; ++y) {
+            frame->AppendLine(line);
+        }
+        frame->SetFrameNumber(i);
+        pool.Publish(frame);
+        handoff.Record(SecondsSince(start) * 1e6);
+    }
+
+    std::cout << "viewer/" << name << "_handoff_p50: " << handoff.Percentile(50) << " us" << std::endl;
+    std::cout << "viewer/" << name << "_handoff_max: " << handoff.Max() << " us" << std::endl;
+    std::cout << "viewer/" << name << "_lost: " << lost << " frames" << std::endl;
+    if (!viewer) {
+        return lost == 0 ? 0 : -1;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));  // Last frame to the surface
+    viewer->Stop();
+    const FrameViewerStats stats = viewer->Stats();
+    std::cout << "viewer/" << name << "_produced: " << stats.produced / stats.seconds << " fps" << std::endl;
+    std::cout << "viewer/" << name << "_presented: " << stats.presented / stats.seconds << " fps" << std::endl;
+
+    int result = 0;
+    if (lost > 0) {
+        std::cerr << "viewer: " << name << " held up the producer" << std::endl;
+        result = -1;
+    }
+    if (surface->Offscreen().frameNumber != frames) {
+        std::cerr << "viewer: " << name << " never presented the last frame" << std::endl;
+        result = -1;
+    }
+    return result;
+}
+
+} // namespace
+
+// Usage: viewer [frames] [fps] [slow present ms]
+//
+// A producer publishes frames at a steady rate into a three-frame pool, as
+// the live parser does: with no viewer, with a FrameViewer on a headless
+// 60 Hz surface, and with one whose presents take 40 ms. Reports what each
+// hand-off cost the producer and the produced vs presented frame rates. The
+// producer must never find the pool empty, and the last frame must reach
+// the surface however slow it is.
+int RunViewerBench(int argc, char** argv) {
+    const int frames = (argc > 0) ? std::atoi(argv[0]) : 300;
+    const double fps = (argc > 1) ? std::atof(argv[1]) : 240.0;
+    const int slowMs = (argc > 2) ? std::atoi(argv[2]) : 40;
+
+    int result = Measure("none", frames, fps, nullptr);
+
+    HeadlessSurface headless(60.0);
+    result |= Measure("headless", frames, fps, &headless);
+
+    SlowSurface slow(slowMs);
+    result |= Measure("slow", frames, fps, &slow);
+    return result;
+}
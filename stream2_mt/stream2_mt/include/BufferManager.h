@@ -1,19 +1,41 @@
 #pragma once
 
-#include <queue>
-#include <mutex>
 #include <vector>
 #include <memory>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+
+#include "EventCount.h"
+#include "SpscRing.h"
+
+// Where buffer memory comes from. Left empty, buffers live on the heap;
+// transports that need special memory (e.g. usbfs DMA mappings) supply their
+// own pair. allocate may return nullptr to fall back to the heap.
+struct BufferAllocator {
+    std::function<unsigned char*(size_t)> allocate;
+    std::function<void(unsigned char*, size_t)> release;
+};
 
 struct Buffer {
-    std::unique_ptr<unsigned char[]> data;
+    std::unique_ptr<unsigned char[], std::function<void(unsigned char*)>> data;
     size_t size;
     size_t bytesUsed;
+    uint64_t sequence;  // Submission order, set by the reader
 };
 
+// Hands buffers between exactly one USB reader and one disk writer.
+//
+// Threading contract (both rings are single-producer/single-consumer):
+//   reader thread: GetEmptyBuffer / WaitForEmptyBuffer, QueueFullBuffer
+//   writer thread: GetFullBuffer / WaitForFullBuffer, ReturnEmptyBuffer
 class BufferManager {
 public:
-    BufferManager(size_t bufferSize, int numBuffers);
+    // Far deeper than any transfer queue; a bigger count is a caller bug
+    static constexpr int MAX_BUFFERS = 4096;
+
+    BufferManager(size_t bufferSize, int numBuffers,
+                  const BufferAllocator& allocator = BufferAllocator());
     ~BufferManager();
 
     Buffer* GetEmptyBuffer();
@@ -21,16 +43,26 @@ public:
     Buffer* GetFullBuffer();
     void ReturnEmptyBuffer(Buffer* buffer);
 
+    // Blocking variants. Both return nullptr on timeout or after WakeAll().
+    Buffer* WaitForEmptyBuffer(std::chrono::microseconds timeout);
+    Buffer* WaitForFullBuffer(std::chrono::microseconds timeout);
+
+    // Kicks any thread blocked in WaitFor*Buffer, e.g. on shutdown.
+    void WakeAll();
+
     bool HasEmptyBuffers() const;
     bool HasFullBuffers() const;
 
+    // Puts every buffer back on the empty ring. Only call while neither the
+    // reader nor the writer is running.
+    void Reset();
+
 private:
-    std::queue<Buffer*> m_emptyBuffers;
-    std::queue<Buffer*> m_fullBuffers;
+    SpscRing<Buffer*> m_emptyBuffers;
+    SpscRing<Buffer*> m_fullBuffers;
+    EventCount m_emptyReady;
+    EventCount m_fullReady;
     std::vector<std::unique_ptr<Buffer>> m_allBuffers;
 
-    mutable std::mutex m_emptyMutex;
-    mutable std::mutex m_fullMutex;
-
     const size_t m_bufferSize;
-};
\ No newline at end of file
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "BufferManager.h"
+
+enum class TransferStatus {
+    Completed,  // bytesTransferred is valid (may be short)
+    Timeout,    // still in flight; reap again or Abort()
+    Aborted,    // cancelled by Abort(); the slot is idle again
+    Failed      // transfer error, or nothing was submitted on the slot
+};
+
+// Asynchronous bulk-IN endpoint with submit/reap semantics.
+//
+// The caller owns the memory. Configure() sets up a fixed number of slots;
+// each slot holds at most one transfer in flight. Submit() queues a read into
+// a slot, Reap() waits for that slot to finish and ReapAny() for whichever
+// slot finishes first. Buffers handed to Submit()
+// must not be touched until Reap()/ReapAny() has reported the slot, or
+// until Abort() returns.
+//
+// All calls are made from the acquisition thread.
+class BulkInTransport {
+public:
+    virtual ~BulkInTransport() = default;
+
+    virtual bool Open() = 0;
+    virtual void Close() = 0;
+    virtual bool IsOpen() const = 0;
+
+    virtual bool Configure(int numSlots, size_t transferSize) = 0;
+    virtual bool Submit(int slot, unsigned char* data, size_t length) = 0;
+    virtual TransferStatus Reap(int slot, uint32_t timeoutMs, size_t& bytesTransferred) = 0;
+
+    // Waits for whichever submitted transfer finishes first and reports its
+    // slot. Returns Timeout if none did, or Failed with slot -1 if nothing
+    // was submitted.
+    virtual TransferStatus ReapAny(uint32_t timeoutMs, int& slot, size_t& bytesTransferred) = 0;
+
+    // Cancels every in-flight transfer and waits until the hardware has let
+    // go of the buffers. Reaping a cancelled slot afterwards yields Aborted.
+    virtual void Abort() = 0;
+
+    // Memory the transfer buffers should come from. Valid after Open(); the
+    // default (empty) allocator means ordinary heap memory is fine.
+    virtual BufferAllocator Allocator() { return BufferAllocator(); }
+
+    // Bytes the source produced that never reached the host, where the
+    // backend can tell (the simulator can; real endpoints report 0).
+    virtual uint64_t DroppedBytes() const { return 0; }
+
+    virtual size_t MaxPacketSize() const = 0;
+    virtual const char* Name() const = 0;
+};
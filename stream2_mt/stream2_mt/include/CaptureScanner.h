@@ -0,0 +1,30 @@
+#pragma once
+
+#include "LineParser.h"
+#include "SyncScanner.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct CaptureScanConfig {
+    unsigned threads = 0;                 // 0 = one per hardware thread
+    size_t chunkWords = 4 * 1024 * 1024;  // 16 MB of capture per work item
+};
+
+// Channel 0 sync codes and lines of a whole capture
+struct CaptureScan {
+    std::vector<SyncMark> marks;  // Every sync code, in stream order
+    std::vector<LineSpan> lines;  // The lines LineParser would emit
+};
+
+// Parses a saved capture on several threads.
+//
+// The capture is cut into chunks that worker threads take in turn. Each
+// chunk is scanned on its own, starting a few words early so a code that
+// begins in the previous chunk is still seen whole; a code belongs to the
+// chunk holding its last byte, so each one is reported exactly once. The
+// chunks' marks are joined in order and paired in one LinePairer pass, which
+// is cheap next to the scan. The result is the same as a sequential scan
+// whatever the thread count or chunk size.
+CaptureScan ScanCapture(const uint32_t* words, size_t count, const CaptureScanConfig& config = CaptureScanConfig());
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct ClaheConfig {
+    int tileSize = 32;        // Side of each contextual region, pixels; 8..128
+    double clipLimit = 3.0;   // Histogram bin cap in multiples of an even spread; 0 = no limit
+    unsigned threads = 0;     // Tile rows worked on at once; 0 = one per hardware thread
+};
+
+// Contrast-limited adaptive histogram equalization of 8-bit gray images.
+//
+// Each tileSize x tileSize tile gets its own equalizing LUT from its
+// histogram, with bins above the clip limit cut and the excess spread over
+// all bins so flat areas do not turn into amplified noise. Every pixel is
+// then mapped through the LUTs of the four tiles around it, weighted by
+// distance to their centres, so there are no seams at tile edges.
+//
+// Histograms are counted into four 16-bit sub-histograms eight pixels per
+// load, so runs of one value do not stall on the same counter, and merged,
+// clipped and summed into the LUT with SIMD where the CPU has it. The four
+// LUTs around each cell are then packed into one 32-bit word per input
+// value, so mapping a pixel is a single load and its blend a few
+// multiplies, eight pixels at a time with AVX2.
+//
+// Tile rows are shared out to worker threads, started by the first Apply()
+// and kept as long as the engine, so an engine that never equalizes costs
+// none. All scratch memory is kept and only ever grown, so Apply() on frames
+// of one size allocates nothing after the first. One thread may call Apply()
+// at a time.
+class ClaheEngine {
+public:
+    explicit ClaheEngine(const ClaheConfig& config = ClaheConfig());
+    ~ClaheEngine();
+
+    ClaheEngine(const ClaheEngine&) = delete;
+    ClaheEngine& operator=(const ClaheEngine&) = delete;
+
+    // Equalizes height rows of width pixels, no padding between rows, in place
+    void Apply(uint8_t* pixels, int width, int height);
+
+    const ClaheConfig& Config() const { return m_config; }
+
+private:
+    enum class Phase { Luts, Quads, Map };
+
+    void Layout(int width, int height);
+    void RunJob(Phase phase, int tileRow);
+    void BuildLuts(int tileRow);
+    void BuildQuads(int tileRow);
+    void MapRows(int tileRow);
+    void Parallel(Phase phase, int jobs);
+    void DrainJobs();
+    void WorkerLoop();
+
+    ClaheConfig m_config;
+    unsigned m_threads;  // Including the one calling Apply()
+
+    // The frame being worked on
+    uint8_t* m_pixels;
+    int m_width;
+    int m_height;
+    int m_tilesX;
+    int m_tilesY;
+
+    std::vector<uint8_t> m_luts;          // 256 entries per tile, row-major by tile
+    std::vector<uint32_t> m_quads;        // Per tile: its LUT and those right, below and below right, byte by byte
+    std::vector<uint32_t> m_column;       // Per column: offset of the left tile's quads
+    std::vector<uint32_t> m_rightWeight;  // Per column: weight of the right tile, 0..256
+
+    // Workers, woken once per phase
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    uint64_t m_generation;
+    size_t m_busy;
+    bool m_quit;
+    Phase m_phase;
+    int m_jobs;
+    std::atomic<int> m_nextJob;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+// x86-64 builds carry AVX2 and BMI2 kernels next to the portable ones and pick
+// between them at runtime
+#if defined(__x86_64__) || defined(_M_X64)
+#define CPU_X86 1
+#endif
+
+// MSVC emits any intrinsic without per-function opt-in; GCC and Clang need
+// the target named on the function that uses it
+#if defined(_MSC_VER) && !defined(__clang__)
+#define TARGET_AVX2
+#define TARGET_BMI2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_BMI2 __attribute__((target("bmi2")))
+#endif
+
+// Whether this CPU and OS can run AVX2 or BMI2 code. CPUID runs only once,
+// so they are cheap enough to check per call; always false off x86-64.
+bool CpuHasAvx2();
+bool CpuHasBmi2();
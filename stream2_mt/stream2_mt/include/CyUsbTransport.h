@@ -0,0 +1,71 @@
+#pragma once
+
+#ifdef _WIN32
+
+// Windows headers must come before Cypress headers
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+// Prevent Windows USB definitions from conflicting with Cypress
+#define _USB_H_
+#define __USB_H__
+#define _WINUSB_H_
+#define __WINUSB_H__
+
+#include <setupapi.h>     // Required for Windows Setup API
+
+// Now we can include Cypress headers
+#include "CyAPI.h"
+
+#include <memory>
+#include <vector>
+
+#include "BulkInTransport.h"
+
+// BulkInTransport on top of the Cypress CyAPI driver (FX3 bulk-IN endpoint).
+class CyUsbTransport : public BulkInTransport {
+public:
+    explicit CyUsbTransport(int deviceIndex = 0);
+    ~CyUsbTransport() override;
+
+    bool Open() override;
+    void Close() override;
+    bool IsOpen() const override { return m_bulkEndpoint != nullptr; }
+
+    bool Configure(int numSlots, size_t transferSize) override;
+    bool Submit(int slot, unsigned char* data, size_t length) override;
+    TransferStatus Reap(int slot, uint32_t timeoutMs, size_t& bytesTransferred) override;
+    TransferStatus ReapAny(uint32_t timeoutMs, int& slot, size_t& bytesTransferred) override;
+    void Abort() override;
+
+    size_t MaxPacketSize() const override;
+    const char* Name() const override { return "CyAPI"; }
+
+private:
+    struct Slot {
+        OVERLAPPED overlapped;
+        UCHAR* context;        // Returned by BeginDataXfer, released by FinishDataXfer
+        unsigned char* data;
+        LONG length;
+        bool inFlight;
+        bool aborted;
+    };
+
+    bool Finish(Slot& slot, size_t& bytesTransferred);
+    void ReleaseSlots();
+
+    int m_deviceIndex;
+    std::unique_ptr<CCyUSBDevice> m_usbDevice;
+    CCyBulkEndPoint* m_bulkEndpoint;
+    std::vector<Slot> m_slots;
+
+    // Scratch for ReapAny(); the wait list starts after the last slot reaped
+    // so a busy low-numbered slot cannot starve the others
+    std::vector<HANDLE> m_waitHandles;
+    std::vector<int> m_waitSlots;
+    int m_nextWaitSlot;
+
+    static constexpr ULONG ENDPOINT_TIMEOUT = 10000;  // 10 second timeout
+};
+
+#endif // _WIN32
@@ -1,69 +1,91 @@
 #pragma once
 
-// Windows headers must come before Cypress headers
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
-
-// Prevent Windows USB definitions from conflicting with Cypress
-#define _USB_H_
-#define __USB_H__
-#define _WINUSB_H_
-#define __WINUSB_H__
-
-#include <setupapi.h>     // Required for Windows Setup API
-
-// Now we can include Cypress headers
-#include "CyAPI.h"
-
 // Standard library includes
-#include <queue>
-#include <mutex>
-#include <condition_variable>
 #include <thread>
 #include <memory>
-#include <fstream>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "BulkInTransport.h"
+#include "FileSink.h"
+#include "LatencyHistogram.h"
+#include "Metrics.h"
 
 class BufferManager;
 
 class DataStreamer {
 public:
-    DataStreamer();
+    explicit DataStreamer(std::unique_ptr<BulkInTransport> transport);
     ~DataStreamer();
 
-    bool Initialize(size_t totalBytes);
+    // Queue depth (1..BufferManager::MAX_BUFFERS) and per-transfer size; call
+    // before Initialize(). bufferSize is rounded down to a multiple of 4 bytes.
+    bool SetQueueConfig(int numBuffers, size_t bufferSize);
+    int NumBuffers() const { return m_numBuffers; }
+    size_t BufferSize() const { return m_bufferSize; }
+
+    // Disk writer backend; call before Initialize(). Defaults to StreamFileSink.
+    bool SetFileSink(std::unique_ptr<FileSink> sink);
+    const char* FileSinkName() const { return m_sink ? m_sink->Name() : "none"; }
+
+    bool Initialize(size_t totalBytes, const std::string& outputPath);
     bool StartStreaming();
     void StopStreaming();
     bool IsComplete() const { return m_totalBytesWritten >= m_targetBytes; }
+    bool IsRunning() const { return m_running; }
+
+    // Safe to read from any thread while streaming; transfers in flight and
+    // timeouts are the usb_in_flight and usb_timeouts_total metrics
+    size_t BytesWritten() const { return m_totalBytesWritten; }
+
+    // Time spent in FileSink::Submit() per buffer (just the queueing for
+    // asynchronous sinks); read after StopStreaming()
+    const LatencyHistogram& WriteLatency() const { return m_writeLatency; }
 
 private:
     void UsbReaderThread();
     void DiskWriterThread();
 
     // USB device management
-    std::unique_ptr<CCyUSBDevice> m_usbDevice;
-    CCyBulkEndPoint* m_bulkEndpoint;
+    std::unique_ptr<BulkInTransport> m_transport;
 
     // Threading components
     std::unique_ptr<std::thread> m_readerThread;
     std::unique_ptr<std::thread> m_writerThread;
-    std::mutex m_mutex;
-    std::condition_variable m_dataReady;
     std::atomic<bool> m_running;
 
     // Buffer management
     std::unique_ptr<BufferManager> m_bufferManager;
 
     // File handling
-    std::ofstream m_outFile;
+    std::unique_ptr<FileSink> m_sink;
+    LatencyHistogram m_writeLatency;  // Writer thread only
+
+    // Queue shape, DEFAULT_* unless SetQueueConfig() says otherwise
+    int m_numBuffers;
+    size_t m_bufferSize;
 
     // Updated constants for better performance
-    static constexpr size_t BUFFER_SIZE = (512 * 512) & ~0x3;  // Aligned to 4-byte boundary
-    static constexpr int NUM_BUFFERS = 4;  // Reduced from 8 to 4 for optimal performance
-    static constexpr size_t FLUSH_THRESHOLD = 8 * 1024 * 1024;  // Flush every 8MB
-    static constexpr DWORD USB_TIMEOUT = 10000;  // 10 second timeout
+    static constexpr size_t DEFAULT_BUFFER_SIZE = (512 * 512) & ~0x3;  // Aligned to 4-byte boundary
+    static constexpr int DEFAULT_NUM_BUFFERS = 4;  // Reduced from 8 to 4 for optimal performance
+    static constexpr uint32_t USB_TIMEOUT = 10000;  // 10 second timeout
+    static constexpr uint32_t REARM_POLL = 1;  // ms; reap timeout while a slot waits for a buffer
+    static constexpr std::chrono::milliseconds WRITER_WAIT{ 100 };  // Re-check m_running this often when idle (both threads)
     
     // Track total bytes transferred
     size_t m_targetBytes;
     std::atomic<size_t> m_totalBytesWritten;
+
+    // In MetricsRegistry::Global()
+    MetricCounter& m_usbCompletions;
+    MetricCounter& m_usbBytes;
+    MetricCounter& m_usbShortTransfers;
+    MetricCounter& m_usbFailedTransfers;
+    MetricCounter& m_usbTimeouts;
+    MetricGauge& m_usbInFlight;
+    MetricGauge& m_writerQueue;
+    MetricCounter& m_diskBytes;
+    MetricHistogram& m_diskSubmitUs;
 };
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Splits the 4-channel bit-interleaved stream into four packed channels in
+// one pass. Each input word gives one byte per channel, in the same layout
+// as ExtractChannel() (earliest channel bit in the MSB).
+//
+// The per-word work is a fixed bit transpose: reverse the nibble order, then
+// four delta swaps move bit 4j + c to bit 8c + j. The scalar kernel does this
+// on one word, the AVX2 kernel on eight words per instruction and then
+// regroups the bytes by channel with byte shuffles; the BMI2 kernel uses
+// PEXT instead. The fastest kernel the CPU supports is picked at runtime.
+enum class DeinterleaveKernel {
+    Scalar,
+    Bmi2,
+    Avx2,
+};
+
+// channels[c] receives count bytes for channel c
+void DeinterleaveChannels(const uint32_t* words, size_t count, uint8_t* const channels[4]);
+
+// Specific kernel, for benchmarks and cross-checks. Returns false if this
+// CPU or build cannot run it.
+bool DeinterleaveChannelsWith(DeinterleaveKernel kernel, const uint32_t* words, size_t count,
+                              uint8_t* const channels[4]);
+
+DeinterleaveKernel BestDeinterleaveKernel();
+bool DeinterleaveKernelSupported(DeinterleaveKernel kernel);
+const char* DeinterleaveKernelName(DeinterleaveKernel kernel);
+
+// Puts the four channels side by side in display order, straight from the
+// capture words with no channel split in between: pixels[4i + c] is byte i
+// of channel c, MSB first, as ExtractChannel() would give it. Every word
+// becomes its own four pixels, so any line is a slice of the result.
+void InterleaveChannels(const uint32_t* words, size_t count, uint8_t* pixels);
+
+// Specific kernel; only Scalar and Avx2 exist for this. Returns false if
+// this CPU or build cannot run it.
+bool InterleaveChannelsWith(DeinterleaveKernel kernel, const uint32_t* words, size_t count, uint8_t* pixels);
+
+// Copies a display row out of interleaved pixels: bytes bytes per channel
+// from channel bit payloadBit on. On a byte boundary that is one memcpy;
+// otherwise each byte is funnel shifted against the same channel's next
+// byte. Reads stop at the pixels holding the last payload bit.
+void CutRow(const uint8_t* pixels, size_t payloadBit, size_t bytes, uint8_t* row);
+
+// Channel channel of count interleaved words back out as packed bytes
+void PickChannel(const uint8_t* pixels, size_t count, int channel, uint8_t* out);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+
+#include "FileSink.h"
+
+// Unbuffered writer: O_DIRECT on Linux, FILE_FLAG_NO_BUFFERING on Windows.
+//
+// Data goes from the acquisition buffers straight to the device without a
+// page-cache copy or writeback bursts. Direct I/O needs block-aligned
+// memory, lengths and file offsets, so:
+//   - Allocator() hands out ALIGNMENT-aligned buffers for the ring;
+//   - whole blocks of an aligned buffer are written in place, anything else
+//     (the odd bytes of a short transfer, and everything after it while the
+//     stream is off a block boundary) is staged through an aligned bounce
+//     buffer;
+//   - Close() pads the final partial block and truncates the file back to
+//     the exact number of bytes written.
+// The file is preallocated to the expected size so the filesystem does not
+// extend it on every write.
+class DirectFileSink : public FileSink {
+public:
+    DirectFileSink();
+    ~DirectFileSink() override;
+
+    bool Open(const std::string& path, size_t expectedBytes) override;
+    bool Write(const unsigned char* data, size_t length) override;
+    bool Close() override;
+    bool IsOpen() const override;
+
+    BufferAllocator Allocator() override;
+    const char* Name() const override { return "direct"; }
+
+    static constexpr size_t ALIGNMENT = 4096;  // Page size; covers 512e and 4Kn sectors
+
+    // ALIGNMENT-aligned memory, also used by the other unbuffered sinks
+    static unsigned char* AllocateAligned(size_t size);
+    static void FreeAligned(unsigned char* memory, size_t size);
+
+private:
+    // Writes length bytes at the current (aligned) file offset. data and
+    // length must both be ALIGNMENT-aligned.
+    bool WriteBlocks(const unsigned char* data, size_t length);
+    void Preallocate(size_t bytes);
+    bool Truncate(uint64_t size);
+    void CloseFile();
+
+#ifdef _WIN32
+    void* m_file;
+#else
+    int m_fd;
+#endif
+
+    unsigned char* m_bounce;  // BOUNCE_SIZE bytes, aligned
+    size_t m_pending;         // Bytes staged in m_bounce, not yet on disk
+    uint64_t m_bytesWritten;  // Logical file size so far
+
+    static constexpr size_t BOUNCE_SIZE = 1024 * 1024;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Clahe.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Colours the display's 8-bit values are shown in
+enum class DisplayPalette { Gray, Hot, Rainbow };
+
+// How a raw frame is turned into what is shown, stage by stage in this order
+struct DisplaySettings {
+    int level = 128;     // Raw value shown as mid-gray (window centre)
+    int window = 256;    // Raw values from black to white (window width)
+    double gamma = 1.0;  // Shown as value^(1/gamma): above 1 lifts the shadows
+    bool equalize = false;  // CLAHE after window/level and gamma
+    DisplayPalette palette = DisplayPalette::Gray;
+};
+
+bool operator==(const DisplaySettings& a, const DisplaySettings& b);
+bool operator!=(const DisplaySettings& a, const DisplaySettings& b);
+
+// A frame as the viewer shows it: height rows of width 8-bit values, drawn
+// in the colours of palette (0x00RRGGBB, a GDI RGBQUAD on little-endian)
+struct ViewerTexture {
+    std::vector<uint8_t> pixels;
+    int width = 0;
+    int height = 0;
+    int frameNumber = 0;
+    std::array<uint32_t, 256> palette = {};
+};
+
+// How many times each stage has been worked out since construction
+struct DisplayStageCounts {
+    uint64_t tone = 0;       // Window/level and gamma over the frame
+    uint64_t equalize = 0;   // CLAHE over the frame
+    uint64_t palette = 0;    // Palette table
+};
+
+// Turns raw frames into viewer textures without ever changing the raw frame.
+//
+// The pipeline keeps its own copy of the newest frame and the output of
+// every stage. Window/level and gamma fold into one 256-entry LUT applied in
+// a single pass; equalization runs on that result; the false-colour palette
+// travels with the texture instead of being applied to its pixels. A stage
+// is only worked out again when the frame or one of its own settings
+// changes, so turning equalization off and on again, or changing palette,
+// re-renders the held frame with a copy rather than a recompute. One thread
+// owns a pipeline.
+class DisplayPipeline {
+public:
+    explicit DisplayPipeline(const ClaheConfig& clahe = ClaheConfig());
+
+    DisplayPipeline(const DisplayPipeline&) = delete;
+    DisplayPipeline& operator=(const DisplayPipeline&) = delete;
+
+    // Copies in a new raw frame of height rows of width values
+    void SetFrame(const uint8_t* pixels, int width, int height, int frameNumber);
+    bool HasFrame() const { return m_width > 0 && m_height > 0; }
+
+    void SetSettings(const DisplaySettings& settings);
+    const DisplaySettings& Settings() const { return m_settings; }
+
+    // Brings any stage that is out of date up to date and fills texture
+    void Render(ViewerTexture& texture);
+
+    const DisplayStageCounts& Counts() const { return m_counts; }
+
+private:
+    bool ToneIsIdentity() const;
+    void BuildToneLut();
+    void BuildPalette();
+
+    DisplaySettings m_settings;
+    ClaheEngine m_clahe;
+
+    std::vector<uint8_t> m_raw;
+    int m_width;
+    int m_height;
+    int m_frameNumber;
+
+    // Stage outputs, each valid until its input or its settings change
+    std::array<uint8_t, 256> m_toneLut;
+    std::vector<uint8_t> m_toned;
+    std::vector<uint8_t> m_equalized;
+    std::array<uint32_t, 256> m_palette;
+    bool m_tonedValid;
+    bool m_equalizedValid;
+
+    DisplayStageCounts m_counts;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Eventcount: lets a consumer sleep on "something was published" without the
+// producer paying for a lock when nobody is waiting.
+//
+// Consumer:
+//     key = PrepareWait();
+//     if (<condition now true>) { CancelWait(); ... }
+//     else CommitWait(key, deadline);
+// Producer:
+//     <publish>; Notify();
+//
+// Notify() is a fence plus one load when there are no waiters. The mutex and
+// condition variable are only touched on the slow path.
+class EventCount {
+public:
+    EventCount() : m_epoch(0), m_waiters(0) {}
+
+    EventCount(const EventCount&) = delete;
+    EventCount& operator=(const EventCount&) = delete;
+
+    uint64_t PrepareWait() {
+        m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        return m_epoch.load(std::memory_order_acquire);
+    }
+
+    void CancelWait() {
+        m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    // Returns false if the deadline passed without a Notify().
+    bool CommitWait(uint64_t key, std::chrono::steady_clock::time_point deadline) {
+        bool signalled;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            signalled = m_cv.wait_until(lock, deadline, [&]() {
+                return m_epoch.load(std::memory_order_acquire) != key;
+            });
+        }
+        m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+        return signalled;
+    }
+
+    void Notify() {
+        // Pairs with the seq_cst increment in PrepareWait(): either we see the
+        // waiter, or the waiter's re-check sees what we just published.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiters.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_epoch.fetch_add(1, std::memory_order_release);
+        }
+        m_cv.notify_all();
+    }
+
+private:
+    std::atomic<uint64_t> m_epoch;
+    std::atomic<uint32_t> m_waiters;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "BulkInTransport.h"
+#include "MappedFile.h"
+
+struct ReplayConfig {
+    double bytesPerSecond = 0.0;  // 0 = as fast as the host reaps
+    bool loop = false;            // Wrap around at the end instead of stopping
+    size_t maxPacketSize = 1024;
+};
+
+// Plays a saved capture (.bin) back through the bulk-IN interface.
+//
+// The file is memory-mapped and copied into the submitted buffers in order,
+// optionally paced to a wire rate (e.g. 297 MB/s), so everything behind the
+// transport sees the same buffer sizes and timing it would get from the FX3.
+// Without loop, transfers reaped after the end of the file yield Failed.
+class FileReplayTransport : public BulkInTransport {
+public:
+    explicit FileReplayTransport(const std::string& path, const ReplayConfig& config = ReplayConfig());
+    ~FileReplayTransport() override;
+
+    bool Open() override;
+    void Close() override;
+    bool IsOpen() const override { return m_capture.IsOpen(); }
+
+    bool Configure(int numSlots, size_t transferSize) override;
+    bool Submit(int slot, unsigned char* data, size_t length) override;
+    TransferStatus Reap(int slot, uint32_t timeoutMs, size_t& bytesTransferred) override;
+    TransferStatus ReapAny(uint32_t timeoutMs, int& slot, size_t& bytesTransferred) override;
+    void Abort() override;
+
+    size_t MaxPacketSize() const override { return m_config.maxPacketSize; }
+    const char* Name() const override { return "file replay"; }
+
+    size_t FileBytes() const { return m_capture.Size(); }
+    bool AtEnd() const { return !m_config.loop && m_offset >= m_capture.Size(); }
+
+private:
+    enum class SlotState { Idle, Queued, Done };
+
+    struct Slot {
+        SlotState state = SlotState::Idle;
+        unsigned char* data = nullptr;
+        size_t length = 0;
+        size_t transferred = 0;
+        TransferStatus status = TransferStatus::Failed;
+    };
+
+    void Complete(Slot& slot);
+
+    std::string m_path;
+    ReplayConfig m_config;
+
+    MappedFile m_capture;
+    size_t m_offset;
+
+    std::vector<Slot> m_slots;
+    std::deque<int> m_queue;  // Submitted slots in submission order
+    std::chrono::steady_clock::time_point m_nextCompletion;
+};
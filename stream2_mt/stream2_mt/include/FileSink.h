@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include "BufferManager.h"
+
+// Where the disk writer puts the captured stream.
+//
+// The writer hands every full buffer to Submit() in order and calls Close()
+// once the target size is reached, so a sink only ever sees one thread.
+class FileSink {
+public:
+    virtual ~FileSink() = default;
+
+    // expectedBytes is the capture size, used to preallocate; 0 if unknown.
+    virtual bool Open(const std::string& path, size_t expectedBytes) = 0;
+
+    // Appends length bytes. The memory may be reused as soon as this returns.
+    virtual bool Write(const unsigned char* data, size_t length) = 0;
+
+    // Appends the first length bytes of a ring buffer. Sinks that keep
+    // writes in flight hold on to the buffer and pass it to release once it
+    // is on disk, from inside a later Submit(), Reap() or Close() on the
+    // calling thread. By default this is a synchronous Write().
+    using ReleaseFn = std::function<void(Buffer*)>;
+    virtual bool Submit(Buffer* buffer, size_t length, const ReleaseFn& release) {
+        const bool ok = Write(buffer->data.get(), length);
+        release(buffer);
+        return ok;
+    }
+
+    // Releases buffers whose writes have finished. With wait, blocks until
+    // at least one has if any are outstanding.
+    virtual bool Reap(bool wait) { (void)wait; return true; }
+    virtual size_t WritesInFlight() const { return 0; }
+
+    // Waits for outstanding writes, writes out anything still held, sets the
+    // final file size and closes. Safe to call on a sink that is already closed.
+    virtual bool Close() = 0;
+
+    virtual bool IsOpen() const = 0;
+
+    // Memory Write() can consume without an extra copy. Empty means any
+    // heap buffer will do.
+    virtual BufferAllocator Allocator() { return BufferAllocator(); }
+
+    virtual const char* Name() const = 0;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "LineParser.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One video frame as a single width x lines pixel array.
+//
+// Row y holds line y in arrival order, the four channels interleaved
+// (pixel 4i + c is byte i of channel c). Where each line came from is kept
+// beside the pixels in parallel arrays rather than per line, so filling and
+// clearing a frame allocates nothing once the buffer has its size, and the
+// pixels can be handed to a bitmap or written to disk as they are.
+class FrameBuffer {
+public:
+    static constexpr int ROW_PIXELS = 712;  // 178 payload bytes x 4 channels
+    static constexpr int DEFAULT_LINES = 2000;
+
+    explicit FrameBuffer(int maxLines = DEFAULT_LINES, int width = ROW_PIXELS);
+
+    // Empties the frame for at most maxLines lines; memory is only ever grown
+    void Reset(int maxLines);
+
+    // Empties the frame, keeping its size
+    void Clear();
+
+    // Interleaves a parsed line into the next row; a short line leaves the
+    // rest of the row black and a long one is cut at the frame width.
+    // Returns false when the frame is full.
+    bool AppendLine(const LineView& line);
+
+    int Width() const { return m_width; }
+    int Height() const { return m_height; }
+    int MaxLines() const { return m_maxLines; }
+    bool Empty() const { return m_height == 0; }
+    bool Full() const { return m_height >= m_maxLines; }
+
+    int FrameNumber() const { return m_frameNumber; }
+    void SetFrameNumber(int number) { m_frameNumber = number; }
+
+    // Height() rows of Width() pixels, no padding between rows
+    const uint8_t* Pixels() const { return m_pixels.data(); }
+    const uint8_t* Row(int y) const { return m_pixels.data() + static_cast<size_t>(y) * m_width; }
+
+    // Per row: channel bit of the SAV, of the EAV (or fallback end), and
+    // whether the line carried any payload
+    const std::vector<uint64_t>& StartBits() const { return m_startBits; }
+    const std::vector<uint64_t>& EndBits() const { return m_endBits; }
+    const std::vector<uint8_t>& Valid() const { return m_valid; }
+
+private:
+    int m_width;
+    int m_maxLines;
+    int m_height;
+    int m_frameNumber;
+    std::vector<uint8_t> m_pixels;  // m_maxLines rows
+    std::vector<uint64_t> m_startBits;
+    std::vector<uint64_t> m_endBits;
+    std::vector<uint8_t> m_valid;
+};
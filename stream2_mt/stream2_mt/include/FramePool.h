@@ -0,0 +1,133 @@
+#pragma once
+
+#include "FrameBuffer.h"
+#include "Metrics.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct FrameConsumerStats {
+    std::string name;
+    uint64_t delivered = 0;  // Frames taken
+    uint64_t dropped = 0;    // Frames replaced by newer ones before being taken
+};
+
+struct FramePoolStats {
+    uint64_t published = 0;
+    uint64_t starved = 0;    // Acquire() found every frame held by a consumer
+    std::vector<FrameConsumerStats> consumers;
+};
+
+// A fixed set of preallocated FrameBuffers passed from one producer (the
+// line parser) to any number of consumers (display, recorder, stats).
+//
+// The producer acquires a free frame, fills it and publishes it; every
+// consumer then holds a reference until it releases the frame, and the frame
+// becomes free again when the last one does. Nothing is allocated after
+// construction. A consumer that falls behind loses its oldest waiting frame:
+// when its queue is full on Publish(), or when Acquire() needs a frame that
+// only waiting queues still hold. Frames a consumer has taken are never
+// reclaimed.
+//
+// Threading contract: one producer thread calls Acquire/Publish/Discard;
+// each consumer calls Take/WaitForFrame/Release from its own thread.
+class FramePool {
+public:
+    FramePool(int numFrames, int maxLines = FrameBuffer::DEFAULT_LINES, int width = FrameBuffer::ROW_PIXELS);
+
+    // Registers a consumer that may have up to queueDepth frames waiting.
+    // Call before the first Publish(). Returns the consumer id.
+    int AddConsumer(const std::string& name, size_t queueDepth = 1);
+
+    // Producer: an empty frame, or nullptr when every frame is taken
+    FrameBuffer* Acquire();
+
+    // Producer: hands the frame to every consumer
+    void Publish(FrameBuffer* frame);
+
+    // Producer: gives back an acquired frame without publishing it
+    void Discard(FrameBuffer* frame);
+
+    // Consumer: oldest waiting frame, nullptr if there is none. The frame
+    // stays valid until Release().
+    FrameBuffer* Take(int consumer);
+
+    // Blocking Take(); nullptr on timeout or after WakeAll()
+    FrameBuffer* WaitForFrame(int consumer, std::chrono::microseconds timeout);
+
+    void Release(FrameBuffer* frame);
+
+    // Kicks consumers blocked in WaitForFrame, e.g. on shutdown
+    void WakeAll();
+
+    size_t FreeFrames() const;
+    FramePoolStats Stats() const;
+
+private:
+    struct Slot {
+        std::unique_ptr<FrameBuffer> frame;
+        int refs = 0;           // Consumers holding it, queued or taken; 0 = free
+        bool acquired = false;  // Owned by the producer
+        uint64_t sequence = 0;  // Publish order
+    };
+
+    struct Consumer {
+        FrameConsumerStats stats;
+        size_t queueDepth;
+        std::vector<size_t> queue;  // Slots waiting, oldest first; never grows past queueDepth
+    };
+
+    size_t SlotOf(const FrameBuffer* frame) const;
+    FrameBuffer* PopWaiting(Consumer& consumer);
+    void Unref(size_t slot);
+    bool DropOldestWaiting();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_frameReady;
+    std::vector<Slot> m_slots;
+    std::vector<size_t> m_free;
+    std::vector<Consumer> m_consumers;
+    uint64_t m_published;
+    uint64_t m_starved;
+    uint64_t m_wakeGeneration;
+
+    // In MetricsRegistry::Global(), shared by every pool
+    MetricCounter& m_publishedMetric;
+    MetricCounter& m_droppedMetric;
+    MetricCounter& m_starvedMetric;
+};
+
+// Builds frames from parsed lines straight in pool frames: each frame is
+// published when the next one starts or it is full, and a new one acquired.
+// Lines that arrive while the pool has no free frame are lost. Call from the
+// producer thread only.
+class FramePublisher : public LineSink {
+public:
+    explicit FramePublisher(FramePool& pool);
+    ~FramePublisher() override;
+
+    void OnLine(const LineView& line) override;
+
+    // End of stream: publishes the frame being built, if it has any lines.
+    // Acquires nothing, so it never waits on the pool.
+    void Finish();
+
+    uint64_t Published() const { return m_published; }
+    uint64_t LostLines() const { return m_lostLines; }
+
+private:
+    // Publishes the frame being built if it has lines; an empty one is kept
+    void PublishFrame();
+    void NextFrame();
+
+    FramePool& m_pool;
+    FrameBuffer* m_frame;
+    uint64_t m_published;
+    uint64_t m_lostLines;
+};
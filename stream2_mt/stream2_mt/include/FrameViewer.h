@@ -0,0 +1,130 @@
+#pragma once
+
+#include "DisplayPipeline.h"
+#include "FramePool.h"
+#include "TripleBuffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Where FrameViewer shows its frames. Every call comes from the viewer's
+// present thread, so a window can be created and pumped there.
+class ViewerSurface {
+public:
+    virtual ~ViewerSurface() = default;
+
+    virtual bool Open() = 0;
+    virtual void Close() = 0;
+
+    // Presents are paced to this
+    virtual double RefreshHz() = 0;
+
+    // Handles pending window events; false once the surface has been closed
+    virtual bool Poll() = 0;
+
+    virtual void Present(const ViewerTexture& texture) = 0;
+};
+
+// Offscreen surface: keeps the last texture presented, so the viewer runs the
+// same with no display at all
+class HeadlessSurface : public ViewerSurface {
+public:
+    explicit HeadlessSurface(double refreshHz = 60.0) : m_refreshHz(refreshHz) {}
+
+    bool Open() override { return true; }
+    void Close() override {}
+    double RefreshHz() override { return m_refreshHz; }
+    bool Poll() override { return true; }
+    void Present(const ViewerTexture& texture) override { m_offscreen = texture; }
+
+    // Only valid once the viewer has stopped
+    const ViewerTexture& Offscreen() const { return m_offscreen; }
+
+private:
+    double m_refreshHz;
+    ViewerTexture m_offscreen;
+};
+
+struct FrameViewerStats {
+    uint64_t produced = 0;   // Frames the pool has published
+    uint64_t uploaded = 0;   // Textures finished: frames taken from the mailbox and re-renders
+    uint64_t presented = 0;  // Shown on the surface
+    double seconds = 0.0;    // Since Start()
+};
+
+// Shows the frames a FramePool publishes without ever holding up the producer.
+//
+// The viewer is the pool's "display" consumer with a queue of one, so the
+// pool keeps it a mailbox holding only the newest frame. An upload thread
+// copies each frame it takes into a DisplayPipeline, releases the frame at
+// once and renders the pipeline into the back texture of a TripleBuffer. A
+// present thread owns the surface: it handles its events and, once per
+// display refresh, presents the newest finished texture if there is one. A
+// slow stage, a slow surface or a window being dragged costs presented
+// frames, never parsed ones, and the viewer never holds a pool frame for
+// longer than one copy.
+//
+// New display settings wake the upload thread, which re-renders the frame
+// it holds from the pipeline's cached stages, so a change shows at the next
+// refresh even when no frames are coming in.
+class FrameViewer {
+public:
+    // Registers the consumer, so construct it before the first Publish()
+    FrameViewer(FramePool& pool, ViewerSurface& surface);
+    ~FrameViewer();
+
+    FrameViewer(const FrameViewer&) = delete;
+    FrameViewer& operator=(const FrameViewer&) = delete;
+
+    // From any thread, before or after Start()
+    void SetSettings(const DisplaySettings& settings);
+    DisplaySettings Settings() const;
+
+    // Opens the surface on the present thread; false if that failed
+    bool Start();
+    void Stop();
+
+    // False once the surface has been closed or Stop() called
+    bool Running() const { return m_running.load(); }
+
+    // Blocks until the surface is closed, or for at most timeout; true if closed
+    void WaitForClose();
+    bool WaitForClose(std::chrono::milliseconds timeout);
+
+    FrameViewerStats Stats() const;
+
+private:
+    enum class OpenState { Pending, Open, Failed };
+
+    void UploadLoop();
+    void PresentLoop();
+    void Finish();
+
+    FramePool& m_pool;
+    ViewerSurface& m_surface;
+    int m_consumer;
+    DisplayPipeline m_pipeline;  // Upload thread only
+    TripleBuffer<ViewerTexture> m_textures;
+
+    std::thread m_uploadThread;
+    std::thread m_presentThread;
+    std::atomic<bool> m_running;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_stateChanged;
+    OpenState m_openState;
+    std::chrono::steady_clock::time_point m_start;
+    DisplaySettings m_settings;
+    uint64_t m_settingsVersion;
+
+    std::atomic<uint64_t> m_uploaded;
+    std::atomic<uint64_t> m_presented;
+
+    // In MetricsRegistry::Global()
+    MetricCounter& m_presentedMetric;
+    MetricHistogram& m_renderUs;
+};
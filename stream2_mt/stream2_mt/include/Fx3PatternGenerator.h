@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+enum class SimulatorPattern {
+    Video,    // 4-channel bit-interleaved lines framed by SAV/EAV codes
+    Counter   // Incrementing 32-bit words, like the FX3 counter firmware
+};
+
+// Geometry of the simulated camera, per channel and in bytes. The defaults
+// reproduce what the Vis0 analysis sees on the real sensor: SAV->EAV is
+// 1456 bits and SAV->SAV 1776 bits in each channel.
+struct VideoGeometry {
+    int payloadBytes = 178;     // Active pixels per channel per line
+    int blankingBytes = 36;     // Horizontal blanking after EAV
+    int activeLines = 480;      // Lines framed by SAV/EAV
+    int blankingLines = 10;     // Vertical blanking, framed by SAVI/EAVI
+};
+
+// Deterministic byte source for the FX3 simulator and the benchmarks.
+//
+// Video stream layout: each channel carries its own byte stream, MSB first,
+// and the four streams are bit-interleaved into little-endian 32-bit words
+// (stream bit 4k + c is bit k of channel c). Each line in a channel is
+//     FF 00 00 <SAV>  payload  FF 00 00 <EAV>  blanking
+// with the same codes at the same place in all four channels. Payload bytes
+// stay inside 0x01..0xFE, so no false sync can appear at any bit offset.
+class Fx3PatternGenerator {
+public:
+    explicit Fx3PatternGenerator(SimulatorPattern pattern = SimulatorPattern::Video,
+                                 const VideoGeometry& geometry = VideoGeometry());
+
+    // Writes the next `bytes` bytes of the stream; any byte count is fine.
+    void Fill(unsigned char* dst, size_t bytes);
+
+    // Advances the stream without producing data (models bytes the device
+    // had to drop because the host was late).
+    void Skip(size_t bytes);
+
+    uint64_t Position() const { return m_position; }
+    size_t LineBytes() const { return static_cast<size_t>(m_lineWords) * 4; }
+    size_t FrameBytes() const { return LineBytes() * static_cast<size_t>(m_frameLines); }
+
+    // Pixel value the generator puts at (frame, line, x) of the interleaved
+    // 712-pixel row, so consumers can check what they decoded.
+    static uint8_t PixelValue(uint64_t frame, int line, int x);
+
+private:
+    uint32_t WordAt(uint64_t wordIndex) const;
+    uint32_t LineWord(uint64_t frame, int line, int w) const;
+
+    SimulatorPattern m_pattern;
+    VideoGeometry m_geometry;
+    int m_lineWords;
+    int m_frameLines;
+    uint64_t m_position;  // In bytes
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Buckets for non-negative integers: values below SUB_BUCKETS get a bucket
+// each; above that, each power of two is split into SUB_BUCKETS linear
+// sub-buckets, so a bucket's upper edge is within 12.5% of any value in it.
+// Bucket (shift + 1, top bits) covers [top << shift, (top + 1) << shift).
+struct LogLinearBuckets {
+    static constexpr int SUB_BITS = 3;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BITS;
+    static constexpr size_t COUNT = 40 * SUB_BUCKETS;
+
+    static size_t Of(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        const int shift = HighestBit(value) - SUB_BITS;
+        const size_t bucket = (static_cast<size_t>(shift) + 1) * SUB_BUCKETS
+                            + static_cast<size_t>(value >> shift) - SUB_BUCKETS;
+        return std::min<size_t>(bucket, COUNT - 1);
+    }
+
+    static uint64_t UpperEdge(size_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        const int shift = static_cast<int>(bucket / SUB_BUCKETS) - 1;
+        const uint64_t top = bucket % SUB_BUCKETS + SUB_BUCKETS;
+        return ((top + 1) << shift) - 1;
+    }
+
+    // Index of the top set bit; value must not be 0
+    static int HighestBit(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+};
+
+// Fixed-size histogram of durations in microseconds.
+//
+// Each power of two is split into 8 linear sub-buckets, so a percentile is
+// reported to within 12.5% no matter how long the run is, without keeping
+// every sample. Not thread-safe: record from one thread, read after it stops.
+class LatencyHistogram {
+public:
+    LatencyHistogram() { Reset(); }
+
+    void Record(double microseconds) {
+        const uint64_t value = microseconds > 0.0 ? static_cast<uint64_t>(microseconds + 0.5) : 0;
+        ++m_counts[LogLinearBuckets::Of(value)];
+        ++m_count;
+        m_max = std::max<uint64_t>(m_max, value);
+    }
+
+    // Upper edge of the bucket holding the given percentile (0..100)
+    double Percentile(double percent) const {
+        if (m_count == 0) {
+            return 0.0;
+        }
+        const uint64_t rank = static_cast<uint64_t>(percent / 100.0 * static_cast<double>(m_count - 1));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += m_counts[i];
+            if (seen > rank) {
+                return static_cast<double>(std::min<uint64_t>(LogLinearBuckets::UpperEdge(i), m_max));
+            }
+        }
+        return static_cast<double>(m_max);
+    }
+
+    uint64_t Count() const { return m_count; }
+    double Max() const { return static_cast<double>(m_max); }
+
+    void Reset() {
+        m_counts.fill(0);
+        m_count = 0;
+        m_max = 0;
+    }
+
+private:
+    static constexpr size_t BUCKETS = LogLinearBuckets::COUNT;
+
+    std::array<uint64_t, BUCKETS> m_counts;
+    uint64_t m_count;
+    uint64_t m_max;
+};
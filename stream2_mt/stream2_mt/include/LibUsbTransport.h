@@ -0,0 +1,84 @@
+#pragma once
+
+#ifdef USE_LIBUSB
+
+#include <libusb.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BulkInTransport.h"
+
+struct LibUsbConfig {
+    uint16_t vendorId = 0x04B4;     // Cypress
+    uint16_t productId = 0x00F1;    // FX3 streamer firmware
+    int interfaceNumber = 0;
+    unsigned char endpoint = 0x81;  // EP1 IN
+
+    // Back the transfer buffers with libusb_dev_mem_alloc() so usbfs DMAs
+    // straight into them instead of bouncing through a kernel copy. Needs
+    // Linux 4.6+; falls back to heap buffers when the kernel refuses.
+    bool useDeviceMemory = false;
+};
+
+// BulkInTransport on top of the libusb-1.0 asynchronous API.
+//
+// Each slot owns one libusb_transfer that reads directly into the caller's
+// buffer; a dedicated thread runs libusb's event loop and completions are
+// picked up by Reap(). Works against any bulk-IN source, e.g. the Linux
+// g_zero gadget on dummy_hcd (VID 0x0525, PID 0xa4a0, EP 0x81):
+//     modprobe dummy_hcd && modprobe g_zero
+class LibUsbTransport : public BulkInTransport {
+public:
+    explicit LibUsbTransport(const LibUsbConfig& config = LibUsbConfig());
+    ~LibUsbTransport() override;
+
+    bool Open() override;
+    void Close() override;
+    bool IsOpen() const override { return m_handle != nullptr; }
+
+    bool Configure(int numSlots, size_t transferSize) override;
+    bool Submit(int slot, unsigned char* data, size_t length) override;
+    TransferStatus Reap(int slot, uint32_t timeoutMs, size_t& bytesTransferred) override;
+    TransferStatus ReapAny(uint32_t timeoutMs, int& slot, size_t& bytesTransferred) override;
+    void Abort() override;
+
+    BufferAllocator Allocator() override;
+    size_t MaxPacketSize() const override { return m_maxPacketSize; }
+    const char* Name() const override { return "libusb"; }
+
+private:
+    struct Slot {
+        LibUsbTransport* owner = nullptr;
+        libusb_transfer* transfer = nullptr;
+        bool inFlight = false;  // Submitted and not yet reaped
+        bool done = false;      // Callback has run
+    };
+
+    static void LIBUSB_CALL OnTransferComplete(libusb_transfer* transfer);
+
+    // Called with m_mutex held once the slot's callback has run
+    TransferStatus Collect(Slot& slot, size_t& bytesTransferred);
+
+    void EventThread();
+    void ReleaseSlots();
+
+    LibUsbConfig m_config;
+    libusb_context* m_context;
+    libusb_device_handle* m_handle;
+    size_t m_maxPacketSize;
+
+    std::vector<Slot> m_slots;
+    std::mutex m_mutex;
+    std::condition_variable m_completed;
+
+    std::thread m_eventThread;
+    std::atomic<bool> m_stopEvents;
+
+    static constexpr uint32_t ABORT_TIMEOUT = 10000;  // ms to wait for cancellations
+};
+
+#endif // USE_LIBUSB
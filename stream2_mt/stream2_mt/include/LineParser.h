@@ -0,0 +1,181 @@
+#pragma once
+
+#include "Metrics.h"
+#include "SyncScanner.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Where one active line sits in the channel bit stream
+struct LineSpan {
+    uint64_t startBit;   // Channel bit of the SAV code
+    uint64_t endBit;     // Channel bit of the EAV code, or the fallback end
+    bool hasEav;         // False when no EAV followed in time
+    bool newFrame;       // First line, or first after a vertical gap
+};
+
+// A line with its payload: the bytes between the SAV and EAV codes, per channel
+struct ParsedLine : LineSpan {
+    std::array<std::vector<uint8_t>, 4> channels;
+};
+
+// A line whose payload is still in the capture, interleaved into display
+// order by InterleaveChannels(): bytes whole bytes per channel from channel
+// bit payloadBit of pixels on (see CutRow). Only valid for the duration of
+// the call it is passed to.
+struct LineView : LineSpan {
+    const uint8_t* pixels;
+    size_t payloadBit;
+    size_t bytes;
+};
+
+// Takes lines from LineParser without copying them out first
+class LineSink {
+public:
+    virtual ~LineSink() = default;
+    virtual void OnLine(const LineView& line) = 0;
+};
+
+struct LineParserStats {
+    uint64_t words = 0;
+    uint64_t lines = 0;
+    uint64_t linesWithoutEav = 0;
+    uint64_t frames = 0;
+};
+
+// Turns channel 0 sync marks into line spans.
+//
+// Every SAV pairs with the next EAV, as in analyzeData. A SAV with no EAV
+// within MAX_LINE_BITS gets a line of FALLBACK_LINE_BITS instead of holding
+// on to the stream. A SAV more than FRAME_GAP_BITS after the previous one
+// starts a new frame. The streaming and the offline parsers both go through
+// this, so they agree line for line.
+class LinePairer {
+public:
+    static constexpr uint64_t SYNC_BITS = SyncScanner::Words::BITS;
+    static constexpr uint64_t NORMAL_LINE_GAP = 1776;     // SAV to SAV, bits
+    static constexpr uint64_t FALLBACK_LINE_BITS = 1456;  // SAV to EAV, bits
+    static constexpr uint64_t MAX_LINE_BITS = 2 * NORMAL_LINE_GAP;
+    static constexpr uint64_t FRAME_GAP_BITS = 2 * NORMAL_LINE_GAP;
+
+    LinePairer() { Reset(); }
+
+    void Reset() {
+        m_openSavs.clear();
+        m_lastSav = 0;
+        m_haveLastSav = false;
+    }
+
+    // Marks must come in stream order. emit(const LineSpan&) is called for
+    // each line completed, in SAV order.
+    template <typename Emit>
+    void Mark(const SyncMark& mark, Emit&& emit) {
+        Expire(mark.bit, emit);
+        if (mark.code == SyncCode::SAV) {
+            m_openSavs.push_back(mark.bit);
+        } else if (mark.code == SyncCode::EAV) {
+            for (uint64_t sav : m_openSavs) {
+                Line(sav, mark.bit, true, emit);
+            }
+            m_openSavs.clear();
+        }
+    }
+
+    // The stream has reached nowBit: SAVs too old to still get an EAV end
+    template <typename Emit>
+    void Expire(uint64_t nowBit, Emit&& emit) {
+        size_t expired = 0;
+        while (expired < m_openSavs.size() && nowBit - m_openSavs[expired] > MAX_LINE_BITS) {
+            Line(m_openSavs[expired], m_openSavs[expired] + FALLBACK_LINE_BITS, false, emit);
+            ++expired;
+        }
+        if (expired > 0) {
+            m_openSavs.erase(m_openSavs.begin(), m_openSavs.begin() + static_cast<std::ptrdiff_t>(expired));
+        }
+    }
+
+    // End of stream at endBit: waiting lines get what data there is, if any
+    template <typename Emit>
+    void Flush(uint64_t endBit, Emit&& emit) {
+        for (uint64_t sav : m_openSavs) {
+            uint64_t end = sav + FALLBACK_LINE_BITS;
+            if (end > endBit) {
+                end = endBit;
+            }
+            if (end >= sav + SYNC_BITS + 8) {
+                Line(sav, end, false, emit);
+            }
+        }
+        m_openSavs.clear();
+    }
+
+    bool HasOpenLines() const { return !m_openSavs.empty(); }
+    uint64_t OldestOpenLine() const { return m_openSavs.front(); }
+
+private:
+    template <typename Emit>
+    void Line(uint64_t savBit, uint64_t endBit, bool hasEav, Emit&& emit) {
+        LineSpan span;
+        span.startBit = savBit;
+        span.endBit = endBit;
+        span.hasEav = hasEav;
+        span.newFrame = !m_haveLastSav || savBit - m_lastSav > FRAME_GAP_BITS;
+        m_lastSav = savBit;
+        m_haveLastSav = true;
+        emit(span);
+    }
+
+    std::vector<uint64_t> m_openSavs;  // SAVs waiting for their EAV, oldest first
+    uint64_t m_lastSav;
+    bool m_haveLastSav;
+};
+
+// Cuts video lines out of the capture while it is still arriving.
+//
+// Each Feed() takes the next acquisition buffer, interleaves it into display
+// order and scans channel 0 for SAV/EAV, the same way analyzeData does on a
+// whole capture. Only the pixels from the oldest unfinished line on are kept
+// between buffers, so sync codes and lines that straddle a buffer boundary
+// come out whole and memory stays bounded however long the stream. Lines are
+// paired by LinePairer.
+class LineParser {
+public:
+    LineParser();
+
+    void Reset();
+
+    // Passes each line completed by these words to sink
+    void Feed(const uint32_t* words, size_t count, LineSink& sink);
+
+    // End of stream: the lines still waiting for an EAV get what data there is
+    void Flush(LineSink& sink);
+
+    // Same, copying each line's payload into out
+    void Feed(const uint32_t* words, size_t count, std::vector<ParsedLine>& out);
+    void Flush(std::vector<ParsedLine>& out);
+
+    const LineParserStats& Stats() const { return m_stats; }
+
+    // Packed bytes held per channel between buffers
+    size_t RetainedBytes() const { return m_pixels.size() / 4; }
+
+private:
+    void Emit(const LineSpan& span, LineSink& sink);
+    void Trim();
+
+    std::vector<uint8_t> m_pixels;  // Interleaved, from m_baseByte to the end of the stream
+    uint64_t m_baseByte;            // Per channel
+    std::vector<uint8_t> m_scan;    // This buffer's channel 0
+    SyncScanner m_scanner;
+    std::vector<SyncMark> m_marks;  // Reused between buffers
+    LinePairer m_pairer;
+    LineParserStats m_stats;
+
+    // In MetricsRegistry::Global(), shared by every parser
+    MetricCounter& m_wordsMetric;
+    MetricCounter& m_linesMetric;
+    MetricCounter& m_framesMetric;
+    MetricHistogram& m_feedUs;
+};
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "LatencyHistogram.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Threads share out this many cells per metric; more threads than that
+// share cells, which stays correct but is no longer contention-free
+constexpr size_t METRIC_SHARDS = 8;
+
+// Next cell to hand out, and the one this thread updates (METRIC_SHARDS
+// until its first update). Constant-initialized, so reading it is a plain
+// thread-local load with no first-use guard.
+inline std::atomic<size_t> g_nextMetricShard{ 0 };
+inline thread_local size_t t_metricShard = METRIC_SHARDS;
+
+// The cell this thread updates, fixed on its first use
+inline size_t MetricShard() {
+    if (t_metricShard == METRIC_SHARDS) {
+        t_metricShard = g_nextMetricShard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    }
+    return t_metricShard;
+}
+
+// A count that only goes up (events, bytes). Add() is one relaxed atomic add
+// on a cache line of the calling thread's own.
+class MetricCounter {
+public:
+    void Add(uint64_t n = 1) {
+        m_cells[MetricShard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t Value() const;
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<uint64_t> value{ 0 };
+    };
+    std::array<Cell, METRIC_SHARDS> m_cells;
+};
+
+// A level that goes up and down (queue occupancy, transfers in flight)
+class MetricGauge {
+public:
+    void Set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+    void Add(int64_t delta) { m_value.fetch_add(delta, std::memory_order_relaxed); }
+    int64_t Value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    alignas(64) std::atomic<int64_t> m_value{ 0 };
+};
+
+struct HistogramSummary {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double p999 = 0.0;
+};
+
+// Distribution of integer samples (microseconds, bytes) in LogLinearBuckets,
+// so percentiles hold to 12.5% over any run without keeping samples. Like
+// MetricCounter, Record() only touches the calling thread's cell.
+class MetricHistogram {
+public:
+    void Record(uint64_t value) {
+        Cell& cell = m_cells[MetricShard()];
+        cell.counts[LogLinearBuckets::Of(value)].fetch_add(1, std::memory_order_relaxed);
+        cell.sum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = cell.max.load(std::memory_order_relaxed);
+        while (value > max && !cell.max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Whole microseconds since start
+    void RecordSince(std::chrono::steady_clock::time_point start) {
+        Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+    }
+
+    HistogramSummary Summary() const;
+
+private:
+    struct alignas(64) Cell {
+        std::array<std::atomic<uint64_t>, LogLinearBuckets::COUNT> counts{};
+        std::atomic<uint64_t> sum{ 0 };
+        std::atomic<uint64_t> max{ 0 };
+    };
+    std::array<Cell, METRIC_SHARDS> m_cells;
+};
+
+enum class MetricKind { Counter, Gauge, Histogram };
+
+struct MetricSample {
+    std::string name;
+    std::string help;
+    MetricKind kind = MetricKind::Counter;
+    double value = 0.0;          // Counters and gauges
+    HistogramSummary histogram;  // Histograms
+};
+
+// Every metric's value at one moment, in registration order
+struct MetricsSnapshot {
+    double uptimeSeconds = 0.0;  // Since the registry was created
+    std::vector<MetricSample> samples;
+
+    const MetricSample* Find(const std::string& name) const;
+};
+
+// Named metrics for every stage of the pipeline.
+//
+// Components look their metrics up once, at construction, and keep the
+// reference; asking for a name that exists returns the same metric, so
+// several instances of a component add up. Asking for it as another kind is
+// refused: the caller gets a metric that is never exported. Lookup takes a
+// lock, updates never do. Metrics live as long as the registry.
+class MetricsRegistry {
+public:
+    MetricsRegistry();
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    // The one every component reports to
+    static MetricsRegistry& Global();
+
+    // Prometheus conventions: snake_case, counters end in _total, units in the name
+    MetricCounter& Counter(const std::string& name, const std::string& help);
+    MetricGauge& Gauge(const std::string& name, const std::string& help);
+    MetricHistogram& Histogram(const std::string& name, const std::string& help);
+
+    // Safe from any thread while the metrics are being updated
+    MetricsSnapshot Snapshot() const;
+
+private:
+    struct Entry {
+        std::string name;
+        std::string help;
+        MetricKind kind;
+        std::unique_ptr<MetricCounter> counter;
+        std::unique_ptr<MetricGauge> gauge;
+        std::unique_ptr<MetricHistogram> histogram;
+    };
+
+    Entry& Find(const std::string& name, const std::string& help, MetricKind kind);
+
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<Entry>> m_entries;
+    std::vector<std::unique_ptr<Entry>> m_rejected;  // Kind clashes, left out of snapshots
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// One JSON object per snapshot on one line
+void WriteMetricsJson(const MetricsSnapshot& snapshot, std::ostream& out);
+
+// Prometheus text exposition format; histograms as summaries
+void WriteMetricsPrometheus(const MetricsSnapshot& snapshot, std::ostream& out);
+
+// Rates of the counters between two snapshots (bytes as MB/s), levels of
+// the gauges and the histograms' percentiles so far, on one line. Metrics
+// that have never moved are left out.
+std::string FormatMetricsLine(const MetricsSnapshot& now, const MetricsSnapshot& previous);
+
+// Turns snapshots into the periodic console line and, optionally, an export
+// file. Call Tick() from whatever loop already runs once a second.
+class MetricsReporter {
+public:
+    explicit MetricsReporter(MetricsRegistry& registry = MetricsRegistry::Global());
+
+    // A path ending in ".prom" is rewritten whole on every tick, for a
+    // Prometheus textfile collector; anything else gets a JSON line appended
+    bool SetExport(const std::string& path);
+
+    // Takes a snapshot, exports it and returns the console line
+    std::string Tick();
+
+private:
+    MetricsRegistry& m_registry;
+    MetricsSnapshot m_previous;
+    std::string m_exportPath;
+    bool m_prometheus;
+    std::ofstream m_jsonLines;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "BulkInTransport.h"
+
+// One point of the depth x transfer-size sweep.
+struct QueueTunePoint {
+    int depth = 0;
+    size_t transferSize = 0;
+    double bytesPerSecond = 0.0;
+    uint64_t droppedBytes = 0;
+    bool sustained = false;  // Reached the target rate without drops
+
+    size_t InFlightBytes() const { return static_cast<size_t>(depth) * transferSize; }
+};
+
+struct QueueTuneOptions {
+    std::vector<int> depths = { 2, 4, 8, 16, 32 };
+    std::vector<size_t> transferSizes = { 16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024 };
+    double targetBytesPerSecond = 297.0 * 1024 * 1024;  // DATA_RATE in streamShow/Vis0
+    std::chrono::milliseconds warmup{ 50 };     // Discarded, like Vis0's flush cycles
+    std::chrono::milliseconds measure{ 250 };
+    uint32_t reapTimeoutMs = 1000;
+};
+
+// Finds the smallest queue that keeps up with the source.
+//
+// Each combination is run straight against the transport (reap and resubmit,
+// no disk writes) for a short window. A point is sustained when it reaches
+// the target rate and the transport reports no dropped bytes; backends that
+// cannot see drops are judged on throughput alone.
+class QueueTuner {
+public:
+    QueueTuner(BulkInTransport& transport, const QueueTuneOptions& options = QueueTuneOptions());
+
+    // Measures every combination, smallest in-flight memory first. The
+    // transport must be open; it is left configured for the last point.
+    std::vector<QueueTunePoint> Sweep();
+
+    // Sustained point with the least in-flight memory. Returns false (and
+    // the fastest point) when nothing sustained the target.
+    static bool PickSmallest(const std::vector<QueueTunePoint>& points, QueueTunePoint& best);
+
+    static void PrintCurve(const std::vector<QueueTunePoint>& points, std::ostream& out);
+
+private:
+    QueueTunePoint Measure(int depth, size_t transferSize);
+
+    BulkInTransport& m_transport;
+    QueueTuneOptions m_options;
+
+    static constexpr double SUSTAIN_MARGIN = 0.98;  // Allow for timer jitter
+};
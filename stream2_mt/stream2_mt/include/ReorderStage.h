@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Buffer;
+
+// Puts transfers that complete out of order back into submission order.
+//
+// Every submitted transfer gets the next sequence number; when it finishes,
+// Complete() records its buffer (or nullptr if it delivered nothing, e.g. it
+// was aborted). Drain() then hands out buffers strictly by sequence, skipping
+// the empty ones, and stops at the first transfer still outstanding.
+//
+// The window bounds how far submission may run ahead of delivery; the caller
+// checks HasRoom() before numbering a new transfer.
+class ReorderStage {
+public:
+    explicit ReorderStage(size_t window)
+        : m_entries(window)
+        , m_nextDelivery(0)
+    {
+    }
+
+    bool HasRoom(uint64_t sequence) const {
+        return sequence - m_nextDelivery < m_entries.size();
+    }
+
+    void Complete(uint64_t sequence, Buffer* buffer) {
+        Entry& entry = m_entries[sequence % m_entries.size()];
+        entry.done = true;
+        entry.buffer = buffer;
+    }
+
+    template <typename Deliver>
+    void Drain(Deliver deliver) {
+        for (;;) {
+            Entry& entry = m_entries[m_nextDelivery % m_entries.size()];
+            if (!entry.done) {
+                return;
+            }
+            Buffer* buffer = entry.buffer;
+            entry = Entry();
+            ++m_nextDelivery;
+            if (buffer) {
+                deliver(buffer);
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        bool done = false;
+        Buffer* buffer = nullptr;
+    };
+
+    std::vector<Entry> m_entries;
+    uint64_t m_nextDelivery;
+};
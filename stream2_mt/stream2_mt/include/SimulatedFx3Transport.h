@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "BulkInTransport.h"
+#include "Fx3PatternGenerator.h"
+
+struct SimulatorConfig {
+    SimulatorPattern pattern = SimulatorPattern::Video;
+    VideoGeometry geometry;
+
+    double bytesPerSecond = 297.0 * 1024 * 1024;  // 0 = as fast as the host reaps
+    size_t maxPacketSize = 1024;                  // SuperSpeed bulk
+    size_t deviceBufferBytes = 64 * 1024;         // FX3 DMA buffering before data is lost
+
+    // Fault injection (0 disables)
+    uint32_t stallEveryTransfers = 0;       // Device goes quiet every N transfers...
+    uint32_t stallMs = 0;                   // ...for this long
+    uint32_t shortPacketEveryTransfers = 0; // Every N transfers ends on a short packet
+    uint32_t seed = 1;
+};
+
+// Software stand-in for the FX3 bulk-IN endpoint.
+//
+// A device thread completes submitted transfers in order, filling them from
+// Fx3PatternGenerator at the configured line rate. When the host leaves the
+// device without a queued transfer for longer than its DMA buffering covers,
+// the bytes the sensor produced meanwhile are dropped, as on real hardware.
+// If the device thread itself falls behind (it shares the CPU with the host)
+// it just catches up; that is not counted against the host.
+class SimulatedFx3Transport : public BulkInTransport {
+public:
+    explicit SimulatedFx3Transport(const SimulatorConfig& config = SimulatorConfig());
+    ~SimulatedFx3Transport() override;
+
+    bool Open() override;
+    void Close() override;
+    bool IsOpen() const override { return m_open; }
+
+    bool Configure(int numSlots, size_t transferSize) override;
+    bool Submit(int slot, unsigned char* data, size_t length) override;
+    TransferStatus Reap(int slot, uint32_t timeoutMs, size_t& bytesTransferred) override;
+    TransferStatus ReapAny(uint32_t timeoutMs, int& slot, size_t& bytesTransferred) override;
+    void Abort() override;
+
+    size_t MaxPacketSize() const override { return m_config.maxPacketSize; }
+    const char* Name() const override { return "FX3 simulator"; }
+
+    // Bytes the simulated sensor produced that never reached the host.
+    uint64_t DroppedBytes() const override;
+
+private:
+    enum class SlotState { Idle, Queued, Done };
+
+    struct Slot {
+        SlotState state = SlotState::Idle;
+        unsigned char* data = nullptr;
+        size_t length = 0;
+        size_t transferred = 0;
+        TransferStatus status = TransferStatus::Failed;
+    };
+
+    void DeviceThread();
+    size_t CompletionLength(size_t requested);
+
+    SimulatorConfig m_config;
+    Fx3PatternGenerator m_generator;
+    std::mt19937 m_rng;
+
+    std::vector<Slot> m_slots;
+    std::deque<int> m_queue;        // Submitted slots in submission order
+    int m_activeSlot;               // Slot the device thread is filling, or -1
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_submitted;
+    std::condition_variable m_completed;
+    std::thread m_deviceThread;
+    bool m_open;
+    bool m_stopping;
+
+    std::chrono::steady_clock::time_point m_nextCompletion;
+    bool m_starved;                 // Queue ran dry after the last completion
+    uint64_t m_transferCount;
+    uint64_t m_droppedBytes;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Bounded single-producer/single-consumer ring buffer.
+//
+// Exactly one thread may call TryPush and exactly one thread may call TryPop.
+// Head and tail sit on their own cache lines, and each side keeps a private
+// copy of the other side's index so a handoff only touches the shared line
+// when the cached view says the ring looks full (producer) or empty (consumer).
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : m_mask(RoundUpPow2(capacity < 2 ? 2 : capacity) - 1)
+        , m_slots(std::make_unique<T[]>(m_mask + 1))
+        , m_head(0)
+        , m_cachedTail(0)
+        , m_tail(0)
+        , m_cachedHead(0)
+    {
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer side
+    bool TryPush(const T& value) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead > m_mask) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead > m_mask) {
+                return false;
+            }
+        }
+
+        m_slots[tail & m_mask] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool TryPop(T& value) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail) {
+                return false;
+            }
+        }
+
+        value = m_slots[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Snapshot only; may be stale by the time the caller looks at it.
+    bool Empty() const {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    size_t Size() const {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    size_t Capacity() const { return m_mask + 1; }
+
+    // Drops all queued items. Only valid while neither side is running.
+    void Clear() {
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+        m_cachedHead = 0;
+        m_cachedTail = 0;
+    }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    static size_t RoundUpPow2(size_t v) {
+        size_t p = 1;
+        while (p < v) p <<= 1;
+        return p;
+    }
+
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_slots;
+
+    // Consumer-owned line
+    alignas(CACHE_LINE) std::atomic<size_t> m_head;
+    size_t m_cachedTail;
+
+    // Producer-owned line
+    alignas(CACHE_LINE) std::atomic<size_t> m_tail;
+    size_t m_cachedHead;
+
+    // Keep whatever follows the ring off the producer's line
+    char m_pad[CACHE_LINE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+};
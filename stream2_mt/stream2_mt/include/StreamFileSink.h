@@ -0,0 +1,27 @@
+#pragma once
+
+#include <fstream>
+
+#include "FileSink.h"
+
+// The original writer: std::ofstream with a small stream buffer, flushed
+// every FLUSH_THRESHOLD bytes. Everything goes through the page cache.
+class StreamFileSink : public FileSink {
+public:
+    StreamFileSink();
+    ~StreamFileSink() override;
+
+    bool Open(const std::string& path, size_t expectedBytes) override;
+    bool Write(const unsigned char* data, size_t length) override;
+    bool Close() override;
+    bool IsOpen() const override { return m_outFile.is_open(); }
+
+    const char* Name() const override { return "ofstream"; }
+
+private:
+    std::ofstream m_outFile;
+    size_t m_bytesSinceFlush;
+
+    static constexpr size_t STREAM_BUFFER_SIZE = 16 * 1024;
+    static constexpr size_t FLUSH_THRESHOLD = 8 * 1024 * 1024;  // Flush every 8MB
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// What a sync word means. The values are the BT.656 code bytes the board sends.
+enum class SyncCode : uint8_t {
+    SAV = 0x80,   // Start of active video
+    EAV = 0x9D,   // End of active video
+    SAVI = 0xAB,  // Start of active video, invalid line
+    EAVI = 0xB6,  // End of active video, invalid line
+};
+
+// The sync words on each channel: an FF 00 00 preamble and a code byte, MSB
+// first. Another protocol variant is another struct with these members; the
+// matchers take it as a template parameter, so every word and table they use
+// is fixed at compile time.
+struct Bt656SyncCodes {
+    static constexpr unsigned PREAMBLE_BITS = 24;
+    static constexpr unsigned CODE_BITS = 8;
+    static constexpr uint32_t PREAMBLE = 0xFF0000;
+    static constexpr uint32_t SAV = 0x80;
+    static constexpr uint32_t EAV = 0x9D;
+    static constexpr uint32_t SAVI = 0xAB;
+    static constexpr uint32_t EAVI = 0xB6;
+};
+
+// Whole sync words of a code set, and a match on the last BITS bits of a
+// shift register (earliest bit highest)
+template <typename Codes>
+struct SyncWords {
+    static constexpr unsigned CODE_BITS = Codes::CODE_BITS;
+    static constexpr unsigned BITS = Codes::PREAMBLE_BITS + Codes::CODE_BITS;
+    static_assert(BITS <= 64, "sync word must fit a 64-bit window");
+
+    static constexpr uint64_t PREAMBLE_MASK = (uint64_t(1) << Codes::PREAMBLE_BITS) - 1;
+    static constexpr uint64_t CODE_MASK = (uint64_t(1) << CODE_BITS) - 1;
+
+    static constexpr uint64_t Word(uint32_t code) {
+        return (uint64_t(Codes::PREAMBLE) << CODE_BITS) | code;
+    }
+
+    static constexpr uint64_t SAV = Word(Codes::SAV);
+    static constexpr uint64_t EAV = Word(Codes::EAV);
+    static constexpr uint64_t SAVI = Word(Codes::SAVI);
+    static constexpr uint64_t EAVI = Word(Codes::EAVI);
+
+    // SyncCode of every code value, 0 for values that are not sync codes
+    static constexpr std::array<uint8_t, size_t(1) << CODE_BITS> ROLES = []() {
+        std::array<uint8_t, size_t(1) << CODE_BITS> roles{};
+        roles[Codes::SAV] = static_cast<uint8_t>(SyncCode::SAV);
+        roles[Codes::EAV] = static_cast<uint8_t>(SyncCode::EAV);
+        roles[Codes::SAVI] = static_cast<uint8_t>(SyncCode::SAVI);
+        roles[Codes::EAVI] = static_cast<uint8_t>(SyncCode::EAVI);
+        return roles;
+    }();
+
+    static constexpr bool Match(uint64_t window, SyncCode& code) {
+        if (((window >> CODE_BITS) & PREAMBLE_MASK) != Codes::PREAMBLE) {
+            return false;
+        }
+        const uint8_t role = ROLES[static_cast<size_t>(window & CODE_MASK)];
+        code = static_cast<SyncCode>(role);
+        return role != 0;
+    }
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Pairing of sync code positions. Every function here is a single merge over
+// ascending position arrays, O(n + m), where analyzeData used to rescan the
+// whole EAV list for each SAV.
+
+// Window in which a stop counts as the partner of a start, and where the
+// pseudo stop goes when none falls inside it
+struct SyncPairWindow {
+    size_t minBits = 1250;
+    size_t maxBits = 1750;
+    size_t fallbackBits = 1488;
+};
+
+// Values of b that also occur in a, ascending; a value repeated in b is
+// kept each time, as MATLAB-style intersect over a set of a did.
+std::vector<size_t> IntersectSorted(const std::vector<size_t>& a, const std::vector<size_t>& b);
+
+// For each key, the index of the first value strictly greater than it, or
+// values.size() when there is none
+std::vector<size_t> FirstAfter(const std::vector<size_t>& keys, const std::vector<size_t>& values);
+
+// Pairs each start with the first stop between minBits and maxBits after it,
+// or with start + fallbackBits. Stops may be shared. On return start is
+// unchanged and stop holds one partner per start, as matchIdxs did.
+void MatchSyncPairs(std::vector<size_t>& start, std::vector<size_t>& stop,
+                    const SyncPairWindow& window = SyncPairWindow());
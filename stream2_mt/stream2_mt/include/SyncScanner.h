@@ -0,0 +1,100 @@
+#pragma once
+
+#include "SyncCodes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct SyncMark {
+    uint64_t bit;   // Channel bit index of the first preamble bit
+    SyncCode code;
+};
+
+// Positions of every sync code on one channel, ascending
+struct SyncPositions {
+    std::vector<size_t> sav;
+    std::vector<size_t> eav;
+    std::vector<size_t> savi;
+    std::vector<size_t> eavi;
+};
+
+// Packs one channel of the bit-interleaved stream: raw bit 4k + channel
+// (bit 0 of the first little-endian word first) is channel bit k. Each input
+// word yields one byte, earliest channel bit in the MSB, so the byte stream
+// reads in the same order the sync codes are sent.
+void ExtractChannel(const uint32_t* words, size_t count, int channel, uint8_t* out);
+
+// The 8 channel bits starting at bit, MSB first, from a packed channel.
+// bit + 8 must not run past the end of the data.
+inline uint8_t ChannelByteAt(const uint8_t* packed, size_t bit) {
+    const size_t index = bit / 8;
+    const unsigned shift = static_cast<unsigned>(bit % 8);
+    if (shift == 0) {
+        return packed[index];
+    }
+    return static_cast<uint8_t>((packed[index] << shift) | (packed[index + 1] >> (8 - shift)));
+}
+
+// Finds sync codes in a packed channel byte stream without unpacking it.
+//
+// A 64-bit window slides a byte at a time; all eight bit alignments ending in
+// the new byte are checked against the preamble with one shift and compare
+// each, and the code is classified with a table lookup. Codes picks the
+// protocol variant at compile time. Feed() may be called with consecutive
+// pieces of a stream; codes spanning the boundary are found.
+template <typename Codes>
+class BasicSyncScanner {
+public:
+    using Words = SyncWords<Codes>;
+    static_assert(Words::BITS + 7 <= 64, "every alignment must fit the window");
+
+    BasicSyncScanner() { Reset(); }
+
+    void Reset() {
+        m_window = 0;
+        m_bytesSeen = 0;
+    }
+
+    // Appends the marks found in bytes to out
+    void Feed(const uint8_t* bytes, size_t count, std::vector<SyncMark>& out) {
+        for (size_t i = 0; i < count; ++i) {
+            m_window = (m_window << 8) | bytes[i];
+            const uint64_t byteIndex = m_bytesSeen++;
+
+            // No alignment matches while a preamble zero bit is set
+            if (m_window & ZERO_SCREEN) {
+                continue;
+            }
+
+            // Oldest alignment first so marks come out in stream order
+            for (int shift = 7; shift >= 0; --shift) {
+                SyncCode code;
+                if (Words::Match(m_window >> shift, code)) {
+                    out.push_back({ byteIndex * 8 - (Words::BITS - 8) - static_cast<uint64_t>(shift), code });
+                }
+            }
+        }
+    }
+
+    uint64_t BitsSeen() const { return m_bytesSeen * 8; }
+
+private:
+    // Preamble zeros at every alignment: window bits 15 .. 23 for FF 00 00 xx
+    static constexpr uint64_t ZERO_SCREEN = []() {
+        uint64_t screen = ~uint64_t(0);
+        for (unsigned shift = 0; shift < 8; ++shift) {
+            screen &= (~uint64_t(Codes::PREAMBLE) & Words::PREAMBLE_MASK) << (Words::CODE_BITS + shift);
+        }
+        return screen;
+    }();
+
+    uint64_t m_window;     // Last bytes fed, newest in the low byte
+    uint64_t m_bytesSeen;
+};
+
+using SyncScanner = BasicSyncScanner<Bt656SyncCodes>;
+
+// Scans one channel of raw capture words; same positions as unpacking every
+// bit and searching for each pattern bit by bit.
+SyncPositions ScanChannel(const uint32_t* words, size_t count, int channel);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Three values passed from one writer thread to one reader thread without
+// locks or waiting.
+//
+// The writer fills Back() and Publish()es it; the reader Update()s to the
+// newest published value and reads Front(). Each side owns one of the three
+// and the third sits in the middle, so the writer never touches what the
+// reader is looking at and neither ever waits for the other. A value the
+// reader has not picked up yet is replaced by the next one published.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Writer side
+    T& Back() { return m_values[m_back]; }
+
+    void Publish() {
+        const uint8_t old = m_middle.exchange(static_cast<uint8_t>(m_back | FRESH), std::memory_order_acq_rel);
+        m_back = old & INDEX;
+    }
+
+    // Reader side: true if Front() changed
+    bool Update() {
+        if (!(m_middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        const uint8_t old = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = old & INDEX;
+        return true;
+    }
+
+    const T& Front() const { return m_values[m_front]; }
+
+private:
+    static constexpr uint8_t INDEX = 3;
+    static constexpr uint8_t FRESH = 4;  // Middle holds a value the reader has not seen
+
+    std::array<T, 3> m_values;
+    uint8_t m_back = 0;                      // Writer only
+    uint8_t m_front = 1;                     // Reader only
+    alignas(64) std::atomic<uint8_t> m_middle{ 2 };
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#ifdef __linux__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <sys/uio.h>
+
+#include "FileSink.h"
+
+struct UringConfig {
+    unsigned entries = 64;     // Ring size, and the most writes kept in flight
+    bool sqPoll = true;        // Kernel thread polls the submission queue
+    unsigned sqIdleMs = 100;   // ...and goes to sleep after this long idle
+};
+
+// Asynchronous O_DIRECT writer on io_uring (raw syscalls, no liburing).
+//
+// Submit() queues each ring buffer as its own write and keeps it until the
+// completion comes back, so as many writes are outstanding as the reader has
+// full buffers; Reap() hands finished buffers back. Buffers allocated through
+// Allocator() and the output file are registered with the ring, so writes are
+// IORING_OP_WRITE_FIXED on a fixed file, and with SQPOLL the kernel picks up
+// submissions and completions are read from shared memory: no syscalls while
+// data is flowing.
+//
+// Alignment rules are the same as DirectFileSink; data that is not whole
+// aligned blocks is staged through a bounce buffer, written synchronously.
+class UringFileSink : public FileSink {
+public:
+    explicit UringFileSink(const UringConfig& config = UringConfig());
+    ~UringFileSink() override;
+
+    bool Open(const std::string& path, size_t expectedBytes) override;
+    bool Write(const unsigned char* data, size_t length) override;
+    bool Submit(Buffer* buffer, size_t length, const ReleaseFn& release) override;
+    bool Reap(bool wait) override;
+    size_t WritesInFlight() const override { return m_inFlight; }
+    bool Close() override;
+    bool IsOpen() const override { return m_fd >= 0; }
+
+    BufferAllocator Allocator() override;
+    const char* Name() const override { return "io_uring"; }
+
+private:
+    bool SetupRing();
+    void TeardownRing();
+    void RegisterBuffers();
+    int FixedBufferIndex(const unsigned char* data, size_t length) const;
+
+    // Queues one aligned write at the current file offset
+    bool QueueWrite(const unsigned char* data, size_t length, uint64_t userData);
+    bool Enter(unsigned toSubmit, unsigned minComplete, unsigned flags);
+
+    bool Stage(const unsigned char* data, size_t length);
+    bool FlushBounce(size_t length);
+
+    UringConfig m_config;
+    int m_fd;
+    int m_ringFd;
+    bool m_sqPollActive;
+    bool m_failed;
+
+    // Shared ring memory
+    void* m_sqRing;
+    void* m_cqRing;
+    size_t m_sqRingBytes;
+    size_t m_cqRingBytes;
+    void* m_sqes;
+    size_t m_sqesBytes;
+    unsigned* m_sqHead;
+    unsigned* m_sqTail;
+    unsigned* m_sqMask;
+    unsigned* m_sqFlags;
+    unsigned* m_sqArray;
+    unsigned* m_cqHead;
+    unsigned* m_cqTail;
+    unsigned* m_cqMask;
+    void* m_cqes;
+    unsigned m_sqEntries;
+
+    // Everything Allocator() handed out; shared with its lambdas so buffers
+    // can still be freed after the sink is gone
+    std::shared_ptr<std::vector<iovec>> m_allocations;
+    std::vector<iovec> m_fixedBuffers;  // As registered, bounce buffer last
+
+    ReleaseFn m_release;
+    size_t m_inFlight;
+    uint64_t m_fileOffset;      // Next write position, always block-aligned
+    uint64_t m_bytesQueued;     // Aligned bytes handed to the kernel
+    uint64_t m_bytesCompleted;  // ...and confirmed written
+    uint64_t m_bytesWritten;    // Logical file size so far
+
+    unsigned char* m_bounce;
+    size_t m_pending;
+    bool m_bounceBusy;
+
+    static constexpr size_t BOUNCE_SIZE = 1024 * 1024;
+    static constexpr uint64_t BOUNCE_TAG = 1;  // user_data of bounce writes; buffers are never at 1
+};
+
+#endif // __linux__
@@ -1,17 +1,64 @@
 #include "../include/BufferManager.h"
 #include <stdexcept>
 
-BufferManager::BufferManager(size_t bufferSize, int numBuffers)
-    : m_bufferSize(bufferSize)
+namespace {
+
+// Polls before going to sleep so a buffer landing a few microseconds later
+// does not pay for a condition-variable round trip.
+constexpr int WAIT_SPIN_COUNT = 256;
+
+// Ring capacity for numBuffers. Checked here, before the rings are built,
+// as a negative count cast to size_t would never finish rounding up.
+size_t CheckedBufferCount(int numBuffers) {
+    if (numBuffers <= 0 || numBuffers > BufferManager::MAX_BUFFERS) {
+        throw std::invalid_argument("BufferManager needs between 1 and 4096 buffers");
+    }
+    return static_cast<size_t>(numBuffers);
+}
+
+Buffer* WaitForBuffer(SpscRing<Buffer*>& ring, EventCount& ready,
+                      std::chrono::microseconds timeout) {
+    Buffer* buffer = nullptr;
+    for (int i = 0; i < WAIT_SPIN_COUNT; ++i) {
+        if (ring.TryPop(buffer)) {
+            return buffer;
+        }
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    const uint64_t key = ready.PrepareWait();
+    if (ring.TryPop(buffer)) {
+        ready.CancelWait();
+        return buffer;
+    }
+
+    ready.CommitWait(key, deadline);
+    ring.TryPop(buffer);
+    return buffer;
+}
+
+} // namespace
+
+BufferManager::BufferManager(size_t bufferSize, int numBuffers, const BufferAllocator& allocator)
+    : m_emptyBuffers(CheckedBufferCount(numBuffers))
+    , m_fullBuffers(CheckedBufferCount(numBuffers))
+    , m_bufferSize(bufferSize)
 {
-    // Create all buffers and add them to the empty queue
+    // Create all buffers and add them to the empty ring
     for (int i = 0; i < numBuffers; ++i) {
         auto buffer = std::make_unique<Buffer>();
-        buffer->data = std::make_unique<unsigned char[]>(bufferSize);
+        unsigned char* memory = allocator.allocate ? allocator.allocate(bufferSize) : nullptr;
+        if (memory) {
+            auto release = allocator.release;
+            buffer->data = { memory, [release, bufferSize](unsigned char* p) { release(p, bufferSize); } };
+        } else {
+            buffer->data = std::make_unique<unsigned char[]>(bufferSize);
+        }
         buffer->size = bufferSize;
         buffer->bytesUsed = 0;
+        buffer->sequence = 0;
 
-        m_emptyBuffers.push(buffer.get());
+        m_emptyBuffers.TryPush(buffer.get());
         m_allBuffers.push_back(std::move(buffer));
     }
 }
@@ -19,44 +66,56 @@ BufferManager::BufferManager(size_t bufferSize, int numBuffers)
 BufferManager::~BufferManager() = default;
 
 Buffer* BufferManager::GetEmptyBuffer() {
-    std::lock_guard<std::mutex> lock(m_emptyMutex);
-    if (m_emptyBuffers.empty()) {
-        return nullptr;
-    }
-
-    Buffer* buffer = m_emptyBuffers.front();
-    m_emptyBuffers.pop();
+    Buffer* buffer = nullptr;
+    m_emptyBuffers.TryPop(buffer);
     return buffer;
 }
 
 void BufferManager::QueueFullBuffer(Buffer* buffer) {
-    std::lock_guard<std::mutex> lock(m_fullMutex);
-    m_fullBuffers.push(buffer);
+    // Both rings hold every buffer we own, so a push can never fail
+    m_fullBuffers.TryPush(buffer);
+    m_fullReady.Notify();
 }
 
 Buffer* BufferManager::GetFullBuffer() {
-    std::lock_guard<std::mutex> lock(m_fullMutex);
-    if (m_fullBuffers.empty()) {
-        return nullptr;
-    }
-
-    Buffer* buffer = m_fullBuffers.front();
-    m_fullBuffers.pop();
+    Buffer* buffer = nullptr;
+    m_fullBuffers.TryPop(buffer);
     return buffer;
 }
 
 void BufferManager::ReturnEmptyBuffer(Buffer* buffer) {
-    std::lock_guard<std::mutex> lock(m_emptyMutex);
     buffer->bytesUsed = 0;  // Reset the used bytes count
-    m_emptyBuffers.push(buffer);
+    m_emptyBuffers.TryPush(buffer);
+    m_emptyReady.Notify();
+}
+
+Buffer* BufferManager::WaitForEmptyBuffer(std::chrono::microseconds timeout) {
+    return WaitForBuffer(m_emptyBuffers, m_emptyReady, timeout);
+}
+
+Buffer* BufferManager::WaitForFullBuffer(std::chrono::microseconds timeout) {
+    return WaitForBuffer(m_fullBuffers, m_fullReady, timeout);
+}
+
+void BufferManager::WakeAll() {
+    m_emptyReady.Notify();
+    m_fullReady.Notify();
 }
 
 bool BufferManager::HasEmptyBuffers() const {
-    std::lock_guard<std::mutex> lock(m_emptyMutex);
-    return !m_emptyBuffers.empty();
+    return !m_emptyBuffers.Empty();
 }
 
 bool BufferManager::HasFullBuffers() const {
-    std::lock_guard<std::mutex> lock(m_fullMutex);
-    return !m_fullBuffers.empty();
-}
\ No newline at end of file
+    return !m_fullBuffers.Empty();
+}
+
+void BufferManager::Reset() {
+    m_emptyBuffers.Clear();
+    m_fullBuffers.Clear();
+
+    for (auto& buffer : m_allBuffers) {
+        buffer->bytesUsed = 0;
+        m_emptyBuffers.TryPush(buffer.get());
+    }
+}
@@ -0,0 +1,81 @@
+#include "../include/CaptureScanner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace {
+
+// Words scanned ahead of each chunk: a 32-bit code with up to 7 bits of
+// misalignment spans 5 channel bytes, and the scanner window holds 8
+const size_t OVERLAP_WORDS = 8;
+
+void ScanChunk(const uint32_t* words, size_t begin, size_t end,
+               std::vector<uint8_t>& packed, std::vector<SyncMark>& marks) {
+    const size_t from = begin >= OVERLAP_WORDS ? begin - OVERLAP_WORDS : 0;
+    packed.resize(end - from);
+    ExtractChannel(words + from, end - from, 0, packed.data());
+
+    std::vector<SyncMark> found;
+    SyncScanner scanner;
+    scanner.Feed(packed.data(), packed.size(), found);
+
+    const uint64_t offset = static_cast<uint64_t>(from) * 8;
+    for (SyncMark mark : found) {
+        mark.bit += offset;
+        // Codes ending before the chunk belong to the previous one
+        if ((mark.bit + LinePairer::SYNC_BITS - 1) / 8 >= begin) {
+            marks.push_back(mark);
+        }
+    }
+}
+
+} // namespace
+
+CaptureScan ScanCapture(const uint32_t* words, size_t count, const CaptureScanConfig& config) {
+    CaptureScan scan;
+    if (count == 0) {
+        return scan;
+    }
+
+    const size_t chunkWords = std::max<size_t>(config.chunkWords, 1);
+    const size_t chunks = (count + chunkWords - 1) / chunkWords;
+    unsigned threads = config.threads ? config.threads : std::thread::hardware_concurrency();
+    threads = static_cast<unsigned>(std::min<size_t>(std::max<unsigned>(threads, 1), chunks));
+
+    std::vector<std::vector<SyncMark>> chunkMarks(chunks);
+    std::atomic<size_t> nextChunk(0);
+    const auto worker = [&]() {
+        std::vector<uint8_t> packed;
+        for (size_t chunk = nextChunk++; chunk < chunks; chunk = nextChunk++) {
+            const size_t begin = chunk * chunkWords;
+            ScanChunk(words, begin, std::min<size_t>(begin + chunkWords, count), packed, chunkMarks[chunk]);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    size_t total = 0;
+    for (const auto& marks : chunkMarks) {
+        total += marks.size();
+    }
+    scan.marks.reserve(total);
+    for (const auto& marks : chunkMarks) {
+        scan.marks.insert(scan.marks.end(), marks.begin(), marks.end());
+    }
+
+    LinePairer pairer;
+    const auto emit = [&scan](const LineSpan& span) { scan.lines.push_back(span); };
+    for (const SyncMark& mark : scan.marks) {
+        pairer.Mark(mark, emit);
+    }
+    pairer.Flush(static_cast<uint64_t>(count) * 8, emit);
+    return scan;
+}
@@ -0,0 +1,467 @@
+#include "../include/Clahe.h"
+#include "../include/CpuFeatures.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef CPU_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// A tile's pixel count, and so any bin, fits a signed 16-bit lane
+const int MAX_TILE_SIZE = 128;
+
+// Maps a pixel index to the tile centres on either side of it: the first
+// tile and the weight of the next one (0..256). Pixels before the first
+// centre or past the last take that tile alone.
+void TilesAround(int pixel, int tileSize, int tiles, int& first, int& second, int& weight) {
+    // Centre of tile t is at t * tileSize + tileSize / 2, in half pixels to stay exact
+    const int offset = 2 * pixel + 1 - tileSize;
+    if (offset <= 0) {
+        first = second = 0;
+        weight = 0;
+        return;
+    }
+    const int fixed = offset * 128 / tileSize;  // 256ths of a tile
+    first = fixed >> 8;
+    weight = fixed & 255;
+    second = first + 1;
+    if (second >= tiles) {
+        first = second = tiles - 1;
+        weight = 0;
+    }
+}
+
+// Adds up the four sub-histograms and cuts every bin at limit. Returns
+// how much was cut.
+uint32_t MergeClipped(const uint16_t (*sub)[256], uint16_t limit, uint16_t* histogram) {
+#ifdef CPU_X86
+    // Eight bins per step; no lane can total more than the tile's count
+    const __m128i cap = _mm_set1_epi16(static_cast<short>(limit));
+    __m128i cut = _mm_setzero_si128();
+    for (int i = 0; i < 256; i += 8) {
+        const __m128i bin = _mm_add_epi16(
+            _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sub[0] + i)),
+                          _mm_loadu_si128(reinterpret_cast<const __m128i*>(sub[1] + i))),
+            _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sub[2] + i)),
+                          _mm_loadu_si128(reinterpret_cast<const __m128i*>(sub[3] + i))));
+        const __m128i kept = _mm_min_epi16(bin, cap);
+        cut = _mm_add_epi16(cut, _mm_sub_epi16(bin, kept));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(histogram + i), kept);
+    }
+    cut = _mm_madd_epi16(cut, _mm_set1_epi16(1));
+    cut = _mm_add_epi32(cut, _mm_shuffle_epi32(cut, _MM_SHUFFLE(1, 0, 3, 2)));
+    cut = _mm_add_epi32(cut, _mm_shuffle_epi32(cut, _MM_SHUFFLE(2, 3, 0, 1)));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(cut));
+#else
+    uint32_t cut = 0;
+    for (int i = 0; i < 256; ++i) {
+        const uint16_t bin = static_cast<uint16_t>(sub[0][i] + sub[1][i] + sub[2][i] + sub[3][i]);
+        histogram[i] = std::min<uint16_t>(bin, limit);
+        cut += bin - histogram[i];
+    }
+    return cut;
+#endif
+}
+
+// What was cut goes back spread evenly: excess / 256 to every bin, and the
+// remainder one each to bins 0, step, 2 * step and so on
+uint32_t ResidualStep(uint32_t residual) {
+    return residual > 0 ? std::max<uint32_t>(256 / residual, 1) : 256;
+}
+
+// The LUT of a clipped histogram, with excess spread back in so the bins add
+// up to count: 255 * CDF / count, rounded. Rounding up the 2^48 / count
+// reciprocal keeps the quotient exact for any count a tile can have.
+void CumulateScalar(const uint16_t* histogram, uint32_t excess, uint32_t count, uint8_t* lut) {
+    const uint64_t reciprocal = ((uint64_t(1) << 48) + count - 1) / count;
+    const uint32_t spread = excess / 256;
+    uint32_t residual = excess % 256;
+    const uint32_t step = ResidualStep(residual);
+    uint32_t nextResidual = 0;
+    uint32_t scaled = count / 2;  // 255 * CDF, plus half a step to round
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t bin = histogram[i] + spread;
+        if (i == nextResidual && residual > 0) {
+            ++bin;
+            --residual;
+            nextResidual += step;
+        }
+        scaled += bin * 255;
+        lut[i] = static_cast<uint8_t>((static_cast<uint64_t>(scaled) * reciprocal) >> 48);
+    }
+}
+
+// Packs the LUTs of a cell's four corner tiles byte by byte: top left in the
+// low byte, then top right, bottom left and bottom right
+void PackQuads(const uint8_t* topLeft, const uint8_t* topRight, const uint8_t* bottomLeft,
+               const uint8_t* bottomRight, uint32_t* quads) {
+#ifdef CPU_X86
+    for (int v = 0; v < 256; v += 16) {
+        const __m128i tl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(topLeft + v));
+        const __m128i tr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(topRight + v));
+        const __m128i bl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottomLeft + v));
+        const __m128i br = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottomRight + v));
+        const __m128i upperLow = _mm_unpacklo_epi8(tl, tr);
+        const __m128i upperHigh = _mm_unpackhi_epi8(tl, tr);
+        const __m128i lowerLow = _mm_unpacklo_epi8(bl, br);
+        const __m128i lowerHigh = _mm_unpackhi_epi8(bl, br);
+        __m128i* out = reinterpret_cast<__m128i*>(quads + v);
+        _mm_storeu_si128(out, _mm_unpacklo_epi16(upperLow, lowerLow));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(upperLow, lowerLow));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(upperHigh, lowerHigh));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(upperHigh, lowerHigh));
+    }
+#else
+    for (int v = 0; v < 256; ++v) {
+        quads[v] = static_cast<uint32_t>(topLeft[v]) | static_cast<uint32_t>(topRight[v]) << 8 |
+                   static_cast<uint32_t>(bottomLeft[v]) << 16 | static_cast<uint32_t>(bottomRight[v]) << 24;
+    }
+#endif
+}
+
+// Maps one row through the quads of the cell row it lies in: each pixel
+// blends its tiles above and below by the row's weight, then the left and
+// right results by the column's. Weights are 256ths, as TilesAround gives.
+//
+// A side's top and bottom bytes, masked out as 16-bit halves, times
+// bottomWeight | topWeight << 16 leave top * topWeight + bottom *
+// bottomWeight in the product's high half: neither that nor the low half
+// passes 255 * 256, so nothing carries between them. The horizontal blend
+// may go negative part way, but wraps back to the right total.
+void MapRowScalar(uint8_t* row, int width, const uint32_t* quads, const uint32_t* column,
+                  const uint32_t* rightWeight, uint32_t bottomWeight) {
+    const uint32_t vertical = bottomWeight | (256 - bottomWeight) << 16;
+    for (int x = 0; x < width; ++x) {
+        const uint32_t quad = quads[column[x] + row[x]];
+        const uint32_t left = ((quad & 0x00FF00FF) * vertical) >> 16;
+        const uint32_t right = (((quad >> 8) & 0x00FF00FF) * vertical) >> 16;
+        row[x] = static_cast<uint8_t>((left * 256 + (right - left) * rightWeight[x] + 32768) >> 16);
+    }
+}
+
+#ifdef CPU_X86
+
+// Eight bins of the running sum: a prefix sum within each 128-bit half, the
+// low half's total carried into the high one, then the carry from before
+TARGET_AVX2 inline __m256i PrefixSum(__m256i bins, __m256i& carry) {
+    bins = _mm256_add_epi32(bins, _mm256_slli_si256(bins, 4));
+    bins = _mm256_add_epi32(bins, _mm256_slli_si256(bins, 8));
+    const __m256i halfTotal = _mm256_shuffle_epi32(bins, _MM_SHUFFLE(3, 3, 3, 3));
+    bins = _mm256_add_epi32(bins, _mm256_permute2x128_si256(halfTotal, halfTotal, 0x08));
+    bins = _mm256_add_epi32(bins, carry);
+    carry = _mm256_permutevar8x32_epi32(bins, _mm256_set1_epi32(7));
+    return bins;
+}
+
+// As CumulateScalar, 32 entries per step, with the remainder of the excess
+// counted straight into the CDF: up to bin i it adds min(residual, i / step
+// + 1). The float divides are exact here: 255 * count fits a float's
+// mantissa, and a quotient that is not whole is at least 1 / count (or
+// 1 / step) clear of the next integer, further than it can round.
+TARGET_AVX2 void CumulateAvx2(const uint16_t* histogram, uint32_t excess, uint32_t count, uint8_t* lut) {
+    const uint32_t residual = excess % 256;
+    const __m256i spread = _mm256_set1_epi32(static_cast<int>(excess / 256));
+    const __m256i residualCap = _mm256_set1_epi32(static_cast<int>(residual));
+    const __m256 step = _mm256_set1_ps(static_cast<float>(ResidualStep(residual)));
+    const __m256i half = _mm256_set1_epi32(static_cast<int>(count / 2));
+    const __m256 divisor = _mm256_set1_ps(static_cast<float>(count));
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i carry = _mm256_setzero_si256();
+    for (int i = 0; i < 256; i += 32) {
+        __m256i q[4];
+        for (int k = 0; k < 4; ++k) {
+            const __m128i bins = _mm_loadu_si128(reinterpret_cast<const __m128i*>(histogram + i + 8 * k));
+            const __m256i residuals = _mm256_min_epi32(
+                _mm256_add_epi32(_mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(index), step)), one), residualCap);
+            __m256i cdf = PrefixSum(_mm256_add_epi32(_mm256_cvtepu16_epi32(bins), spread), carry);
+            cdf = _mm256_add_epi32(cdf, residuals);
+            const __m256i scaled = _mm256_add_epi32(_mm256_sub_epi32(_mm256_slli_epi32(cdf, 8), cdf), half);
+            q[k] = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(scaled), divisor));
+            index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+        }
+        // Down to bytes, which the packs leave interleaved by 128-bit lane
+        const __m256i out = _mm256_packus_epi16(_mm256_packus_epi32(q[0], q[1]), _mm256_packus_epi32(q[2], q[3]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lut + i), _mm256_permutevar8x32_epi32(out, order));
+    }
+}
+
+// Eight pixels' quads by plain loads, which beat the gather instruction on
+// the CPUs that microcode it
+TARGET_AVX2 inline __m256i LoadQuads(const uint32_t* quads, const uint32_t* column, const uint8_t* pixels) {
+    return _mm256_setr_epi32(
+        static_cast<int>(quads[column[0] + pixels[0]]), static_cast<int>(quads[column[1] + pixels[1]]),
+        static_cast<int>(quads[column[2] + pixels[2]]), static_cast<int>(quads[column[3] + pixels[3]]),
+        static_cast<int>(quads[column[4] + pixels[4]]), static_cast<int>(quads[column[5] + pixels[5]]),
+        static_cast<int>(quads[column[6] + pixels[6]]), static_cast<int>(quads[column[7] + pixels[7]]));
+}
+
+// Top and bottom bytes pair up as 16-bit lanes (top left with bottom left,
+// top right with bottom right), so one multiply-add per side does the
+// vertical blend. Both sides are at most 255 * 256, so the horizontal one
+// needs 32 bits.
+TARGET_AVX2 inline __m256i BlendQuads(__m256i quad, __m256i rightWeight, __m256i vertical) {
+    const __m256i pairs = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i left = _mm256_madd_epi16(_mm256_and_si256(quad, pairs), vertical);
+    const __m256i right = _mm256_madd_epi16(_mm256_and_si256(_mm256_srli_epi32(quad, 8), pairs), vertical);
+    const __m256i blend = _mm256_add_epi32(_mm256_slli_epi32(left, 8),
+                                           _mm256_mullo_epi32(_mm256_sub_epi32(right, left), rightWeight));
+    return _mm256_srli_epi32(_mm256_add_epi32(blend, _mm256_set1_epi32(32768)), 16);
+}
+
+TARGET_AVX2 void MapRowAvx2(uint8_t* row, int width, const uint32_t* quads, const uint32_t* column,
+                            const uint32_t* rightWeight, uint32_t bottomWeight) {
+    const __m256i vertical = _mm256_set1_epi32(static_cast<int>((256 - bottomWeight) | bottomWeight << 16));
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 0, 0, 0, 0);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m256i a = BlendQuads(LoadQuads(quads, column + x, row + x),
+                                     _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rightWeight + x)), vertical);
+        const __m256i b = BlendQuads(LoadQuads(quads, column + x + 8, row + x + 8),
+                                     _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rightWeight + x + 8)), vertical);
+        // Down to bytes, which the packs leave interleaved by 128-bit lane
+        __m256i out = _mm256_packus_epi16(_mm256_packus_epi32(a, b), _mm256_setzero_si256());
+        out = _mm256_permutevar8x32_epi32(out, order);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), _mm256_castsi256_si128(out));
+    }
+    if (x < width) {
+        MapRowScalar(row + x, width - x, quads, column + x, rightWeight + x, bottomWeight);
+    }
+}
+
+#endif // CPU_X86
+
+using CumulateFn = void (*)(const uint16_t*, uint32_t, uint32_t, uint8_t*);
+
+CumulateFn BestCumulate() {
+#ifdef CPU_X86
+    if (CpuHasAvx2()) {
+        return CumulateAvx2;
+    }
+#endif
+    return CumulateScalar;
+}
+
+using MapRowFn = void (*)(uint8_t*, int, const uint32_t*, const uint32_t*, const uint32_t*, uint32_t);
+
+MapRowFn BestMapRow() {
+#ifdef CPU_X86
+    if (CpuHasAvx2()) {
+        return MapRowAvx2;
+    }
+#endif
+    return MapRowScalar;
+}
+
+} // namespace
+
+ClaheEngine::ClaheEngine(const ClaheConfig& config)
+    : m_config(config)
+    , m_threads(config.threads ? config.threads : std::max<unsigned>(std::thread::hardware_concurrency(), 1u))
+    , m_pixels(nullptr)
+    , m_width(0)
+    , m_height(0)
+    , m_tilesX(0)
+    , m_tilesY(0)
+    , m_generation(0)
+    , m_busy(0)
+    , m_quit(false)
+    , m_phase(Phase::Luts)
+    , m_jobs(0)
+    , m_nextJob(0)
+{
+    m_config.tileSize = std::clamp<int>(m_config.tileSize, 8, MAX_TILE_SIZE);
+}
+
+ClaheEngine::~ClaheEngine() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void ClaheEngine::Apply(uint8_t* pixels, int width, int height) {
+    if (!pixels || width <= 0 || height <= 0) {
+        return;
+    }
+    // The caller's thread works too, so it takes one fewer. Started here so
+    // an engine that never equalizes costs no threads.
+    while (m_workers.size() + 1 < m_threads) {
+        m_workers.emplace_back(&ClaheEngine::WorkerLoop, this);
+    }
+    Layout(width, height);
+    m_pixels = pixels;
+
+    // Every LUT has to come from the untouched image before any pixel is mapped
+    Parallel(Phase::Luts, m_tilesY);
+    Parallel(Phase::Quads, m_tilesY);
+    Parallel(Phase::Map, m_tilesY);
+    m_pixels = nullptr;
+}
+
+void ClaheEngine::Layout(int width, int height) {
+    const int tileSize = m_config.tileSize;
+    m_height = height;
+    m_tilesY = (height + tileSize - 1) / tileSize;
+    if (width != m_width) {
+        m_width = width;
+        m_tilesX = (width + tileSize - 1) / tileSize;
+        m_column.resize(static_cast<size_t>(width));
+        m_rightWeight.resize(static_cast<size_t>(width));
+        for (int x = 0; x < width; ++x) {
+            int left, right, weight;
+            TilesAround(x, tileSize, m_tilesX, left, right, weight);
+            m_column[x] = static_cast<uint32_t>(left) * 256;
+            m_rightWeight[x] = static_cast<uint32_t>(weight);
+        }
+    }
+    m_luts.resize(static_cast<size_t>(m_tilesX) * m_tilesY * 256);
+    m_quads.resize(m_luts.size());
+}
+
+void ClaheEngine::RunJob(Phase phase, int tileRow) {
+    switch (phase) {
+    case Phase::Luts:
+        BuildLuts(tileRow);
+        break;
+    case Phase::Quads:
+        BuildQuads(tileRow);
+        break;
+    case Phase::Map:
+        MapRows(tileRow);
+        break;
+    }
+}
+
+void ClaheEngine::BuildLuts(int tileRow) {
+    static const CumulateFn cumulate = BestCumulate();
+    const int tileSize = m_config.tileSize;
+    const int y0 = tileRow * tileSize;
+    const int y1 = std::min<int>(y0 + tileSize, m_height);
+
+    for (int tileX = 0; tileX < m_tilesX; ++tileX) {
+        const int x0 = tileX * tileSize;
+        const int columns = std::min<int>(x0 + tileSize, m_width) - x0;
+
+        // Consecutive pixels go to different sub-histograms, so a run of one
+        // value is not a chain of increments to the same counter
+        uint16_t sub[4][256];
+        std::memset(sub, 0, sizeof(sub));
+        for (int y = y0; y < y1; ++y) {
+            const uint8_t* row = m_pixels + static_cast<size_t>(y) * m_width + x0;
+            int x = 0;
+            for (; x + 8 <= columns; x += 8) {
+                uint64_t v;
+                std::memcpy(&v, row + x, 8);
+                ++sub[0][v & 0xFF];
+                ++sub[1][(v >> 8) & 0xFF];
+                ++sub[2][(v >> 16) & 0xFF];
+                ++sub[3][(v >> 24) & 0xFF];
+                ++sub[0][(v >> 32) & 0xFF];
+                ++sub[1][(v >> 40) & 0xFF];
+                ++sub[2][(v >> 48) & 0xFF];
+                ++sub[3][v >> 56];
+            }
+            for (; x < columns; ++x) {
+                ++sub[0][row[x]];
+            }
+        }
+
+        const uint32_t count = static_cast<uint32_t>(columns * (y1 - y0));
+        const uint32_t limit = (m_config.clipLimit > 0.0)
+            ? std::clamp<uint32_t>(static_cast<uint32_t>(m_config.clipLimit * count / 256), 1, count)
+            : count;
+        uint16_t histogram[256];
+        const uint32_t excess = MergeClipped(sub, static_cast<uint16_t>(limit), histogram);
+
+        cumulate(histogram, excess, count, &m_luts[(static_cast<size_t>(tileRow) * m_tilesX + tileX) * 256]);
+    }
+}
+
+void ClaheEngine::BuildQuads(int tileRow) {
+    const size_t lutRow = static_cast<size_t>(m_tilesX) * 256;
+    const uint8_t* top = m_luts.data() + tileRow * lutRow;
+    const uint8_t* bottom = m_luts.data() + std::min<int>(tileRow + 1, m_tilesY - 1) * lutRow;
+    uint32_t* quads = m_quads.data() + tileRow * lutRow;
+
+    for (int tileX = 0; tileX < m_tilesX; ++tileX) {
+        const size_t left = static_cast<size_t>(tileX) * 256;
+        const size_t right = static_cast<size_t>(std::min<int>(tileX + 1, m_tilesX - 1)) * 256;
+        PackQuads(top + left, top + right, bottom + left, bottom + right, quads + left);
+    }
+}
+
+void ClaheEngine::MapRows(int tileRow) {
+    static const MapRowFn mapRow = BestMapRow();
+    const int tileSize = m_config.tileSize;
+    const int y0 = tileRow * tileSize;
+    const int y1 = std::min<int>(y0 + tileSize, m_height);
+    const size_t quadRow = static_cast<size_t>(m_tilesX) * 256;
+
+    for (int y = y0; y < y1; ++y) {
+        // A row past the last centre has top == bottom and weight 0, so the
+        // quads' second tile row never counts
+        int topTile, bottomTile, bottomWeight;
+        TilesAround(y, tileSize, m_tilesY, topTile, bottomTile, bottomWeight);
+        mapRow(m_pixels + static_cast<size_t>(y) * m_width, m_width, m_quads.data() + topTile * quadRow,
+               m_column.data(), m_rightWeight.data(), static_cast<uint32_t>(bottomWeight));
+    }
+}
+
+void ClaheEngine::Parallel(Phase phase, int jobs) {
+    if (m_workers.empty() || jobs <= 1) {
+        for (int job = 0; job < jobs; ++job) {
+            RunJob(phase, job);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_phase = phase;
+        m_jobs = jobs;
+        m_nextJob = 0;
+        m_busy = m_workers.size();
+        ++m_generation;
+    }
+    m_wake.notify_all();
+    DrainJobs();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_busy == 0; });
+}
+
+void ClaheEngine::DrainJobs() {
+    for (int job = m_nextJob++; job < m_jobs; job = m_nextJob++) {
+        RunJob(m_phase, job);
+    }
+}
+
+void ClaheEngine::WorkerLoop() {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&]() { return m_quit || m_generation != seen; });
+            if (m_quit) {
+                return;
+            }
+            seen = m_generation;
+        }
+        DrainJobs();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_busy == 0) {
+                m_done.notify_one();
+            }
+        }
+    }
+}
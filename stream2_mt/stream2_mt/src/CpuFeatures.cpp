@@ -0,0 +1,38 @@
+#include "../include/CpuFeatures.h"
+
+#if defined(CPU_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+bool CpuHasAvx2() {
+#if !defined(CPU_X86)
+    return false;
+#elif defined(_MSC_VER)
+    static const bool has = []() {
+        int regs[4];
+        __cpuid(regs, 1);
+        const bool osSavesYmm = (regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(regs, 7, 0);
+        return osSavesYmm && (regs[1] & (1 << 5)) != 0;
+    }();
+    return has;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+bool CpuHasBmi2() {
+#if !defined(CPU_X86)
+    return false;
+#elif defined(_MSC_VER)
+    static const bool has = []() {
+        int regs[4];
+        __cpuidex(regs, 7, 0);
+        return (regs[1] & (1 << 8)) != 0;
+    }();
+    return has;
+#else
+    return __builtin_cpu_supports("bmi2");
+#endif
+}
@@ -0,0 +1,216 @@
+#ifdef _WIN32
+
+#include "../include/CyUsbTransport.h"
+#include <iostream>
+
+CyUsbTransport::CyUsbTransport(int deviceIndex)
+    : m_deviceIndex(deviceIndex)
+    , m_bulkEndpoint(nullptr)
+    , m_nextWaitSlot(0)
+{
+}
+
+CyUsbTransport::~CyUsbTransport() {
+    Close();
+}
+
+bool CyUsbTransport::Open() {
+    // Create USB device object
+    m_usbDevice = std::make_unique<CCyUSBDevice>(nullptr);
+
+    // Open the requested device
+    if (!m_usbDevice->Open(static_cast<UCHAR>(m_deviceIndex))) {
+        std::cerr << "Failed to open USB device" << std::endl;
+        m_usbDevice.reset();
+        return false;
+    }
+
+    // Get bulk endpoint
+    m_bulkEndpoint = m_usbDevice->BulkInEndPt;
+    if (!m_bulkEndpoint) {
+        std::cerr << "Failed to get bulk endpoint" << std::endl;
+        m_usbDevice->Close();
+        m_usbDevice.reset();
+        return false;
+    }
+
+    m_bulkEndpoint->TimeOut = ENDPOINT_TIMEOUT;
+
+    // Print endpoint details for debugging
+    std::cout << "Endpoint Address: 0x" << std::hex
+              << static_cast<int>(m_bulkEndpoint->Address) << std::dec << std::endl;
+    std::cout << "Max Packet Size: " << m_bulkEndpoint->MaxPktSize << " bytes" << std::endl;
+
+    return true;
+}
+
+void CyUsbTransport::Close() {
+    if (m_bulkEndpoint) {
+        Abort();
+    }
+    ReleaseSlots();
+
+    if (m_usbDevice) {
+        m_usbDevice->Close();
+        m_usbDevice.reset();
+    }
+    m_bulkEndpoint = nullptr;
+}
+
+bool CyUsbTransport::Configure(int numSlots, size_t transferSize) {
+    if (!m_bulkEndpoint || numSlots <= 0) {
+        return false;
+    }
+
+    ReleaseSlots();
+    m_bulkEndpoint->SetXferSize(static_cast<ULONG>(transferSize));
+
+    m_slots.resize(static_cast<size_t>(numSlots));
+    for (auto& slot : m_slots) {
+        ZeroMemory(&slot.overlapped, sizeof(OVERLAPPED));
+        slot.overlapped.hEvent = CreateEventA(NULL, false, false, NULL);
+        slot.context = nullptr;
+        slot.data = nullptr;
+        slot.length = 0;
+        slot.inFlight = false;
+        slot.aborted = false;
+
+        if (!slot.overlapped.hEvent) {
+            std::cerr << "Failed to create transfer event" << std::endl;
+            ReleaseSlots();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool CyUsbTransport::Submit(int slot, unsigned char* data, size_t length) {
+    if (slot < 0 || slot >= static_cast<int>(m_slots.size())) {
+        return false;
+    }
+
+    Slot& s = m_slots[static_cast<size_t>(slot)];
+    if (s.inFlight) {
+        return false;
+    }
+
+    s.data = data;
+    s.length = static_cast<LONG>(length);
+    s.aborted = false;
+    s.context = m_bulkEndpoint->BeginDataXfer(s.data, s.length, &s.overlapped);
+    if (!s.context) {
+        return false;
+    }
+
+    s.inFlight = true;
+    return true;
+}
+
+TransferStatus CyUsbTransport::Reap(int slot, uint32_t timeoutMs, size_t& bytesTransferred) {
+    bytesTransferred = 0;
+    if (slot < 0 || slot >= static_cast<int>(m_slots.size())) {
+        return TransferStatus::Failed;
+    }
+
+    Slot& s = m_slots[static_cast<size_t>(slot)];
+    if (!s.inFlight) {
+        if (s.aborted) {
+            s.aborted = false;
+            return TransferStatus::Aborted;
+        }
+        return TransferStatus::Failed;
+    }
+
+    if (WaitForSingleObject(s.overlapped.hEvent, timeoutMs) != WAIT_OBJECT_0) {
+        return TransferStatus::Timeout;
+    }
+
+    return Finish(s, bytesTransferred) ? TransferStatus::Completed : TransferStatus::Failed;
+}
+
+TransferStatus CyUsbTransport::ReapAny(uint32_t timeoutMs, int& slot, size_t& bytesTransferred) {
+    slot = -1;
+    bytesTransferred = 0;
+
+    const int numSlots = static_cast<int>(m_slots.size());
+    m_waitHandles.clear();
+    m_waitSlots.clear();
+    for (int k = 0; k < numSlots; ++k) {
+        const int i = (m_nextWaitSlot + k) % numSlots;
+        Slot& s = m_slots[static_cast<size_t>(i)];
+
+        // Abort() has already finished cancelled transfers
+        if (!s.inFlight && s.aborted) {
+            s.aborted = false;
+            slot = i;
+            return TransferStatus::Aborted;
+        }
+        if (s.inFlight && m_waitHandles.size() < MAXIMUM_WAIT_OBJECTS) {
+            m_waitHandles.push_back(s.overlapped.hEvent);
+            m_waitSlots.push_back(i);
+        }
+    }
+
+    if (m_waitHandles.empty()) {
+        return TransferStatus::Failed;
+    }
+
+    const DWORD result = WaitForMultipleObjects(static_cast<DWORD>(m_waitHandles.size()),
+                                                m_waitHandles.data(), FALSE, timeoutMs);
+    if (result < WAIT_OBJECT_0 || result >= WAIT_OBJECT_0 + m_waitHandles.size()) {
+        return TransferStatus::Timeout;
+    }
+
+    slot = m_waitSlots[result - WAIT_OBJECT_0];
+    m_nextWaitSlot = (slot + 1) % numSlots;
+    return Finish(m_slots[static_cast<size_t>(slot)], bytesTransferred)
+        ? TransferStatus::Completed : TransferStatus::Failed;
+}
+
+void CyUsbTransport::Abort() {
+    if (!m_bulkEndpoint) {
+        return;
+    }
+
+    m_bulkEndpoint->Abort();
+
+    // Every cancelled transfer still has to go through FinishDataXfer so the
+    // driver drops its reference to the buffer and CyAPI frees the context.
+    for (auto& s : m_slots) {
+        if (!s.inFlight) {
+            continue;
+        }
+        WaitForSingleObject(s.overlapped.hEvent, ENDPOINT_TIMEOUT);
+
+        size_t ignored = 0;
+        Finish(s, ignored);
+        s.aborted = true;
+    }
+}
+
+size_t CyUsbTransport::MaxPacketSize() const {
+    return m_bulkEndpoint ? static_cast<size_t>(m_bulkEndpoint->MaxPktSize) : 0;
+}
+
+bool CyUsbTransport::Finish(Slot& slot, size_t& bytesTransferred) {
+    LONG length = slot.length;
+    const bool ok = m_bulkEndpoint->FinishDataXfer(slot.data, length, &slot.overlapped, slot.context);
+
+    slot.inFlight = false;
+    slot.context = nullptr;
+    bytesTransferred = ok ? static_cast<size_t>(length) : 0;
+    return ok;
+}
+
+void CyUsbTransport::ReleaseSlots() {
+    for (auto& s : m_slots) {
+        if (s.overlapped.hEvent) {
+            CloseHandle(s.overlapped.hEvent);
+            s.overlapped.hEvent = NULL;
+        }
+    }
+    m_slots.clear();
+}
+
+#endif // _WIN32
@@ -1,14 +1,31 @@
 #include "../include/DataStreamer.h"
 #include "../include/BufferManager.h"
+#include "../include/ReorderStage.h"
+#include "../include/StreamFileSink.h"
+#include <algorithm>
 #include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#endif
 
-DataStreamer::DataStreamer()
-    : m_usbDevice(nullptr)
-    , m_bulkEndpoint(nullptr)
+DataStreamer::DataStreamer(std::unique_ptr<BulkInTransport> transport)
+    : m_transport(std::move(transport))
     , m_running(false)
+    , m_numBuffers(DEFAULT_NUM_BUFFERS)
+    , m_bufferSize(DEFAULT_BUFFER_SIZE)
     , m_targetBytes(0)
     , m_totalBytesWritten(0)
+    , m_usbCompletions(MetricsRegistry::Global().Counter("usb_completions_total", "Bulk transfers completed"))
+    , m_usbBytes(MetricsRegistry::Global().Counter("usb_bytes_total", "Bytes received over USB"))
+    , m_usbShortTransfers(MetricsRegistry::Global().Counter("usb_short_transfers_total", "Transfers ended early by a short packet"))
+    , m_usbFailedTransfers(MetricsRegistry::Global().Counter("usb_failed_transfers_total", "Transfers aborted or failed"))
+    , m_usbTimeouts(MetricsRegistry::Global().Counter("usb_timeouts_total", "Times every transfer was cancelled after nothing completed"))
+    , m_usbInFlight(MetricsRegistry::Global().Gauge("usb_in_flight", "Transfers queued on the endpoint"))
+    , m_writerQueue(MetricsRegistry::Global().Gauge("writer_queue_buffers", "Full buffers waiting for the disk writer"))
+    , m_diskBytes(MetricsRegistry::Global().Counter("disk_bytes_total", "Bytes handed to the disk writer"))
+    , m_diskSubmitUs(MetricsRegistry::Global().Histogram("disk_submit_us", "Time in FileSink::Submit() per buffer"))
 {
 }
 
@@ -16,50 +33,69 @@ DataStreamer::~DataStreamer() {
     StopStreaming();
 }
 
-bool DataStreamer::Initialize(size_t totalBytes) {
+bool DataStreamer::SetQueueConfig(int numBuffers, size_t bufferSize) {
+    if (m_running || m_bufferManager || numBuffers <= 0 || numBuffers > BufferManager::MAX_BUFFERS ||
+        bufferSize < 4) {
+        return false;
+    }
+
+    m_numBuffers = numBuffers;
+    m_bufferSize = bufferSize & ~size_t(0x3);  // Aligned to 4-byte boundary
+    return true;
+}
+
+bool DataStreamer::SetFileSink(std::unique_ptr<FileSink> sink) {
+    if (m_running || !sink || (m_sink && m_sink->IsOpen())) {
+        return false;
+    }
+
+    m_sink = std::move(sink);
+    return true;
+}
+
+bool DataStreamer::Initialize(size_t totalBytes, const std::string& outputPath) {
     m_targetBytes = totalBytes;
     m_totalBytesWritten = 0;
-    
-    // Create USB device object
-    m_usbDevice = std::make_unique<CCyUSBDevice>(nullptr);
 
-    // Open the first available device
-    if (!m_usbDevice->Open(0)) {
-        std::cerr << "Failed to open USB device" << std::endl;
+    if (!m_transport) {
+        std::cerr << "No USB transport" << std::endl;
         return false;
     }
 
-    // Get bulk endpoint
-    m_bulkEndpoint = m_usbDevice->BulkInEndPt;
-    if (!m_bulkEndpoint) {
-        std::cerr << "Failed to get bulk endpoint" << std::endl;
+    // Open the device behind the transport (the auto-tuner may have already)
+    if (!m_transport->IsOpen() && !m_transport->Open()) {
+        std::cerr << "Failed to open " << m_transport->Name() << " transport" << std::endl;
         return false;
     }
 
-    // Configure endpoint with improved settings
-    m_bulkEndpoint->TimeOut = USB_TIMEOUT;
-    m_bulkEndpoint->SetXferSize(BUFFER_SIZE);
+    // One transfer slot per buffer
+    if (!m_transport->Configure(m_numBuffers, m_bufferSize)) {
+        std::cerr << "Failed to configure bulk transfers" << std::endl;
+        return false;
+    }
 
-    // Print endpoint details for debugging
-    std::cout << "Endpoint Address: 0x" << std::hex 
-              << static_cast<int>(m_bulkEndpoint->Address) << std::dec << std::endl;
-    std::cout << "Max Packet Size: " << m_bulkEndpoint->MaxPktSize << " bytes" << std::endl;
+    std::cout << "Transport: " << m_transport->Name() << std::endl;
+    std::cout << "Queue: " << m_numBuffers << " x " << m_bufferSize << " bytes" << std::endl;
 
-    // Create buffer manager
-    m_bufferManager = std::make_unique<BufferManager>(BUFFER_SIZE, NUM_BUFFERS);
+    if (!m_sink) {
+        m_sink = std::make_unique<StreamFileSink>();
+    }
 
-    // Configure file buffer size for more frequent writes
-    m_outFile.rdbuf()->pubsetbuf(nullptr, 16 * 1024);  // 16KB buffer size
+    // Create buffer manager. Memory the transport needs (e.g. DMA mappings)
+    // wins; otherwise use what the sink can write without copying.
+    BufferAllocator allocator = m_transport->Allocator();
+    if (!allocator.allocate) {
+        allocator = m_sink->Allocator();
+    }
+    m_bufferManager = std::make_unique<BufferManager>(m_bufferSize, m_numBuffers, allocator);
 
     // Open output file
-    m_outFile.open("C:/Users/cmirand4/Documents/MATLAB/VI_Data/streamTest/counter2.bin",
-        std::ios::binary | std::ios::out);
-
-    if (!m_outFile.is_open()) {
-        std::cerr << "Failed to open output file" << std::endl;
+    if (!m_sink->Open(outputPath, totalBytes)) {
         return false;
     }
+    std::cout << "Disk writer: " << m_sink->Name() << std::endl;
 
+    m_writeLatency.Reset();
     return true;
 }
 
@@ -86,7 +122,9 @@ bool DataStreamer::StartStreaming() {
 
 void DataStreamer::StopStreaming() {
     m_running = false;
-    m_dataReady.notify_all();
+    if (m_bufferManager) {
+        m_bufferManager->WakeAll();
+    }
 
     if (m_readerThread && m_readerThread->joinable()) {
         m_readerThread->join();
@@ -95,123 +133,201 @@ void DataStreamer::StopStreaming() {
         m_writerThread->join();
     }
 
-    m_outFile.close();
+    if (m_sink && !m_sink->Close()) {
+        std::cerr << "Failed to finish output file" << std::endl;
+    }
+
+    // Both threads are gone, so it is safe to pull every buffer back
+    if (m_bufferManager) {
+        m_bufferManager->Reset();
+    }
+    m_writerQueue.Set(0);
 }
 
 void DataStreamer::UsbReaderThread() {
+#ifdef _WIN32
     SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
-
-    // Pre-allocate overlapped structures and start initial transfers
-    std::vector<OVERLAPPED> ovLapArray(NUM_BUFFERS);
-    std::vector<Buffer*> activeBuffers(NUM_BUFFERS, nullptr);
-    
-    // Initialize overlapped structures and start initial transfers
-    for (int i = 0; i < NUM_BUFFERS; i++) {
-        Buffer* buffer = m_bufferManager->GetEmptyBuffer();
-        if (!buffer) continue;
-
-        ZeroMemory(&ovLapArray[i], sizeof(OVERLAPPED));
-        ovLapArray[i].hEvent = CreateEventA(NULL, false, false, NULL);
-        if (!ovLapArray[i].hEvent) {
-            m_bufferManager->ReturnEmptyBuffer(buffer);
-            continue;
+#endif
+
+    // Buffer currently submitted on each transport slot
+    std::vector<Buffer*> activeBuffers(m_numBuffers, nullptr);
+
+    // The empty ring only has one producer (the writer), so buffers this thread
+    // fails to submit are parked here instead of being handed back.
+    std::vector<Buffer*> spareBuffers;
+    spareBuffers.reserve(m_numBuffers);
+    auto takeEmptyBuffer = [&]() -> Buffer* {
+        if (!spareBuffers.empty()) {
+            Buffer* buffer = spareBuffers.back();
+            spareBuffers.pop_back();
+            return buffer;
         }
-
-        if (!m_bulkEndpoint->BeginDataXfer(
-            buffer->data.get(),
-            static_cast<long>(buffer->size),
-            &ovLapArray[i]
-        )) {
-            CloseHandle(ovLapArray[i].hEvent);
-            m_bufferManager->ReturnEmptyBuffer(buffer);
-            continue;
+        return m_bufferManager->GetEmptyBuffer();
+    };
+
+    // Completions are taken in whatever order they land and the slot is
+    // re-armed at once; the reorder stage then hands buffers to the writer in
+    // submission order. Its window is twice the depth so a few aborted
+    // transfers behind one slow transfer do not stop submission.
+    std::vector<int> freeSlots;
+    freeSlots.reserve(m_numBuffers);
+    for (int i = m_numBuffers - 1; i >= 0; i--) {
+        freeSlots.push_back(i);
+    }
+    ReorderStage reorder(static_cast<size_t>(m_numBuffers) * 2);
+    uint64_t nextSequence = 0;
+    int inFlight = 0;
+    auto lastProgress = std::chrono::steady_clock::now();
+
+    auto submitTransfers = [&]() {
+        while (!freeSlots.empty() && reorder.HasRoom(nextSequence)) {
+            Buffer* buffer = takeEmptyBuffer();
+            if (!buffer) {
+                return;
+            }
+            const int slot = freeSlots.back();
+            if (!m_transport->Submit(slot, buffer->data.get(), buffer->size)) {
+                spareBuffers.push_back(buffer);
+                return;
+            }
+            freeSlots.pop_back();
+            buffer->sequence = nextSequence++;
+            activeBuffers[slot] = buffer;
+            ++inFlight;
         }
+        m_usbInFlight.Set(inFlight);
+    };
 
-        activeBuffers[i] = buffer;
-    }
+    // Start initial transfers
+    submitTransfers();
 
-    int currentBuffer = 0;
     while (m_running) {
-        if (!activeBuffers[currentBuffer]) {
-            currentBuffer = (currentBuffer + 1) % NUM_BUFFERS;
+        if (inFlight == 0) {
+            // Nothing queued: wait for the writer to hand a buffer back
+            Buffer* buffer = m_bufferManager->WaitForEmptyBuffer(WRITER_WAIT);
+            if (buffer) {
+                spareBuffers.push_back(buffer);
+            }
+            submitTransfers();
             continue;
         }
 
-        if (WaitForSingleObject(ovLapArray[currentBuffer].hEvent, USB_TIMEOUT) == WAIT_OBJECT_0) {
-            LONG transferred = static_cast<LONG>(activeBuffers[currentBuffer]->size);
-            if (GetOverlappedResult(m_bulkEndpoint->hDevice, &ovLapArray[currentBuffer], 
-                reinterpret_cast<PULONG>(&transferred), FALSE)) {
-                
-                activeBuffers[currentBuffer]->bytesUsed = static_cast<size_t>(transferred);
-                m_bufferManager->QueueFullBuffer(activeBuffers[currentBuffer]);
-                m_dataReady.notify_one();
-
-                // Start new transfer immediately
-                Buffer* newBuffer = m_bufferManager->GetEmptyBuffer();
-                if (newBuffer) {
-                    if (m_bulkEndpoint->BeginDataXfer(
-                        newBuffer->data.get(),
-                        static_cast<long>(newBuffer->size),
-                        &ovLapArray[currentBuffer]
-                    )) {
-                        activeBuffers[currentBuffer] = newBuffer;
-                    } else {
-                        m_bufferManager->ReturnEmptyBuffer(newBuffer);
-                        activeBuffers[currentBuffer] = nullptr;
-                    }
-                }
+        // While a slot sits idle, come back often enough to re-arm it as
+        // soon as the writer returns a buffer; otherwise park in the reap.
+        const bool slotsIdle = inFlight < m_numBuffers;
+        int slot = -1;
+        size_t transferred = 0;
+        TransferStatus status = m_transport->ReapAny(slotsIdle ? REARM_POLL : USB_TIMEOUT, slot, transferred);
+        if (status == TransferStatus::Timeout) {
+            const auto now = std::chrono::steady_clock::now();
+            if (now - lastProgress >= std::chrono::milliseconds(USB_TIMEOUT)) {
+                // Nothing at all finished: cancel every slot, they come back
+                // as Aborted on the next reaps and get re-armed from there
+                m_transport->Abort();
+                m_usbTimeouts.Add();
+                lastProgress = now;
+            }
+            submitTransfers();
+            continue;
+        }
+        if (slot < 0) {
+            continue;
+        }
+        lastProgress = std::chrono::steady_clock::now();
+
+        Buffer* buffer = activeBuffers[slot];
+        activeBuffers[slot] = nullptr;
+        freeSlots.push_back(slot);
+        --inFlight;
+        m_usbInFlight.Set(inFlight);
+
+        if (status == TransferStatus::Completed) {
+            buffer->bytesUsed = transferred;
+            reorder.Complete(buffer->sequence, buffer);
+            m_usbCompletions.Add();
+            m_usbBytes.Add(transferred);
+            if (transferred < buffer->size) {
+                m_usbShortTransfers.Add();
             }
         } else {
-            m_bulkEndpoint->Abort();
-            m_bufferManager->ReturnEmptyBuffer(activeBuffers[currentBuffer]);
-            activeBuffers[currentBuffer] = nullptr;
+            m_usbFailedTransfers.Add();
+            reorder.Complete(buffer->sequence, nullptr);
+            spareBuffers.push_back(buffer);
         }
 
-        currentBuffer = (currentBuffer + 1) % NUM_BUFFERS;
+        // Start new transfer immediately, then pass on whatever is now in order
+        submitTransfers();
+        reorder.Drain([&](Buffer* ready) {
+            m_writerQueue.Add(1);
+            m_bufferManager->QueueFullBuffer(ready);
+        });
     }
 
-    // Cleanup
-    for (int i = 0; i < NUM_BUFFERS; i++) {
-        if (ovLapArray[i].hEvent) {
-            CloseHandle(ovLapArray[i].hEvent);
-        }
-        if (activeBuffers[i]) {
-            m_bufferManager->ReturnEmptyBuffer(activeBuffers[i]);
-        }
-    }
+    // Cleanup. Buffers still held here are reclaimed by BufferManager::Reset()
+    // once the writer has stopped too.
+    m_transport->Abort();
+    m_usbInFlight.Set(0);
 }
 
 void DataStreamer::DiskWriterThread() {
-    const size_t FLUSH_THRESHOLD = 1024 * 1024;  // 1MB
-    size_t bytesWrittenSinceFlush = 0;
+    // Asynchronous sinks hand buffers back from inside Submit()/Reap(), still
+    // on this thread, so the empty ring keeps a single producer
+    const FileSink::ReleaseFn release = [this](Buffer* buffer) {
+        m_bufferManager->ReturnEmptyBuffer(buffer);
+    };
 
     while (m_running) {
-        Buffer* buffer = m_bufferManager->GetFullBuffer();
-        if (!buffer) {
-            continue;
+        if (!m_sink->Reap(false)) {
+            std::cerr << "Disk write failed, stopping capture" << std::endl;
+            m_running = false;
+            break;
         }
 
+        Buffer* buffer = nullptr;
+        if (m_sink->WritesInFlight() > 0) {
+            // The reader may be waiting on those buffers, so rather than
+            // sleeping on the full ring, wait for the disk when it is empty
+            buffer = m_bufferManager->GetFullBuffer();
+            if (!buffer) {
+                m_sink->Reap(true);
+                continue;
+            }
+        } else {
+            // Sleeps until the reader queues a buffer instead of spinning a core
+            buffer = m_bufferManager->WaitForFullBuffer(WRITER_WAIT);
+            if (!buffer) {
+                continue;
+            }
+        }
+        m_writerQueue.Add(-1);
+
         // Check if writing this buffer would exceed the target size
         size_t remainingBytes = m_targetBytes - m_totalBytesWritten;
         size_t bytesToWrite = std::min<size_t>(buffer->bytesUsed, remainingBytes);
 
         if (bytesToWrite > 0) {
-            m_outFile.write(reinterpret_cast<char*>(buffer->data.get()), bytesToWrite);
-            bytesWrittenSinceFlush += bytesToWrite;
-            m_totalBytesWritten += bytesToWrite;
-
-            if (bytesWrittenSinceFlush >= FLUSH_THRESHOLD) {
-                m_outFile.flush();
-                bytesWrittenSinceFlush = 0;
+            const auto writeStart = std::chrono::steady_clock::now();
+            const bool written = m_sink->Submit(buffer, bytesToWrite, release);
+            m_writeLatency.Record(std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - writeStart).count());
+            m_diskSubmitUs.RecordSince(writeStart);
+
+            if (!written) {
+                std::cerr << "Disk write failed, stopping capture" << std::endl;
+                m_running = false;
+                break;
             }
+            m_totalBytesWritten += bytesToWrite;
+            m_diskBytes.Add(bytesToWrite);
+        } else {
+            release(buffer);
         }
 
-        m_bufferManager->ReturnEmptyBuffer(buffer);
-
-        // Stop if we've reached the target size
+        // Stop if we've reached the target size. Writes still in flight
+        // finish in StopStreaming() when the sink is closed.
         if (m_totalBytesWritten >= m_targetBytes) {
             m_running = false;
             break;
         }
     }
-}
\ No newline at end of file
+}
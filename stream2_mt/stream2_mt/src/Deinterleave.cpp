@@ -0,0 +1,348 @@
+#include "../include/Deinterleave.h"
+#include "../include/CpuFeatures.h"
+
+#include <cstring>
+
+#ifdef CPU_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Swaps the bits selected by mask with the bits shift places above them
+inline uint64_t DeltaSwap(uint64_t x, uint64_t mask, int shift) {
+    const uint64_t t = ((x >> shift) ^ x) & mask;
+    return x ^ t ^ (t << shift);
+}
+
+// Reverses the nibble order inside each 32-bit half, so nibble j moves to
+// 7 - j and the earliest channel bit ends up in each byte's MSB
+inline uint64_t ReverseNibbles(uint64_t x) {
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((x & 0x0F0F0F0F0F0F0F0Full) << 4);
+    x = ((x >> 8) & 0x00FF00FF00FF00FFull) | ((x & 0x00FF00FF00FF00FFull) << 8);
+    return ((x >> 16) & 0x0000FFFF0000FFFFull) | ((x & 0x0000FFFF0000FFFFull) << 16);
+}
+
+// Two words at once: bit 4j + c of each half moves to bit 8c + j
+inline uint64_t TransposeWords(uint64_t x) {
+    x = ReverseNibbles(x);
+    x = DeltaSwap(x, 0x2222222222222222ull, 1);
+    x = DeltaSwap(x, 0x0A0A0A0A0A0A0A0Aull, 3);
+    x = DeltaSwap(x, 0x00CC00CC00CC00CCull, 6);
+    return DeltaSwap(x, 0x0000F0F00000F0F0ull, 12);
+}
+
+void DeinterleaveScalar(const uint32_t* words, size_t count, uint8_t* const channels[4]) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const uint64_t x = TransposeWords(static_cast<uint64_t>(words[i]) |
+                                          static_cast<uint64_t>(words[i + 1]) << 32);
+        for (int c = 0; c < 4; ++c) {
+            channels[c][i] = static_cast<uint8_t>(x >> (8 * c));
+            channels[c][i + 1] = static_cast<uint8_t>(x >> (32 + 8 * c));
+        }
+    }
+    if (i < count) {
+        const uint64_t x = TransposeWords(words[i]);
+        for (int c = 0; c < 4; ++c) {
+            channels[c][i] = static_cast<uint8_t>(x >> (8 * c));
+        }
+    }
+}
+
+void InterleaveScalar(const uint32_t* words, size_t count, uint8_t* pixels) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const uint64_t x = TransposeWords(static_cast<uint64_t>(words[i]) |
+                                          static_cast<uint64_t>(words[i + 1]) << 32);
+        std::memcpy(pixels + i * 4, &x, sizeof(x));
+    }
+    if (i < count) {
+        const uint32_t x = static_cast<uint32_t>(TransposeWords(words[i]));
+        std::memcpy(pixels + i * 4, &x, sizeof(x));
+    }
+}
+
+// Byte masks for a funnel shift by shift bits: the part of each byte that
+// comes from the same byte, and the part from the same channel's next byte
+inline uint64_t HighLaneMask(unsigned shift) {
+    return 0x0101010101010101ull * ((0xFFu << shift) & 0xFFu);
+}
+
+inline uint64_t LowLaneMask(unsigned shift) {
+    return 0x0101010101010101ull * ((1u << shift) - 1u);
+}
+
+void CutRowScalar(const uint8_t* src, unsigned shift, size_t bytes, uint8_t* row) {
+    const uint64_t high = HighLaneMask(shift);
+    const uint64_t low = LowLaneMask(shift);
+    size_t i = 0;
+    for (; i + 2 <= bytes; i += 2) {
+        uint64_t x, next;
+        std::memcpy(&x, src + i * 4, sizeof(x));
+        std::memcpy(&next, src + i * 4 + 4, sizeof(next));
+        x = ((x << shift) & high) | ((next >> (8 - shift)) & low);
+        std::memcpy(row + i * 4, &x, sizeof(x));
+    }
+    if (i < bytes) {
+        uint32_t x, next;
+        std::memcpy(&x, src + i * 4, sizeof(x));
+        std::memcpy(&next, src + i * 4 + 4, sizeof(next));
+        x = static_cast<uint32_t>(((x << shift) & high) | ((next >> (8 - shift)) & low));
+        std::memcpy(row + i * 4, &x, sizeof(x));
+    }
+}
+
+void PickScalar(const uint8_t* pixels, size_t count, int channel, uint8_t* out) {
+    const uint8_t* src = pixels + channel;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = src[i * 4];
+    }
+}
+
+#ifdef CPU_X86
+
+TARGET_BMI2 void DeinterleaveBmi2(const uint32_t* words, size_t count, uint8_t* const channels[4]) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        uint64_t x;
+        std::memcpy(&x, words + i, sizeof(x));
+        x = ReverseNibbles(x);
+        for (int c = 0; c < 4; ++c) {
+            // Bit c of every nibble: 8 bits per word, first word in the low byte
+            const uint16_t pair = static_cast<uint16_t>(_pext_u64(x, 0x1111111111111111ull << c));
+            std::memcpy(channels[c] + i, &pair, sizeof(pair));
+        }
+    }
+    if (i < count) {
+        uint8_t* const tail[4] = { channels[0] + i, channels[1] + i, channels[2] + i, channels[3] + i };
+        DeinterleaveScalar(words + i, count - i, tail);
+    }
+}
+
+TARGET_AVX2 inline __m256i DeltaSwap256(__m256i x, __m256i mask, int shift) {
+    const __m256i t = _mm256_and_si256(_mm256_xor_si256(_mm256_srli_epi32(x, shift), x), mask);
+    return _mm256_xor_si256(_mm256_xor_si256(x, t), _mm256_slli_epi32(t, shift));
+}
+
+// Eight words: each 32-bit lane becomes its word's four channel bytes,
+// channel c in byte c
+TARGET_AVX2 inline __m256i TransposeLanes(__m256i v) {
+    const __m256i byteSwap = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m256i lowNibbles = _mm256_set1_epi8(0x0F);
+
+    v = _mm256_shuffle_epi8(v, byteSwap);
+    v = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(v, 4), lowNibbles),
+                        _mm256_slli_epi32(_mm256_and_si256(v, lowNibbles), 4));
+    v = DeltaSwap256(v, _mm256_set1_epi32(0x22222222), 1);
+    v = DeltaSwap256(v, _mm256_set1_epi32(0x0A0A0A0A), 3);
+    v = DeltaSwap256(v, _mm256_set1_epi32(0x00CC00CC), 6);
+    return DeltaSwap256(v, _mm256_set1_epi32(0x0000F0F0), 12);
+}
+
+// Then the bytes are regrouped so 64-bit element c holds channel c of all eight
+TARGET_AVX2 inline __m256i TransposeBlock(__m256i v) {
+    const __m256i byChannel = _mm256_setr_epi8(
+        0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+        0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+
+    v = _mm256_shuffle_epi8(TransposeLanes(v), byChannel);
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+TARGET_AVX2 void DeinterleaveAvx2(const uint32_t* words, size_t count, uint8_t* const channels[4]) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i a = TransposeBlock(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i)));
+        const __m256i b = TransposeBlock(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i + 8)));
+
+        // [a.c0 b.c0 | a.c2 b.c2] and [a.c1 b.c1 | a.c3 b.c3]
+        const __m256i even = _mm256_unpacklo_epi64(a, b);
+        const __m256i odd = _mm256_unpackhi_epi64(a, b);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(channels[0] + i), _mm256_castsi256_si128(even));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(channels[1] + i), _mm256_castsi256_si128(odd));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(channels[2] + i), _mm256_extracti128_si256(even, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(channels[3] + i), _mm256_extracti128_si256(odd, 1));
+    }
+    if (i < count) {
+        uint8_t* const tail[4] = { channels[0] + i, channels[1] + i, channels[2] + i, channels[3] + i };
+        DeinterleaveScalar(words + i, count - i, tail);
+    }
+}
+
+TARGET_AVX2 void InterleaveAvx2(const uint32_t* words, size_t count, uint8_t* pixels) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = TransposeLanes(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i * 4), v);
+    }
+    if (i < count) {
+        InterleaveScalar(words + i, count - i, pixels + i * 4);
+    }
+}
+
+TARGET_AVX2 void CutRowAvx2(const uint8_t* src, unsigned shift, size_t bytes, uint8_t* row) {
+    const __m128i left = _mm_cvtsi32_si128(static_cast<int>(shift));
+    const __m128i right = _mm_cvtsi32_si128(static_cast<int>(8 - shift));
+    const __m256i high = _mm256_set1_epi64x(static_cast<long long>(HighLaneMask(shift)));
+    const __m256i low = _mm256_set1_epi64x(static_cast<long long>(LowLaneMask(shift)));
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+        const __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4 + 4));
+        const __m256i v = _mm256_or_si256(_mm256_and_si256(_mm256_sll_epi64(x, left), high),
+                                          _mm256_and_si256(_mm256_srl_epi64(next, right), low));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + i * 4), v);
+    }
+    if (i < bytes) {
+        CutRowScalar(src + i * 4, shift, bytes - i, row + i * 4);
+    }
+}
+
+TARGET_AVX2 void PickAvx2(const uint8_t* pixels, size_t count, int channel, uint8_t* out) {
+    // Byte channel of each word to the front of its half, then both halves together
+    const __m256i pick = _mm256_add_epi8(
+        _mm256_setr_epi8(0, 4, 8, 12, 0, 4, 8, 12, 0, 4, 8, 12, 0, 4, 8, 12,
+                         0, 4, 8, 12, 0, 4, 8, 12, 0, 4, 8, 12, 0, 4, 8, 12),
+        _mm256_set1_epi8(static_cast<char>(channel)));
+    const __m256i halves = _mm256_setr_epi32(0, 4, 0, 4, 0, 4, 0, 4);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i * 4));
+        v = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, pick), halves);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(v));
+    }
+    if (i < count) {
+        PickScalar(pixels + i * 4, count - i, channel, out + i);
+    }
+}
+
+#endif // CPU_X86
+
+using KernelFn = void (*)(const uint32_t*, size_t, uint8_t* const[4]);
+
+KernelFn KernelFor(DeinterleaveKernel kernel) {
+    switch (kernel) {
+    case DeinterleaveKernel::Scalar:
+        return DeinterleaveScalar;
+#ifdef CPU_X86
+    case DeinterleaveKernel::Bmi2:
+        return CpuHasBmi2() ? DeinterleaveBmi2 : nullptr;
+    case DeinterleaveKernel::Avx2:
+        return CpuHasAvx2() ? DeinterleaveAvx2 : nullptr;
+#else
+    default:
+        return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+using InterleaveFn = void (*)(const uint32_t*, size_t, uint8_t*);
+
+InterleaveFn InterleaveFor(DeinterleaveKernel kernel) {
+    switch (kernel) {
+    case DeinterleaveKernel::Scalar:
+        return InterleaveScalar;
+#ifdef CPU_X86
+    case DeinterleaveKernel::Avx2:
+        return CpuHasAvx2() ? InterleaveAvx2 : nullptr;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+} // namespace
+
+DeinterleaveKernel BestDeinterleaveKernel() {
+    // PEXT is microcoded on AMD before Zen 3, so AVX2 goes first
+    static const DeinterleaveKernel best = []() {
+        if (KernelFor(DeinterleaveKernel::Avx2)) {
+            return DeinterleaveKernel::Avx2;
+        }
+        if (KernelFor(DeinterleaveKernel::Bmi2)) {
+            return DeinterleaveKernel::Bmi2;
+        }
+        return DeinterleaveKernel::Scalar;
+    }();
+    return best;
+}
+
+bool DeinterleaveKernelSupported(DeinterleaveKernel kernel) {
+    return KernelFor(kernel) != nullptr;
+}
+
+const char* DeinterleaveKernelName(DeinterleaveKernel kernel) {
+    switch (kernel) {
+    case DeinterleaveKernel::Scalar: return "scalar";
+    case DeinterleaveKernel::Bmi2: return "bmi2";
+    case DeinterleaveKernel::Avx2: return "avx2";
+    }
+    return "unknown";
+}
+
+void DeinterleaveChannels(const uint32_t* words, size_t count, uint8_t* const channels[4]) {
+    static const KernelFn best = KernelFor(BestDeinterleaveKernel());
+    best(words, count, channels);
+}
+
+bool DeinterleaveChannelsWith(DeinterleaveKernel kernel, const uint32_t* words, size_t count,
+                              uint8_t* const channels[4]) {
+    const KernelFn fn = KernelFor(kernel);
+    if (!fn) {
+        return false;
+    }
+    fn(words, count, channels);
+    return true;
+}
+
+void InterleaveChannels(const uint32_t* words, size_t count, uint8_t* pixels) {
+    static const InterleaveFn best = []() {
+        const InterleaveFn avx2 = InterleaveFor(DeinterleaveKernel::Avx2);
+        return avx2 ? avx2 : InterleaveScalar;
+    }();
+    best(words, count, pixels);
+}
+
+bool InterleaveChannelsWith(DeinterleaveKernel kernel, const uint32_t* words, size_t count, uint8_t* pixels) {
+    const InterleaveFn fn = InterleaveFor(kernel);
+    if (!fn) {
+        return false;
+    }
+    fn(words, count, pixels);
+    return true;
+}
+
+void CutRow(const uint8_t* pixels, size_t payloadBit, size_t bytes, uint8_t* row) {
+    if (bytes == 0) {
+        return;
+    }
+    const uint8_t* src = pixels + payloadBit / 8 * 4;
+    const unsigned shift = static_cast<unsigned>(payloadBit % 8);
+    if (shift == 0) {
+        std::memcpy(row, src, bytes * 4);
+        return;
+    }
+#ifdef CPU_X86
+    static const bool avx2 = CpuHasAvx2();
+    if (avx2) {
+        CutRowAvx2(src, shift, bytes, row);
+        return;
+    }
+#endif
+    CutRowScalar(src, shift, bytes, row);
+}
+
+void PickChannel(const uint8_t* pixels, size_t count, int channel, uint8_t* out) {
+#ifdef CPU_X86
+    static const bool avx2 = CpuHasAvx2();
+    if (avx2) {
+        PickAvx2(pixels, count, channel, out);
+        return;
+    }
+#endif
+    PickScalar(pixels, count, channel, out);
+}
@@ -0,0 +1,301 @@
+#include "../include/DirectFileSink.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+bool IsAligned(const void* pointer) {
+    return (reinterpret_cast<uintptr_t>(pointer) & (DirectFileSink::ALIGNMENT - 1)) == 0;
+}
+
+size_t RoundUp(size_t bytes) {
+    return (bytes + DirectFileSink::ALIGNMENT - 1) & ~(DirectFileSink::ALIGNMENT - 1);
+}
+
+} // namespace
+
+DirectFileSink::DirectFileSink()
+#ifdef _WIN32
+    : m_file(INVALID_HANDLE_VALUE)
+#else
+    : m_fd(-1)
+#endif
+    , m_bounce(nullptr)
+    , m_pending(0)
+    , m_bytesWritten(0)
+{
+}
+
+DirectFileSink::~DirectFileSink() {
+    Close();
+}
+
+bool DirectFileSink::Write(const unsigned char* data, size_t length) {
+    if (!IsOpen()) {
+        return false;
+    }
+    m_bytesWritten += length;
+
+    // Fast path: whole blocks straight out of an aligned ring buffer
+    if (m_pending == 0 && IsAligned(data)) {
+        const size_t blocks = length & ~(ALIGNMENT - 1);
+        if (blocks > 0 && !WriteBlocks(data, blocks)) {
+            return false;
+        }
+        data += blocks;
+        length -= blocks;
+    }
+
+    // Whatever is left is either misaligned in memory or belongs after a
+    // partial block, so it has to be copied into place
+    while (length > 0) {
+        const size_t chunk = std::min<size_t>(length, BOUNCE_SIZE - m_pending);
+        std::memcpy(m_bounce + m_pending, data, chunk);
+        m_pending += chunk;
+        data += chunk;
+        length -= chunk;
+
+        if (m_pending == BOUNCE_SIZE) {
+            if (!WriteBlocks(m_bounce, BOUNCE_SIZE)) {
+                return false;
+            }
+            m_pending = 0;
+        }
+    }
+
+    return true;
+}
+
+bool DirectFileSink::Close() {
+    if (!IsOpen()) {
+        return true;
+    }
+
+    // Tail: pad the last partial block out to a full one, then cut the file
+    // back to the bytes that were actually captured
+    bool ok = true;
+    if (m_pending > 0) {
+        const size_t padded = RoundUp(m_pending);
+        std::memset(m_bounce + m_pending, 0, padded - m_pending);
+        ok = WriteBlocks(m_bounce, padded);
+        m_pending = 0;
+    }
+    if (!Truncate(m_bytesWritten)) {
+        ok = false;
+    }
+
+    CloseFile();
+    FreeAligned(m_bounce, BOUNCE_SIZE);
+    m_bounce = nullptr;
+    return ok;
+}
+
+BufferAllocator DirectFileSink::Allocator() {
+    BufferAllocator allocator;
+    allocator.allocate = &DirectFileSink::AllocateAligned;
+    allocator.release = &DirectFileSink::FreeAligned;
+    return allocator;
+}
+
+#ifdef _WIN32
+
+bool DirectFileSink::Open(const std::string& path, size_t expectedBytes) {
+    if (IsOpen()) {
+        return false;
+    }
+
+    m_file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                         FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open output file (error " << GetLastError() << ")" << std::endl;
+        return false;
+    }
+
+    m_bounce = AllocateAligned(BOUNCE_SIZE);
+    if (!m_bounce) {
+        std::cerr << "Failed to allocate bounce buffer" << std::endl;
+        CloseFile();
+        return false;
+    }
+    m_pending = 0;
+    m_bytesWritten = 0;
+
+    Preallocate(expectedBytes);
+    return true;
+}
+
+bool DirectFileSink::IsOpen() const {
+    return m_file != INVALID_HANDLE_VALUE;
+}
+
+bool DirectFileSink::WriteBlocks(const unsigned char* data, size_t length) {
+    while (length > 0) {
+        // WriteFile takes a DWORD; stay block-aligned when splitting
+        const DWORD chunk = static_cast<DWORD>(std::min<size_t>(length, 0x40000000));
+        DWORD written = 0;
+        if (!WriteFile(m_file, data, chunk, &written, NULL) || written == 0) {
+            std::cerr << "Disk write failed (error " << GetLastError() << ")" << std::endl;
+            return false;
+        }
+        data += written;
+        length -= written;
+    }
+    return true;
+}
+
+void DirectFileSink::Preallocate(size_t bytes) {
+    if (bytes == 0) {
+        return;
+    }
+
+    // Reserves clusters without moving end-of-file, so nothing is zero-filled
+    FILE_ALLOCATION_INFO info;
+    info.AllocationSize.QuadPart = static_cast<LONGLONG>(RoundUp(bytes));
+    if (!SetFileInformationByHandle(m_file, FileAllocationInfo, &info, sizeof(info))) {
+        std::cerr << "Preallocation failed (error " << GetLastError() << "), continuing" << std::endl;
+    }
+}
+
+bool DirectFileSink::Truncate(uint64_t size) {
+    // Setting end-of-file has no alignment requirement, even unbuffered
+    LARGE_INTEGER position;
+    position.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(m_file, position, NULL, FILE_BEGIN) || !SetEndOfFile(m_file)) {
+        std::cerr << "Failed to set final file size (error " << GetLastError() << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void DirectFileSink::CloseFile() {
+    if (m_file != INVALID_HANDLE_VALUE) {
+        ::CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+}
+
+unsigned char* DirectFileSink::AllocateAligned(size_t size) {
+    // VirtualAlloc memory is always page-aligned
+    return static_cast<unsigned char*>(VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+}
+
+void DirectFileSink::FreeAligned(unsigned char* memory, size_t size) {
+    (void)size;
+    if (memory) {
+        VirtualFree(memory, 0, MEM_RELEASE);
+    }
+}
+
+#else
+
+bool DirectFileSink::Open(const std::string& path, size_t expectedBytes) {
+    if (IsOpen()) {
+        return false;
+    }
+
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+    m_fd = open(path.c_str(), flags | O_DIRECT, 0644);
+    if (m_fd < 0 && errno == EINVAL) {
+        // e.g. tmpfs: still correct, just goes through the page cache
+        std::cerr << "O_DIRECT not supported for " << path << ", writing buffered" << std::endl;
+        m_fd = open(path.c_str(), flags, 0644);
+    }
+#else
+    m_fd = open(path.c_str(), flags, 0644);
+#ifdef F_NOCACHE
+    if (m_fd >= 0) {
+        fcntl(m_fd, F_NOCACHE, 1);
+    }
+#endif
+#endif
+    if (m_fd < 0) {
+        std::cerr << "Failed to open output file: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    m_bounce = AllocateAligned(BOUNCE_SIZE);
+    if (!m_bounce) {
+        std::cerr << "Failed to allocate bounce buffer" << std::endl;
+        CloseFile();
+        return false;
+    }
+    m_pending = 0;
+    m_bytesWritten = 0;
+
+    Preallocate(expectedBytes);
+    return true;
+}
+
+bool DirectFileSink::IsOpen() const {
+    return m_fd >= 0;
+}
+
+bool DirectFileSink::WriteBlocks(const unsigned char* data, size_t length) {
+    while (length > 0) {
+        const ssize_t written = write(m_fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Disk write failed: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+void DirectFileSink::Preallocate(size_t bytes) {
+#ifdef __linux__
+    // KEEP_SIZE reserves the extents without moving end-of-file; Close()
+    // trims whatever the capture did not use
+    if (bytes > 0 && fallocate(m_fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(RoundUp(bytes))) != 0) {
+        std::cerr << "Preallocation failed: " << std::strerror(errno) << ", continuing" << std::endl;
+    }
+#else
+    (void)bytes;
+#endif
+}
+
+bool DirectFileSink::Truncate(uint64_t size) {
+    if (ftruncate(m_fd, static_cast<off_t>(size)) != 0) {
+        std::cerr << "Failed to set final file size: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void DirectFileSink::CloseFile() {
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+unsigned char* DirectFileSink::AllocateAligned(size_t size) {
+    void* memory = nullptr;
+    if (posix_memalign(&memory, ALIGNMENT, RoundUp(size)) != 0) {
+        return nullptr;
+    }
+    return static_cast<unsigned char*>(memory);
+}
+
+void DirectFileSink::FreeAligned(unsigned char* memory, size_t size) {
+    (void)size;
+    std::free(memory);
+}
+
+#endif
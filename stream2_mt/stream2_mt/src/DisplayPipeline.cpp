@@ -0,0 +1,149 @@
+#include "../include/DisplayPipeline.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+uint32_t Rgb(double r, double g, double b) {
+    const auto channel = [](double v) {
+        return static_cast<uint32_t>(std::lround(std::min<double>(std::max<double>(v, 0.0), 1.0) * 255.0));
+    };
+    return (channel(r) << 16) | (channel(g) << 8) | channel(b);
+}
+
+} // namespace
+
+bool operator==(const DisplaySettings& a, const DisplaySettings& b) {
+    return a.level == b.level && a.window == b.window && a.gamma == b.gamma
+        && a.equalize == b.equalize && a.palette == b.palette;
+}
+
+bool operator!=(const DisplaySettings& a, const DisplaySettings& b) {
+    return !(a == b);
+}
+
+DisplayPipeline::DisplayPipeline(const ClaheConfig& clahe)
+    : m_clahe(clahe)
+    , m_width(0)
+    , m_height(0)
+    , m_frameNumber(0)
+    , m_toneLut()
+    , m_palette()
+    , m_tonedValid(false)
+    , m_equalizedValid(false)
+{
+    BuildToneLut();
+    BuildPalette();
+}
+
+void DisplayPipeline::SetFrame(const uint8_t* pixels, int width, int height, int frameNumber) {
+    m_width = std::max<int>(width, 0);
+    m_height = std::max<int>(height, 0);
+    m_frameNumber = frameNumber;
+    m_raw.resize(static_cast<size_t>(m_width) * m_height);
+    if (!m_raw.empty()) {
+        std::memcpy(m_raw.data(), pixels, m_raw.size());
+    }
+    m_tonedValid = false;
+    m_equalizedValid = false;
+}
+
+void DisplayPipeline::SetSettings(const DisplaySettings& settings) {
+    const DisplaySettings previous = m_settings;
+    m_settings = settings;
+    m_settings.window = std::max<int>(m_settings.window, 1);
+    if (!(m_settings.gamma > 0.0)) {
+        m_settings.gamma = 1.0;
+    }
+
+    // Turning equalization on or off changes no stage's output, only which
+    // one is shown
+    if (m_settings.level != previous.level || m_settings.window != previous.window || m_settings.gamma != previous.gamma) {
+        BuildToneLut();
+        m_tonedValid = false;
+        m_equalizedValid = false;
+    }
+    if (m_settings.palette != previous.palette) {
+        BuildPalette();
+    }
+}
+
+void DisplayPipeline::Render(ViewerTexture& texture) {
+    // Stage 1: window/level and gamma, skipped when they change nothing
+    const bool identity = ToneIsIdentity();
+    if (!identity && !m_tonedValid) {
+        m_toned.resize(m_raw.size());
+        const uint8_t* lut = m_toneLut.data();
+        for (size_t i = 0; i < m_raw.size(); ++i) {
+            m_toned[i] = lut[m_raw[i]];
+        }
+        m_tonedValid = true;
+        ++m_counts.tone;
+    }
+    const std::vector<uint8_t>& toned = identity ? m_raw : m_toned;
+
+    // Stage 2: equalization, kept while it is off in case it comes back on
+    if (m_settings.equalize && !m_equalizedValid) {
+        m_equalized = toned;
+        m_clahe.Apply(m_equalized.data(), m_width, m_height);
+        m_equalizedValid = true;
+        ++m_counts.equalize;
+    }
+    const std::vector<uint8_t>& shown = m_settings.equalize ? m_equalized : toned;
+
+    // Stage 3: the palette goes along for the surface to draw with
+    texture.width = m_width;
+    texture.height = m_height;
+    texture.frameNumber = m_frameNumber;
+    texture.pixels.resize(shown.size());
+    if (!shown.empty()) {
+        std::memcpy(texture.pixels.data(), shown.data(), shown.size());
+    }
+    texture.palette = m_palette;
+}
+
+bool DisplayPipeline::ToneIsIdentity() const {
+    for (int i = 0; i < 256; ++i) {
+        if (m_toneLut[i] != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DisplayPipeline::BuildToneLut() {
+    // The window spans level - window / 2 .. that + window - 1, so the
+    // defaults map every value to itself
+    const double low = m_settings.level - m_settings.window / 2;
+    const double span = std::max<int>(m_settings.window - 1, 1);
+    const double exponent = 1.0 / m_settings.gamma;
+    for (int i = 0; i < 256; ++i) {
+        double x = std::min<double>(std::max<double>((i - low) / span, 0.0), 1.0);
+        if (exponent != 1.0) {
+            x = std::pow(x, exponent);
+        }
+        m_toneLut[i] = static_cast<uint8_t>(std::lround(x * 255.0));
+    }
+}
+
+void DisplayPipeline::BuildPalette() {
+    for (int i = 0; i < 256; ++i) {
+        const double x = i / 255.0;
+        switch (m_settings.palette) {
+        case DisplayPalette::Hot:
+            // Black through red and yellow to white
+            m_palette[i] = Rgb(3.0 * x, 3.0 * x - 1.0, 3.0 * x - 2.0);
+            break;
+        case DisplayPalette::Rainbow:
+            // Blue through cyan, green and yellow to red
+            m_palette[i] = Rgb(1.5 - std::fabs(4.0 * x - 3.0), 1.5 - std::fabs(4.0 * x - 2.0), 1.5 - std::fabs(4.0 * x - 1.0));
+            break;
+        default:
+            m_palette[i] = Rgb(x, x, x);
+            break;
+        }
+    }
+    ++m_counts.palette;
+}
@@ -0,0 +1,176 @@
+#include "../include/FileReplayTransport.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+FileReplayTransport::FileReplayTransport(const std::string& path, const ReplayConfig& config)
+    : m_path(path)
+    , m_config(config)
+    , m_offset(0)
+{
+}
+
+FileReplayTransport::~FileReplayTransport() {
+    Close();
+}
+
+bool FileReplayTransport::Open() {
+    if (m_capture.IsOpen()) {
+        return true;
+    }
+    if (!m_capture.Open(m_path)) {
+        return false;
+    }
+
+    // Looping must not break the 32-bit word stream, so a trailing partial
+    // word is only ever played once at the very end.
+    if (m_config.loop && m_capture.Size() < 4) {
+        std::cerr << "Capture too small to loop: " << m_path << std::endl;
+        m_capture.Close();
+        return false;
+    }
+
+    m_offset = 0;
+    m_nextCompletion = std::chrono::steady_clock::time_point();
+    std::cout << "Replaying " << m_path << " (" << m_capture.Size() << " bytes)" << std::endl;
+    return true;
+}
+
+void FileReplayTransport::Close() {
+    Abort();
+    m_slots.clear();
+    m_capture.Close();
+}
+
+bool FileReplayTransport::Configure(int numSlots, size_t transferSize) {
+    (void)transferSize;  // Any length can be submitted
+    if (!m_capture.IsOpen() || numSlots <= 0 || !m_queue.empty()) {
+        return false;
+    }
+
+    m_slots.assign(static_cast<size_t>(numSlots), Slot());
+    return true;
+}
+
+bool FileReplayTransport::Submit(int slot, unsigned char* data, size_t length) {
+    if (slot < 0 || slot >= static_cast<int>(m_slots.size()) || !data || length == 0) {
+        return false;
+    }
+
+    Slot& s = m_slots[static_cast<size_t>(slot)];
+    if (s.state != SlotState::Idle) {
+        return false;
+    }
+
+    s.state = SlotState::Queued;
+    s.data = data;
+    s.length = length;
+    s.transferred = 0;
+    m_queue.push_back(slot);
+    return true;
+}
+
+TransferStatus FileReplayTransport::Reap(int slot, uint32_t timeoutMs, size_t& bytesTransferred) {
+    (void)timeoutMs;  // Pacing never holds a transfer longer than its own wire time
+    bytesTransferred = 0;
+    if (slot < 0 || slot >= static_cast<int>(m_slots.size())) {
+        return TransferStatus::Failed;
+    }
+
+    Slot& s = m_slots[static_cast<size_t>(slot)];
+    if (s.state == SlotState::Idle) {
+        return TransferStatus::Failed;
+    }
+
+    // Like the device, complete transfers strictly in the order they were queued
+    while (s.state == SlotState::Queued) {
+        Slot& next = m_slots[static_cast<size_t>(m_queue.front())];
+        m_queue.pop_front();
+        Complete(next);
+    }
+
+    s.state = SlotState::Idle;
+    bytesTransferred = s.transferred;
+    return s.status;
+}
+
+TransferStatus FileReplayTransport::ReapAny(uint32_t timeoutMs, int& slot, size_t& bytesTransferred) {
+    (void)timeoutMs;
+    slot = -1;
+    bytesTransferred = 0;
+
+    // Aborted transfers are already finished; otherwise the oldest one is next
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        if (m_slots[i].state == SlotState::Done) {
+            slot = static_cast<int>(i);
+            break;
+        }
+    }
+    if (slot < 0) {
+        if (m_queue.empty()) {
+            return TransferStatus::Failed;
+        }
+        slot = m_queue.front();
+        m_queue.pop_front();
+        Complete(m_slots[static_cast<size_t>(slot)]);
+    }
+
+    Slot& s = m_slots[static_cast<size_t>(slot)];
+    s.state = SlotState::Idle;
+    bytesTransferred = s.transferred;
+    return s.status;
+}
+
+void FileReplayTransport::Abort() {
+    for (int slot : m_queue) {
+        Slot& s = m_slots[static_cast<size_t>(slot)];
+        s.state = SlotState::Done;
+        s.status = TransferStatus::Aborted;
+        s.transferred = 0;
+    }
+    m_queue.clear();
+}
+
+void FileReplayTransport::Complete(Slot& slot) {
+    slot.state = SlotState::Done;
+
+    size_t copied = 0;
+    if (m_config.loop) {
+        const size_t period = m_capture.Size() & ~size_t(3);
+        while (copied < slot.length) {
+            if (m_offset >= period) {
+                m_offset = 0;
+            }
+            const size_t chunk = std::min<size_t>(slot.length - copied, period - m_offset);
+            std::memcpy(slot.data + copied, m_capture.Data() + m_offset, chunk);
+            copied += chunk;
+            m_offset += chunk;
+        }
+    } else {
+        copied = std::min<size_t>(slot.length, m_capture.Size() - m_offset);
+        std::memcpy(slot.data, m_capture.Data() + m_offset, copied);
+        m_offset += copied;
+    }
+
+    if (copied == 0) {
+        slot.status = TransferStatus::Failed;  // End of capture
+        slot.transferred = 0;
+        return;
+    }
+
+    if (m_config.bytesPerSecond > 0.0) {
+        using Clock = std::chrono::steady_clock;
+        const auto now = Clock::now();
+        if (m_nextCompletion < now) {
+            // Host was slower than the wire rate; a file cannot overrun
+            m_nextCompletion = now;
+        }
+        m_nextCompletion += std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(copied / m_config.bytesPerSecond));
+        std::this_thread::sleep_until(m_nextCompletion);
+    }
+
+    slot.status = TransferStatus::Completed;
+    slot.transferred = copied;
+}
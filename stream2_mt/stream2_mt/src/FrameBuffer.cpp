@@ -0,0 +1,50 @@
+#include "../include/FrameBuffer.h"
+#include "../include/Deinterleave.h"
+
+#include <cstring>
+
+FrameBuffer::FrameBuffer(int maxLines, int width)
+    : m_width(width > 0 ? width : ROW_PIXELS)
+    , m_maxLines(0)
+    , m_height(0)
+    , m_frameNumber(0)
+{
+    Reset(maxLines);
+}
+
+void FrameBuffer::Reset(int maxLines) {
+    m_maxLines = maxLines > 0 ? maxLines : 0;
+    const size_t pixels = static_cast<size_t>(m_maxLines) * m_width;
+    if (m_pixels.size() < pixels) {
+        m_pixels.resize(pixels);
+    }
+    m_startBits.reserve(static_cast<size_t>(m_maxLines));
+    m_endBits.reserve(static_cast<size_t>(m_maxLines));
+    m_valid.reserve(static_cast<size_t>(m_maxLines));
+    Clear();
+}
+
+void FrameBuffer::Clear() {
+    m_height = 0;
+    m_startBits.clear();
+    m_endBits.clear();
+    m_valid.clear();
+}
+
+bool FrameBuffer::AppendLine(const LineView& line) {
+    if (Full()) {
+        return false;
+    }
+
+    uint8_t* row = m_pixels.data() + static_cast<size_t>(m_height) * m_width;
+    const size_t perChannel = static_cast<size_t>(m_width) / 4;
+    const size_t bytes = line.bytes < perChannel ? line.bytes : perChannel;
+    CutRow(line.pixels, line.payloadBit, bytes, row);
+    std::memset(row + bytes * 4, 0, static_cast<size_t>(m_width) - bytes * 4);
+
+    m_startBits.push_back(line.startBit);
+    m_endBits.push_back(line.endBit);
+    m_valid.push_back(bytes > 0 ? 1 : 0);
+    ++m_height;
+    return true;
+}
@@ -0,0 +1,220 @@
+#include "../include/FramePool.h"
+
+#include <stdexcept>
+
+FramePool::FramePool(int numFrames, int maxLines, int width)
+    : m_published(0)
+    , m_starved(0)
+    , m_wakeGeneration(0)
+    , m_publishedMetric(MetricsRegistry::Global().Counter("frames_published_total", "Frames published to consumers"))
+    , m_droppedMetric(MetricsRegistry::Global().Counter("frames_dropped_total", "Frames a consumer lost to newer ones"))
+    , m_starvedMetric(MetricsRegistry::Global().Counter("frames_starved_total", "Acquires that found every frame held"))
+{
+    if (numFrames <= 0) {
+        throw std::invalid_argument("FramePool needs at least one frame");
+    }
+
+    m_slots.resize(static_cast<size_t>(numFrames));
+    m_free.reserve(m_slots.size());
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        m_slots[i].frame = std::make_unique<FrameBuffer>(maxLines, width);
+        m_free.push_back(m_slots.size() - 1 - i);  // Slot 0 is handed out first
+    }
+}
+
+int FramePool::AddConsumer(const std::string& name, size_t queueDepth) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Consumer consumer;
+    consumer.stats.name = name;
+    consumer.queueDepth = queueDepth > 0 ? queueDepth : 1;
+    consumer.queue.reserve(consumer.queueDepth);
+    m_consumers.push_back(std::move(consumer));
+    return static_cast<int>(m_consumers.size() - 1);
+}
+
+FrameBuffer* FramePool::Acquire() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while (m_free.empty()) {
+        if (!DropOldestWaiting()) {
+            ++m_starved;
+            m_starvedMetric.Add();
+            return nullptr;
+        }
+    }
+
+    const size_t slot = m_free.back();
+    m_free.pop_back();
+    m_slots[slot].acquired = true;
+    m_slots[slot].frame->Clear();
+    return m_slots[slot].frame.get();
+}
+
+void FramePool::Publish(FrameBuffer* frame) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const size_t slot = SlotOf(frame);
+        Slot& s = m_slots[slot];
+        s.acquired = false;
+        s.sequence = ++m_published;
+        m_publishedMetric.Add();
+
+        for (Consumer& consumer : m_consumers) {
+            if (consumer.queue.size() >= consumer.queueDepth) {
+                const size_t oldest = consumer.queue.front();
+                consumer.queue.erase(consumer.queue.begin());
+                ++consumer.stats.dropped;
+                m_droppedMetric.Add();
+                Unref(oldest);
+            }
+            consumer.queue.push_back(slot);
+            ++s.refs;
+        }
+        if (s.refs == 0) {
+            m_free.push_back(slot);  // Nobody is listening
+        }
+    }
+    m_frameReady.notify_all();
+}
+
+void FramePool::Discard(FrameBuffer* frame) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const size_t slot = SlotOf(frame);
+    m_slots[slot].acquired = false;
+    m_free.push_back(slot);
+}
+
+FrameBuffer* FramePool::Take(int consumer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return PopWaiting(m_consumers[static_cast<size_t>(consumer)]);
+}
+
+FrameBuffer* FramePool::WaitForFrame(int consumer, std::chrono::microseconds timeout) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Consumer& c = m_consumers[static_cast<size_t>(consumer)];
+    const uint64_t generation = m_wakeGeneration;
+    m_frameReady.wait_for(lock, timeout, [&]() { return !c.queue.empty() || m_wakeGeneration != generation; });
+    return PopWaiting(c);
+}
+
+void FramePool::Release(FrameBuffer* frame) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Unref(SlotOf(frame));
+}
+
+void FramePool::WakeAll() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_wakeGeneration;
+    }
+    m_frameReady.notify_all();
+}
+
+size_t FramePool::FreeFrames() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_free.size();
+}
+
+FramePoolStats FramePool::Stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FramePoolStats stats;
+    stats.published = m_published;
+    stats.starved = m_starved;
+    for (const Consumer& consumer : m_consumers) {
+        stats.consumers.push_back(consumer.stats);
+    }
+    return stats;
+}
+
+size_t FramePool::SlotOf(const FrameBuffer* frame) const {
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        if (m_slots[i].frame.get() == frame) {
+            return i;
+        }
+    }
+    throw std::invalid_argument("Frame does not belong to this pool");
+}
+
+FrameBuffer* FramePool::PopWaiting(Consumer& consumer) {
+    if (consumer.queue.empty()) {
+        return nullptr;
+    }
+    const size_t slot = consumer.queue.front();
+    consumer.queue.erase(consumer.queue.begin());
+    ++consumer.stats.delivered;
+    return m_slots[slot].frame.get();  // The queue's reference passes to the caller
+}
+
+void FramePool::Unref(size_t slot) {
+    if (--m_slots[slot].refs == 0 && !m_slots[slot].acquired) {
+        m_free.push_back(slot);
+    }
+}
+
+// Takes the oldest frame still waiting in any consumer's queue away from
+// that consumer. Returns false if no queue holds anything.
+bool FramePool::DropOldestWaiting() {
+    Consumer* victim = nullptr;
+    for (Consumer& consumer : m_consumers) {
+        if (!consumer.queue.empty() &&
+            (!victim || m_slots[consumer.queue.front()].sequence < m_slots[victim->queue.front()].sequence)) {
+            victim = &consumer;
+        }
+    }
+    if (!victim) {
+        return false;
+    }
+    const size_t slot = victim->queue.front();
+    victim->queue.erase(victim->queue.begin());
+    ++victim->stats.dropped;
+    m_droppedMetric.Add();
+    Unref(slot);
+    return true;
+}
+
+FramePublisher::FramePublisher(FramePool& pool)
+    : m_pool(pool)
+    , m_frame(nullptr)
+    , m_published(0)
+    , m_lostLines(0)
+{
+}
+
+FramePublisher::~FramePublisher() {
+    if (m_frame) {
+        m_pool.Discard(m_frame);
+    }
+}
+
+void FramePublisher::OnLine(const LineView& line) {
+    if (!m_frame || line.newFrame || m_frame->Full()) {
+        NextFrame();
+    }
+    if (m_frame) {
+        m_frame->AppendLine(line);
+    } else {
+        ++m_lostLines;
+    }
+}
+
+void FramePublisher::Finish() {
+    PublishFrame();
+    if (m_frame) {
+        m_pool.Discard(m_frame);
+        m_frame = nullptr;
+    }
+}
+
+void FramePublisher::PublishFrame() {
+    if (m_frame && !m_frame->Empty()) {
+        m_frame->SetFrameNumber(static_cast<int>(++m_published));
+        m_pool.Publish(m_frame);
+        m_frame = nullptr;
+    }
+}
+
+void FramePublisher::NextFrame() {
+    PublishFrame();
+    if (!m_frame) {
+        m_frame = m_pool.Acquire();
+    }
+}
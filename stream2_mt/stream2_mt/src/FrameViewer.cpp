@@ -0,0 +1,173 @@
+#include "../include/FrameViewer.h"
+
+#include <cstring>
+
+namespace {
+
+// How long the upload thread waits for a frame before checking for Stop()
+const std::chrono::milliseconds UPLOAD_POLL(100);
+
+} // namespace
+
+FrameViewer::FrameViewer(FramePool& pool, ViewerSurface& surface)
+    : m_pool(pool)
+    , m_surface(surface)
+    , m_consumer(pool.AddConsumer("display", 1))
+    , m_running(false)
+    , m_openState(OpenState::Pending)
+    , m_settingsVersion(0)
+    , m_uploaded(0)
+    , m_presented(0)
+    , m_presentedMetric(MetricsRegistry::Global().Counter("frames_presented_total", "Frames shown on a viewer surface"))
+    , m_renderUs(MetricsRegistry::Global().Histogram("display_render_us", "Display pipeline render per texture"))
+{
+}
+
+FrameViewer::~FrameViewer() {
+    Stop();
+}
+
+bool FrameViewer::Start() {
+    if (m_presentThread.joinable()) {
+        return m_running.load();
+    }
+
+    m_start = std::chrono::steady_clock::now();
+    m_running = true;
+    m_openState = OpenState::Pending;
+    m_presentThread = std::thread(&FrameViewer::PresentLoop, this);
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stateChanged.wait(lock, [this]() { return m_openState != OpenState::Pending; });
+    }
+    if (m_openState == OpenState::Failed) {
+        m_presentThread.join();
+        return false;
+    }
+
+    m_uploadThread = std::thread(&FrameViewer::UploadLoop, this);
+    return true;
+}
+
+void FrameViewer::Stop() {
+    Finish();
+    if (m_uploadThread.joinable()) {
+        m_uploadThread.join();
+    }
+    if (m_presentThread.joinable()) {
+        m_presentThread.join();
+    }
+}
+
+void FrameViewer::SetSettings(const DisplaySettings& settings) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_settings = settings;
+        ++m_settingsVersion;
+    }
+    m_pool.WakeAll();  // The upload thread may be waiting for a frame that is not coming
+}
+
+DisplaySettings FrameViewer::Settings() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_settings;
+}
+
+void FrameViewer::WaitForClose() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_stateChanged.wait(lock, [this]() { return !m_running.load(); });
+}
+
+bool FrameViewer::WaitForClose(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_stateChanged.wait_for(lock, timeout, [this]() { return !m_running.load(); });
+}
+
+FrameViewerStats FrameViewer::Stats() const {
+    FrameViewerStats stats;
+    stats.produced = m_pool.Stats().published;
+    stats.uploaded = m_uploaded.load();
+    stats.presented = m_presented.load();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    return stats;
+}
+
+void FrameViewer::UploadLoop() {
+    uint64_t appliedVersion = 0;
+    while (m_running.load()) {
+        FrameBuffer* frame = m_pool.WaitForFrame(m_consumer, UPLOAD_POLL);
+        bool changed = false;
+        if (frame) {
+            // Only the copy holds the pool frame; the stages run on the pipeline's
+            m_pipeline.SetFrame(frame->Pixels(), frame->Width(), frame->Height(), frame->FrameNumber());
+            m_pool.Release(frame);
+            changed = true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_settingsVersion != appliedVersion) {
+                appliedVersion = m_settingsVersion;
+                m_pipeline.SetSettings(m_settings);
+                changed = true;
+            }
+        }
+        if (!changed || !m_pipeline.HasFrame()) {
+            continue;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        m_pipeline.Render(m_textures.Back());
+        m_renderUs.RecordSince(start);
+        m_textures.Publish();
+        ++m_uploaded;
+    }
+}
+
+void FrameViewer::PresentLoop() {
+    const bool opened = m_surface.Open();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_openState = opened ? OpenState::Open : OpenState::Failed;
+    }
+    m_stateChanged.notify_all();
+    if (!opened) {
+        Finish();
+        return;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const double hz = m_surface.RefreshHz();
+    const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / (hz > 0.0 ? hz : 60.0)));
+    auto next = Clock::now();
+    while (m_running.load()) {
+        if (!m_surface.Poll()) {
+            break;  // Window closed
+        }
+        if (m_textures.Update()) {
+            m_surface.Present(m_textures.Front());
+            ++m_presented;
+            m_presentedMetric.Add();
+        }
+
+        // A late refresh is not made up for
+        next += period;
+        const auto now = Clock::now();
+        if (next < now) {
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+
+    m_surface.Close();
+    Finish();
+}
+
+void FrameViewer::Finish() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_stateChanged.notify_all();
+    m_pool.WakeAll();
+}
@@ -0,0 +1,154 @@
+#include "../include/Fx3PatternGenerator.h"
+#include "../include/SyncCodes.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+using Sync = SyncWords<Bt656SyncCodes>;
+static_assert(Sync::BITS == 32, "one sync byte per word");
+
+// Byte i of a sync word, in the order it is sent
+constexpr uint8_t SyncByte(uint64_t word, int i) {
+    return static_cast<uint8_t>(word >> (8 * (3 - i)));
+}
+
+constexpr uint8_t BLANK_LOW = 0x10;
+constexpr uint8_t BLANK_HIGH = 0x80;
+
+// Bit (7 - m) of a channel byte lands on bit 4m of the 32-bit word.
+struct SpreadTable {
+    uint32_t value[256];
+
+    SpreadTable() {
+        for (int b = 0; b < 256; ++b) {
+            uint32_t v = 0;
+            for (int m = 0; m < 8; ++m) {
+                v |= static_cast<uint32_t>((b >> (7 - m)) & 1) << (4 * m);
+            }
+            value[b] = v;
+        }
+    }
+};
+
+const SpreadTable& Spread() {
+    static const SpreadTable table;
+    return table;
+}
+
+inline uint32_t InterleaveSame(uint8_t b) {
+    // Same byte on every channel: the four copies never overlap
+    return Spread().value[b] * 0xFu;
+}
+
+inline uint32_t Interleave(uint8_t ch0, uint8_t ch1, uint8_t ch2, uint8_t ch3) {
+    const SpreadTable& s = Spread();
+    return s.value[ch0] | (s.value[ch1] << 1) | (s.value[ch2] << 2) | (s.value[ch3] << 3);
+}
+
+inline void StoreWord(unsigned char* dst, uint32_t word) {
+    std::memcpy(dst, &word, sizeof(word));  // Little-endian host, as on the capture PCs
+}
+
+} // namespace
+
+Fx3PatternGenerator::Fx3PatternGenerator(SimulatorPattern pattern, const VideoGeometry& geometry)
+    : m_pattern(pattern)
+    , m_geometry(geometry)
+    , m_lineWords(8 + geometry.payloadBytes + geometry.blankingBytes)
+    , m_frameLines(geometry.activeLines + geometry.blankingLines)
+    , m_position(0)
+{
+}
+
+uint8_t Fx3PatternGenerator::PixelValue(uint64_t frame, int line, int x) {
+    // Diagonal ramp that moves one step per frame; always within 0x01..0xFE
+    return static_cast<uint8_t>(1 + (static_cast<uint64_t>(x) + static_cast<uint64_t>(line) + frame * 7) % 254);
+}
+
+uint32_t Fx3PatternGenerator::WordAt(uint64_t wordIndex) const {
+    if (m_pattern == SimulatorPattern::Counter) {
+        return static_cast<uint32_t>(wordIndex);
+    }
+
+    const uint64_t frameWords = static_cast<uint64_t>(m_lineWords) * m_frameLines;
+    const uint64_t inFrame = wordIndex % frameWords;
+    return LineWord(wordIndex / frameWords,
+                    static_cast<int>(inFrame / m_lineWords),
+                    static_cast<int>(inFrame % m_lineWords));
+}
+
+uint32_t Fx3PatternGenerator::LineWord(uint64_t frame, int line, int w) const {
+    const bool active = line < m_geometry.activeLines;
+    const int payloadEnd = 4 + m_geometry.payloadBytes;
+
+    if (w < 4) {
+        return InterleaveSame(SyncByte(active ? Sync::SAV : Sync::SAVI, w));
+    }
+    if (w < payloadEnd) {
+        if (!active) {
+            return InterleaveSame(BLANK_LOW);
+        }
+        const int x = 4 * (w - 4);
+        return Interleave(PixelValue(frame, line, x),
+                          PixelValue(frame, line, x + 1),
+                          PixelValue(frame, line, x + 2),
+                          PixelValue(frame, line, x + 3));
+    }
+    if (w < payloadEnd + 4) {
+        const int k = w - payloadEnd;
+        return InterleaveSame(SyncByte(active ? Sync::EAV : Sync::EAVI, k));
+    }
+    return InterleaveSame((w & 1) ? BLANK_HIGH : BLANK_LOW);
+}
+
+void Fx3PatternGenerator::Fill(unsigned char* dst, size_t bytes) {
+    // Leading partial word (only after an odd-sized short packet)
+    while (bytes > 0 && (m_position & 3) != 0) {
+        const uint32_t word = WordAt(m_position / 4);
+        *dst++ = static_cast<unsigned char>(word >> (8 * (m_position & 3)));
+        ++m_position;
+        --bytes;
+    }
+
+    const size_t words = bytes / 4;
+    uint64_t wordIndex = m_position / 4;
+
+    if (m_pattern == SimulatorPattern::Counter) {
+        for (size_t i = 0; i < words; ++i) {
+            StoreWord(dst + 4 * i, static_cast<uint32_t>(wordIndex + i));
+        }
+    } else {
+        // Walk line by line so frame/line are only worked out once per run
+        const uint64_t frameWords = static_cast<uint64_t>(m_lineWords) * m_frameLines;
+        size_t done = 0;
+        while (done < words) {
+            const uint64_t inFrame = wordIndex % frameWords;
+            const uint64_t frame = wordIndex / frameWords;
+            const int line = static_cast<int>(inFrame / m_lineWords);
+            const int w = static_cast<int>(inFrame % m_lineWords);
+            const size_t run = std::min<size_t>(words - done, static_cast<size_t>(m_lineWords - w));
+
+            for (size_t k = 0; k < run; ++k) {
+                StoreWord(dst + 4 * (done + k), LineWord(frame, line, w + static_cast<int>(k)));
+            }
+            done += run;
+            wordIndex += run;
+        }
+    }
+
+    dst += 4 * words;
+    bytes -= 4 * words;
+    m_position += 4 * words;
+
+    // Trailing partial word
+    for (size_t i = 0; i < bytes; ++i) {
+        const uint32_t word = WordAt(m_position / 4);
+        dst[i] = static_cast<unsigned char>(word >> (8 * (m_position & 3)));
+        ++m_position;
+    }
+}
+
+void Fx3PatternGenerator::Skip(size_t bytes) {
+    m_position += bytes;
+}
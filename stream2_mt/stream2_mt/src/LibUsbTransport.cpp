@@ -0,0 +1,303 @@
+#ifdef USE_LIBUSB
+
+#include "../include/LibUsbTransport.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+LibUsbTransport::LibUsbTransport(const LibUsbConfig& config)
+    : m_config(config)
+    , m_context(nullptr)
+    , m_handle(nullptr)
+    , m_maxPacketSize(0)
+    , m_stopEvents(false)
+{
+}
+
+LibUsbTransport::~LibUsbTransport() {
+    Close();
+}
+
+bool LibUsbTransport::Open() {
+    if (m_handle) {
+        return true;
+    }
+
+    int rc = libusb_init(&m_context);
+    if (rc != LIBUSB_SUCCESS) {
+        std::cerr << "libusb_init failed: " << libusb_error_name(rc) << std::endl;
+        m_context = nullptr;
+        return false;
+    }
+
+    m_handle = libusb_open_device_with_vid_pid(m_context, m_config.vendorId, m_config.productId);
+    if (!m_handle) {
+        std::cerr << "Failed to open USB device " << std::hex << m_config.vendorId << ":"
+                  << m_config.productId << std::dec << std::endl;
+        Close();
+        return false;
+    }
+
+    // Let libusb unbind usbfs/g_zero's host-side driver for us
+    libusb_set_auto_detach_kernel_driver(m_handle, 1);
+
+    rc = libusb_claim_interface(m_handle, m_config.interfaceNumber);
+    if (rc != LIBUSB_SUCCESS) {
+        std::cerr << "Failed to claim interface " << m_config.interfaceNumber << ": "
+                  << libusb_error_name(rc) << std::endl;
+        libusb_close(m_handle);
+        m_handle = nullptr;
+        Close();
+        return false;
+    }
+
+    const int maxPacket = libusb_get_max_packet_size(libusb_get_device(m_handle), m_config.endpoint);
+    if (maxPacket <= 0) {
+        std::cerr << "Failed to get bulk endpoint" << std::endl;
+        Close();
+        return false;
+    }
+    m_maxPacketSize = static_cast<size_t>(maxPacket);
+
+    // Print endpoint details for debugging
+    std::cout << "Endpoint Address: 0x" << std::hex
+              << static_cast<int>(m_config.endpoint) << std::dec << std::endl;
+    std::cout << "Max Packet Size: " << m_maxPacketSize << " bytes" << std::endl;
+
+    m_stopEvents = false;
+    m_eventThread = std::thread(&LibUsbTransport::EventThread, this);
+    return true;
+}
+
+void LibUsbTransport::Close() {
+    if (m_handle) {
+        Abort();
+    }
+
+    // No callback can run once the event thread is gone, so a transfer that
+    // never came back cannot touch its slot after ReleaseSlots()
+    if (m_eventThread.joinable()) {
+        m_stopEvents = true;
+#if defined(LIBUSB_API_VERSION) && LIBUSB_API_VERSION >= 0x01000105
+        libusb_interrupt_event_handler(m_context);
+#endif
+        m_eventThread.join();
+    }
+
+    if (m_handle) {
+        ReleaseSlots();
+        libusb_release_interface(m_handle, m_config.interfaceNumber);
+        libusb_close(m_handle);
+        m_handle = nullptr;
+    }
+    if (m_context) {
+        libusb_exit(m_context);
+        m_context = nullptr;
+    }
+    m_maxPacketSize = 0;
+}
+
+bool LibUsbTransport::Configure(int numSlots, size_t transferSize) {
+    (void)transferSize;  // Transfers are sized per Submit()
+    if (!m_handle || numSlots <= 0) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& slot : m_slots) {
+            if (slot.inFlight) {
+                return false;
+            }
+        }
+    }
+
+    ReleaseSlots();
+    m_slots.resize(static_cast<size_t>(numSlots));
+    for (auto& slot : m_slots) {
+        slot.owner = this;
+        slot.transfer = libusb_alloc_transfer(0);
+        if (!slot.transfer) {
+            std::cerr << "Failed to allocate libusb transfer" << std::endl;
+            ReleaseSlots();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool LibUsbTransport::Submit(int slot, unsigned char* data, size_t length) {
+    if (slot < 0 || slot >= static_cast<int>(m_slots.size())) {
+        return false;
+    }
+
+    Slot& s = m_slots[static_cast<size_t>(slot)];
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (s.inFlight) {
+            return false;
+        }
+        s.inFlight = true;
+        s.done = false;
+    }
+
+    // No copy: the device writes straight into the caller's buffer. Timeout 0
+    // means the transfer stays queued until it completes or is cancelled.
+    libusb_fill_bulk_transfer(s.transfer, m_handle, m_config.endpoint, data,
+                              static_cast<int>(length), &LibUsbTransport::OnTransferComplete, &s, 0);
+
+    const int rc = libusb_submit_transfer(s.transfer);
+    if (rc != LIBUSB_SUCCESS) {
+        std::cerr << "libusb_submit_transfer failed: " << libusb_error_name(rc) << std::endl;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        s.inFlight = false;
+        return false;
+    }
+
+    return true;
+}
+
+TransferStatus LibUsbTransport::Reap(int slot, uint32_t timeoutMs, size_t& bytesTransferred) {
+    bytesTransferred = 0;
+    if (slot < 0 || slot >= static_cast<int>(m_slots.size())) {
+        return TransferStatus::Failed;
+    }
+
+    Slot& s = m_slots[static_cast<size_t>(slot)];
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!s.inFlight) {
+        return TransferStatus::Failed;
+    }
+
+    if (!m_completed.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() { return s.done; })) {
+        return TransferStatus::Timeout;
+    }
+
+    return Collect(s, bytesTransferred);
+}
+
+TransferStatus LibUsbTransport::ReapAny(uint32_t timeoutMs, int& slot, size_t& bytesTransferred) {
+    slot = -1;
+    bytesTransferred = 0;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (std::none_of(m_slots.begin(), m_slots.end(), [](const Slot& s) { return s.inFlight; })) {
+        return TransferStatus::Failed;
+    }
+
+    auto findDone = [&]() {
+        for (size_t i = 0; i < m_slots.size(); ++i) {
+            if (m_slots[i].inFlight && m_slots[i].done) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    };
+    if (!m_completed.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                              [&]() { return (slot = findDone()) >= 0; })) {
+        return TransferStatus::Timeout;
+    }
+
+    return Collect(m_slots[static_cast<size_t>(slot)], bytesTransferred);
+}
+
+TransferStatus LibUsbTransport::Collect(Slot& s, size_t& bytesTransferred) {
+    s.inFlight = false;
+    switch (s.transfer->status) {
+    case LIBUSB_TRANSFER_COMPLETED:
+        bytesTransferred = static_cast<size_t>(s.transfer->actual_length);
+        return TransferStatus::Completed;
+    case LIBUSB_TRANSFER_CANCELLED:
+        return TransferStatus::Aborted;
+    default:
+        std::cerr << "Bulk transfer failed, status " << s.transfer->status << std::endl;
+        return TransferStatus::Failed;
+    }
+}
+
+void LibUsbTransport::Abort() {
+    for (auto& s : m_slots) {
+        bool pending;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            pending = s.inFlight && !s.done;
+        }
+        if (pending) {
+            libusb_cancel_transfer(s.transfer);
+        }
+    }
+
+    // Cancellation is asynchronous; the buffers are only ours again once the
+    // event thread has run every callback.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const bool settled = m_completed.wait_for(lock, std::chrono::milliseconds(ABORT_TIMEOUT), [&]() {
+        for (const auto& s : m_slots) {
+            if (s.inFlight && !s.done) {
+                return false;
+            }
+        }
+        return true;
+    });
+    if (!settled) {
+        const auto pending = std::count_if(m_slots.begin(), m_slots.end(),
+                                           [](const Slot& s) { return s.inFlight && !s.done; });
+        std::cerr << "Timed out waiting for " << pending << " cancelled transfers" << std::endl;
+    }
+}
+
+BufferAllocator LibUsbTransport::Allocator() {
+    if (!m_config.useDeviceMemory || !m_handle) {
+        return BufferAllocator();
+    }
+
+    libusb_device_handle* handle = m_handle;
+    BufferAllocator allocator;
+    allocator.allocate = [handle](size_t size) -> unsigned char* {
+        unsigned char* memory = libusb_dev_mem_alloc(handle, size);
+        if (!memory) {
+            std::cerr << "libusb_dev_mem_alloc failed, using heap buffers" << std::endl;
+        }
+        return memory;
+    };
+    allocator.release = [handle](unsigned char* memory, size_t size) {
+        libusb_dev_mem_free(handle, memory, size);
+    };
+    return allocator;
+}
+
+void LIBUSB_CALL LibUsbTransport::OnTransferComplete(libusb_transfer* transfer) {
+    Slot* slot = static_cast<Slot*>(transfer->user_data);
+    LibUsbTransport* self = slot->owner;
+    {
+        std::lock_guard<std::mutex> lock(self->m_mutex);
+        slot->done = true;
+    }
+    self->m_completed.notify_all();
+}
+
+void LibUsbTransport::EventThread() {
+    timeval tv = { 0, 100000 };  // Re-check m_stopEvents every 100 ms
+    while (!m_stopEvents) {
+        libusb_handle_events_timeout_completed(m_context, &tv, nullptr);
+    }
+}
+
+void LibUsbTransport::ReleaseSlots() {
+    // libusb still owns a transfer whose cancellation never completed, and
+    // freeing it would be a use after free; leak it instead
+    size_t leaked = 0;
+    for (auto& s : m_slots) {
+        if (s.inFlight && !s.done) {
+            ++leaked;
+        } else if (s.transfer) {
+            libusb_free_transfer(s.transfer);
+        }
+    }
+    if (leaked > 0) {
+        std::cerr << "Leaking " << leaked << " transfers the device never gave back" << std::endl;
+    }
+    m_slots.clear();
+}
+
+#endif // USE_LIBUSB
@@ -0,0 +1,131 @@
+#include "../include/LineParser.h"
+#include "../include/Deinterleave.h"
+
+namespace {
+
+// Copies each line out of the parser's window, for callers that keep lines
+class ParsedLineCollector : public LineSink {
+public:
+    explicit ParsedLineCollector(std::vector<ParsedLine>& out) : m_out(out) {}
+
+    void OnLine(const LineView& view) override {
+        m_out.emplace_back();
+        ParsedLine& line = m_out.back();
+        static_cast<LineSpan&>(line) = view;
+
+        m_row.resize(view.bytes * 4);
+        CutRow(view.pixels, view.payloadBit, view.bytes, m_row.data());
+        for (int c = 0; c < 4; ++c) {
+            line.channels[c].resize(view.bytes);
+            PickChannel(m_row.data(), view.bytes, c, line.channels[c].data());
+        }
+    }
+
+private:
+    std::vector<ParsedLine>& m_out;
+    std::vector<uint8_t> m_row;
+};
+
+} // namespace
+
+LineParser::LineParser()
+    : m_wordsMetric(MetricsRegistry::Global().Counter("parser_words_total", "Capture words parsed"))
+    , m_linesMetric(MetricsRegistry::Global().Counter("parser_lines_total", "Lines passed to a sink"))
+    , m_framesMetric(MetricsRegistry::Global().Counter("parser_frames_total", "Frames started"))
+    , m_feedUs(MetricsRegistry::Global().Histogram("parser_feed_us", "Time to parse one acquisition buffer"))
+{
+    Reset();
+}
+
+void LineParser::Reset() {
+    m_pixels.clear();
+    m_baseByte = 0;
+    m_scanner.Reset();
+    m_marks.clear();
+    m_pairer.Reset();
+    m_stats = LineParserStats();
+}
+
+void LineParser::Feed(const uint32_t* words, size_t count, LineSink& sink) {
+    if (count == 0) {
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+
+    // Four pixels, one packed byte per channel, per word
+    const size_t oldSize = m_pixels.size();
+    m_pixels.resize(oldSize + count * 4);
+    InterleaveChannels(words, count, m_pixels.data() + oldSize);
+    m_stats.words += count;
+    m_wordsMetric.Add(count);
+
+    // Channel 0 carries the frame structure, as in analyzeData
+    m_scan.resize(count);
+    PickChannel(m_pixels.data() + oldSize, count, 0, m_scan.data());
+    m_marks.clear();
+    m_scanner.Feed(m_scan.data(), count, m_marks);
+
+    const auto emit = [this, &sink](const LineSpan& span) { Emit(span, sink); };
+    for (const SyncMark& mark : m_marks) {
+        m_pairer.Mark(mark, emit);
+    }
+    m_pairer.Expire(m_scanner.BitsSeen(), emit);
+
+    Trim();
+    m_feedUs.RecordSince(start);
+}
+
+void LineParser::Flush(LineSink& sink) {
+    m_pairer.Flush(m_scanner.BitsSeen(), [this, &sink](const LineSpan& span) { Emit(span, sink); });
+    Trim();
+}
+
+void LineParser::Feed(const uint32_t* words, size_t count, std::vector<ParsedLine>& out) {
+    ParsedLineCollector collector(out);
+    Feed(words, count, collector);
+}
+
+void LineParser::Flush(std::vector<ParsedLine>& out) {
+    ParsedLineCollector collector(out);
+    Flush(collector);
+}
+
+void LineParser::Emit(const LineSpan& span, LineSink& sink) {
+    LineView line;
+    static_cast<LineSpan&>(line) = span;
+    line.pixels = m_pixels.data();
+
+    // Whole bytes of payload after the SAV code, inside the retained window
+    const uint64_t payloadBit = span.startBit + LinePairer::SYNC_BITS;
+    line.bytes = span.endBit > payloadBit ? static_cast<size_t>((span.endBit - payloadBit) / 8) : 0;
+    line.payloadBit = static_cast<size_t>(payloadBit - m_baseByte * 8);
+    sink.OnLine(line);
+
+    ++m_stats.lines;
+    m_linesMetric.Add();
+    if (!span.hasEav) {
+        ++m_stats.linesWithoutEav;
+    }
+    if (span.newFrame) {
+        ++m_stats.frames;
+        m_framesMetric.Add();
+    }
+}
+
+void LineParser::Trim() {
+    // Keep the bytes an unfinished line still needs; a SAV found at the
+    // start of a buffer may begin in bytes that are already gone, but its
+    // payload never does
+    const uint64_t endByte = m_baseByte + m_pixels.size() / 4;
+    uint64_t keepByte = m_pairer.HasOpenLines() ? m_pairer.OldestOpenLine() / 8 : endByte;
+    if (keepByte < m_baseByte) {
+        keepByte = m_baseByte;
+    }
+
+    const size_t drop = static_cast<size_t>(keepByte - m_baseByte);
+    if (drop == 0) {
+        return;
+    }
+    m_pixels.erase(m_pixels.begin(), m_pixels.begin() + static_cast<std::ptrdiff_t>(drop * 4));
+    m_baseByte = keepByte;
+}
@@ -0,0 +1,313 @@
+#include "../include/Metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+// Upper edge of the bucket holding the given percentile (0..100)
+double Percentile(const std::array<uint64_t, LogLinearBuckets::COUNT>& counts, uint64_t count, uint64_t max, double percent) {
+    if (count == 0) {
+        return 0.0;
+    }
+    const uint64_t rank = static_cast<uint64_t>(percent / 100.0 * static_cast<double>(count - 1));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen > rank) {
+            return static_cast<double>(std::min<uint64_t>(LogLinearBuckets::UpperEdge(i), max));
+        }
+    }
+    return static_cast<double>(max);
+}
+
+const char* KindName(MetricKind kind) {
+    switch (kind) {
+    case MetricKind::Gauge:
+        return "gauge";
+    case MetricKind::Histogram:
+        return "summary";
+    default:
+        return "counter";
+    }
+}
+
+// Help text as Prometheus wants it: backslashes and newlines escaped
+std::string EscapeHelp(const std::string& help) {
+    std::string escaped;
+    for (char c : help) {
+        if (c == '\\') {
+            escaped += "\\\\";
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+bool EndsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+uint64_t MetricCounter::Value() const {
+    uint64_t total = 0;
+    for (const Cell& cell : m_cells) {
+        total += cell.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+HistogramSummary MetricHistogram::Summary() const {
+    // Cells are read while they are being updated, so count and sum may be
+    // a few samples apart; neither ever goes backwards
+    std::array<uint64_t, LogLinearBuckets::COUNT> counts{};
+    HistogramSummary summary;
+    for (const Cell& cell : m_cells) {
+        for (size_t i = 0; i < counts.size(); ++i) {
+            const uint64_t n = cell.counts[i].load(std::memory_order_relaxed);
+            counts[i] += n;
+            summary.count += n;
+        }
+        summary.sum += cell.sum.load(std::memory_order_relaxed);
+        summary.max = std::max<uint64_t>(summary.max, cell.max.load(std::memory_order_relaxed));
+    }
+    summary.p50 = Percentile(counts, summary.count, summary.max, 50.0);
+    summary.p90 = Percentile(counts, summary.count, summary.max, 90.0);
+    summary.p99 = Percentile(counts, summary.count, summary.max, 99.0);
+    summary.p999 = Percentile(counts, summary.count, summary.max, 99.9);
+    return summary;
+}
+
+const MetricSample* MetricsSnapshot::Find(const std::string& name) const {
+    for (const MetricSample& sample : samples) {
+        if (sample.name == name) {
+            return &sample;
+        }
+    }
+    return nullptr;
+}
+
+MetricsRegistry::MetricsRegistry()
+    : m_start(std::chrono::steady_clock::now())
+{
+}
+
+MetricsRegistry& MetricsRegistry::Global() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricCounter& MetricsRegistry::Counter(const std::string& name, const std::string& help) {
+    return *Find(name, help, MetricKind::Counter).counter;
+}
+
+MetricGauge& MetricsRegistry::Gauge(const std::string& name, const std::string& help) {
+    return *Find(name, help, MetricKind::Gauge).gauge;
+}
+
+MetricHistogram& MetricsRegistry::Histogram(const std::string& name, const std::string& help) {
+    return *Find(name, help, MetricKind::Histogram).histogram;
+}
+
+MetricsRegistry::Entry& MetricsRegistry::Find(const std::string& name, const std::string& help, MetricKind kind) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool clash = false;
+    for (auto& entry : m_entries) {
+        if (entry->name == name) {
+            if (entry->kind != kind) {
+                // A programming error. Exporting two series of one name
+                // would break every scraper, so the second caller gets a
+                // metric that is never exported.
+                std::cerr << "Metric " << name << " registered as a " << KindName(entry->kind)
+                          << ", refusing it as a " << KindName(kind) << std::endl;
+                clash = true;
+                break;
+            }
+            return *entry;
+        }
+    }
+    if (clash) {
+        for (auto& entry : m_rejected) {
+            if (entry->name == name && entry->kind == kind) {
+                return *entry;
+            }
+        }
+    }
+
+    auto entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->help = help;
+    entry->kind = kind;
+    switch (kind) {
+    case MetricKind::Counter:
+        entry->counter = std::make_unique<MetricCounter>();
+        break;
+    case MetricKind::Gauge:
+        entry->gauge = std::make_unique<MetricGauge>();
+        break;
+    case MetricKind::Histogram:
+        entry->histogram = std::make_unique<MetricHistogram>();
+        break;
+    }
+    auto& entries = clash ? m_rejected : m_entries;
+    entries.push_back(std::move(entry));
+    return *entries.back();
+}
+
+MetricsSnapshot MetricsRegistry::Snapshot() const {
+    MetricsSnapshot snapshot;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    snapshot.uptimeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    snapshot.samples.reserve(m_entries.size());
+    for (const auto& entry : m_entries) {
+        MetricSample sample;
+        sample.name = entry->name;
+        sample.help = entry->help;
+        sample.kind = entry->kind;
+        switch (entry->kind) {
+        case MetricKind::Counter:
+            sample.value = static_cast<double>(entry->counter->Value());
+            break;
+        case MetricKind::Gauge:
+            sample.value = static_cast<double>(entry->gauge->Value());
+            break;
+        case MetricKind::Histogram:
+            sample.histogram = entry->histogram->Summary();
+            break;
+        }
+        snapshot.samples.push_back(std::move(sample));
+    }
+    return snapshot;
+}
+
+void WriteMetricsJson(const MetricsSnapshot& snapshot, std::ostream& out) {
+    // Metric names are snake_case, so they need no escaping. Counts are
+    // written whole, not in exponent form.
+    const std::streamsize precision = out.precision(17);
+    out << "{\"uptime_s\":" << snapshot.uptimeSeconds;
+    for (const MetricSample& sample : snapshot.samples) {
+        out << ",\"" << sample.name << "\":";
+        if (sample.kind == MetricKind::Histogram) {
+            const HistogramSummary& h = sample.histogram;
+            out << "{\"count\":" << h.count << ",\"sum\":" << h.sum << ",\"p50\":" << h.p50
+                << ",\"p90\":" << h.p90 << ",\"p99\":" << h.p99 << ",\"p999\":" << h.p999
+                << ",\"max\":" << h.max << "}";
+        } else {
+            out << sample.value;
+        }
+    }
+    out << "}\n";
+    out.precision(precision);
+}
+
+void WriteMetricsPrometheus(const MetricsSnapshot& snapshot, std::ostream& out) {
+    const std::streamsize precision = out.precision(17);
+    for (const MetricSample& sample : snapshot.samples) {
+        out << "# HELP " << sample.name << " " << EscapeHelp(sample.help) << "\n";
+        out << "# TYPE " << sample.name << " " << KindName(sample.kind) << "\n";
+        if (sample.kind == MetricKind::Histogram) {
+            const HistogramSummary& h = sample.histogram;
+            out << sample.name << "{quantile=\"0.5\"} " << h.p50 << "\n";
+            out << sample.name << "{quantile=\"0.9\"} " << h.p90 << "\n";
+            out << sample.name << "{quantile=\"0.99\"} " << h.p99 << "\n";
+            out << sample.name << "{quantile=\"0.999\"} " << h.p999 << "\n";
+            out << sample.name << "_sum " << h.sum << "\n";
+            out << sample.name << "_count " << h.count << "\n";
+        } else {
+            out << sample.name << " " << sample.value << "\n";
+        }
+    }
+    out.precision(precision);
+}
+
+std::string FormatMetricsLine(const MetricsSnapshot& now, const MetricsSnapshot& previous) {
+    const double seconds = now.uptimeSeconds - previous.uptimeSeconds;
+    std::ostringstream line;
+    line.setf(std::ios::fixed);
+    line.precision(1);
+    const char* separator = "";
+    for (const MetricSample& sample : now.samples) {
+        const MetricSample* before = previous.Find(sample.name);
+        switch (sample.kind) {
+        case MetricKind::Counter: {
+            if (sample.value == 0.0) {
+                continue;
+            }
+            const double delta = sample.value - (before ? before->value : 0.0);
+            const double rate = seconds > 0.0 ? delta / seconds : 0.0;
+            if (EndsWith(sample.name, "bytes_total")) {
+                line << separator << sample.name << " " << rate / (1024.0 * 1024.0) << " MB/s";
+            } else {
+                line << separator << sample.name << " " << rate << "/s";
+            }
+            break;
+        }
+        case MetricKind::Gauge:
+            if (sample.value == 0.0 && (!before || before->value == 0.0)) {
+                continue;
+            }
+            line << separator << sample.name << " " << static_cast<int64_t>(sample.value);
+            break;
+        case MetricKind::Histogram:
+            if (sample.histogram.count == 0) {
+                continue;
+            }
+            line << separator << sample.name << " p50 " << static_cast<uint64_t>(sample.histogram.p50) << " p99 "
+                 << static_cast<uint64_t>(sample.histogram.p99) << " max " << sample.histogram.max;
+            break;
+        }
+        separator = ", ";
+    }
+    return line.str();
+}
+
+MetricsReporter::MetricsReporter(MetricsRegistry& registry)
+    : m_registry(registry)
+    , m_previous(registry.Snapshot())
+    , m_prometheus(false)
+{
+}
+
+bool MetricsReporter::SetExport(const std::string& path) {
+    m_prometheus = EndsWith(path, ".prom");
+    m_exportPath = path;
+    if (m_prometheus) {
+        return true;
+    }
+    m_jsonLines.open(path, std::ios::out | std::ios::app);
+    if (!m_jsonLines) {
+        std::cerr << "Failed to open metrics file " << path << std::endl;
+        m_exportPath.clear();
+        return false;
+    }
+    return true;
+}
+
+std::string MetricsReporter::Tick() {
+    MetricsSnapshot now = m_registry.Snapshot();
+    if (m_prometheus) {
+        // Written aside and renamed over, so a scrape never reads half a file
+        const std::string temporary = m_exportPath + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::out | std::ios::trunc);
+            WriteMetricsPrometheus(now, file);
+        }
+        if (std::rename(temporary.c_str(), m_exportPath.c_str()) != 0) {
+            std::remove(m_exportPath.c_str());  // Windows will not rename over a file
+            std::rename(temporary.c_str(), m_exportPath.c_str());
+        }
+    } else if (m_jsonLines.is_open()) {
+        WriteMetricsJson(now, m_jsonLines);
+        m_jsonLines.flush();
+    }
+
+    std::string line = FormatMetricsLine(now, m_previous);
+    m_previous = std::move(now);
+    return line;
+}
@@ -0,0 +1,150 @@
+#include "../include/QueueTuner.h"
+#include <algorithm>
+#include <iomanip>
+
+QueueTuner::QueueTuner(BulkInTransport& transport, const QueueTuneOptions& options)
+    : m_transport(transport)
+    , m_options(options)
+{
+}
+
+std::vector<QueueTunePoint> QueueTuner::Sweep() {
+    // Transfers must be whole packets for the FX3 driver
+    const size_t packet = std::max<size_t>(m_transport.MaxPacketSize(), 4);
+
+    std::vector<std::pair<int, size_t>> combos;
+    for (int depth : m_options.depths) {
+        for (size_t size : m_options.transferSizes) {
+            const size_t rounded = (size + packet - 1) / packet * packet;
+            combos.emplace_back(depth, rounded);
+        }
+    }
+    std::sort(combos.begin(), combos.end(), [](const auto& a, const auto& b) {
+        const size_t memA = static_cast<size_t>(a.first) * a.second;
+        const size_t memB = static_cast<size_t>(b.first) * b.second;
+        return memA != memB ? memA < memB : a.first < b.first;
+    });
+    combos.erase(std::unique(combos.begin(), combos.end()), combos.end());
+
+    std::vector<QueueTunePoint> points;
+    points.reserve(combos.size());
+    for (const auto& combo : combos) {
+        points.push_back(Measure(combo.first, combo.second));
+    }
+    return points;
+}
+
+QueueTunePoint QueueTuner::Measure(int depth, size_t transferSize) {
+    using Clock = std::chrono::steady_clock;
+
+    QueueTunePoint point;
+    point.depth = depth;
+    point.transferSize = transferSize;
+
+    if (!m_transport.Configure(depth, transferSize)) {
+        return point;
+    }
+
+    std::vector<unsigned char> pool(static_cast<size_t>(depth) * transferSize);
+    auto slotData = [&](int slot) { return pool.data() + static_cast<size_t>(slot) * transferSize; };
+
+    std::vector<bool> inFlight(static_cast<size_t>(depth), false);
+    for (int slot = 0; slot < depth; ++slot) {
+        inFlight[slot] = m_transport.Submit(slot, slotData(slot), transferSize);
+    }
+
+    const auto start = Clock::now();
+    const auto measureStart = start + m_options.warmup;
+    bool measuring = false;
+    bool failed = false;
+    Clock::time_point t0 = measureStart;
+    uint64_t droppedAtStart = 0;
+    uint64_t bytes = 0;
+
+    for (int slot = 0; !failed; slot = (slot + 1) % depth) {
+        if (!inFlight[slot]) {
+            failed = true;
+            break;
+        }
+
+        size_t transferred = 0;
+        const TransferStatus status = m_transport.Reap(slot, m_options.reapTimeoutMs, transferred);
+        inFlight[slot] = false;
+        if (status != TransferStatus::Completed) {
+            failed = true;
+            break;
+        }
+
+        const auto now = Clock::now();
+        if (!measuring && now >= measureStart) {
+            // Whatever the source lost while we were setting up is not
+            // this configuration's fault
+            measuring = true;
+            t0 = now;
+            droppedAtStart = m_transport.DroppedBytes();
+        } else if (measuring) {
+            bytes += transferred;
+            if (now - t0 >= m_options.measure) {
+                const double seconds = std::chrono::duration<double>(now - t0).count();
+                point.bytesPerSecond = bytes / seconds;
+                point.droppedBytes = m_transport.DroppedBytes() - droppedAtStart;
+                break;
+            }
+        }
+
+        inFlight[slot] = m_transport.Submit(slot, slotData(slot), transferSize);
+    }
+
+    // Cancel and collect whatever is still queued before the pool goes away
+    m_transport.Abort();
+    for (int slot = 0; slot < depth; ++slot) {
+        if (inFlight[slot]) {
+            size_t ignored = 0;
+            m_transport.Reap(slot, m_options.reapTimeoutMs, ignored);
+        }
+    }
+
+    point.sustained = !failed && point.droppedBytes == 0 &&
+                      point.bytesPerSecond >= m_options.targetBytesPerSecond * SUSTAIN_MARGIN;
+    return point;
+}
+
+bool QueueTuner::PickSmallest(const std::vector<QueueTunePoint>& points, QueueTunePoint& best) {
+    const QueueTunePoint* smallest = nullptr;
+    const QueueTunePoint* fastest = nullptr;
+    for (const auto& point : points) {
+        if (point.sustained && (!smallest || point.InFlightBytes() < smallest->InFlightBytes())) {
+            smallest = &point;
+        }
+        if (!fastest || point.bytesPerSecond > fastest->bytesPerSecond) {
+            fastest = &point;
+        }
+    }
+
+    if (smallest) {
+        best = *smallest;
+        return true;
+    }
+    if (fastest) {
+        best = *fastest;
+    }
+    return false;
+}
+
+void QueueTuner::PrintCurve(const std::vector<QueueTunePoint>& points, std::ostream& out) {
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+
+    out << " depth   xfer KB  in-flight KB      MB/s  dropped\n";
+    for (const auto& point : points) {
+        out << std::setw(6) << point.depth
+            << std::setw(10) << point.transferSize / 1024
+            << std::setw(14) << point.InFlightBytes() / 1024
+            << std::setw(10) << std::fixed << std::setprecision(1) << point.bytesPerSecond / (1024.0 * 1024.0)
+            << std::setw(9) << point.droppedBytes
+            << (point.sustained ? "  ok" : "") << '\n';
+    }
+    out.flags(flags);
+    out.precision(precision);
+    out << std::flush;
+}
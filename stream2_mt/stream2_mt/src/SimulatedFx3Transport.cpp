@@ -0,0 +1,256 @@
+#include "../include/SimulatedFx3Transport.h"
+#include <algorithm>
+
+SimulatedFx3Transport::SimulatedFx3Transport(const SimulatorConfig& config)
+    : m_config(config)
+    , m_generator(config.pattern, config.geometry)
+    , m_rng(config.seed)
+    , m_activeSlot(-1)
+    , m_open(false)
+    , m_stopping(false)
+    , m_starved(false)
+    , m_transferCount(0)
+    , m_droppedBytes(0)
+{
+}
+
+SimulatedFx3Transport::~SimulatedFx3Transport() {
+    Close();
+}
+
+bool SimulatedFx3Transport::Open() {
+    if (m_open) {
+        return true;
+    }
+
+    m_stopping = false;
+    m_nextCompletion = std::chrono::steady_clock::time_point();
+    m_starved = false;
+    m_deviceThread = std::thread(&SimulatedFx3Transport::DeviceThread, this);
+    m_open = true;
+    return true;
+}
+
+void SimulatedFx3Transport::Close() {
+    if (!m_open) {
+        return;
+    }
+
+    Abort();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_submitted.notify_all();
+    m_deviceThread.join();
+
+    m_slots.clear();
+    m_open = false;
+}
+
+bool SimulatedFx3Transport::Configure(int numSlots, size_t transferSize) {
+    (void)transferSize;  // Any length can be submitted
+    if (!m_open || numSlots <= 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& slot : m_slots) {
+        if (slot.state == SlotState::Queued) {
+            return false;
+        }
+    }
+    m_slots.assign(static_cast<size_t>(numSlots), Slot());
+    return true;
+}
+
+bool SimulatedFx3Transport::Submit(int slot, unsigned char* data, size_t length) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (slot < 0 || slot >= static_cast<int>(m_slots.size()) || !data || length == 0) {
+            return false;
+        }
+
+        Slot& s = m_slots[static_cast<size_t>(slot)];
+        if (s.state != SlotState::Idle) {
+            return false;
+        }
+
+        s.state = SlotState::Queued;
+        s.data = data;
+        s.length = length;
+        s.transferred = 0;
+        m_queue.push_back(slot);
+    }
+    m_submitted.notify_one();
+    return true;
+}
+
+TransferStatus SimulatedFx3Transport::Reap(int slot, uint32_t timeoutMs, size_t& bytesTransferred) {
+    bytesTransferred = 0;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (slot < 0 || slot >= static_cast<int>(m_slots.size())) {
+        return TransferStatus::Failed;
+    }
+
+    Slot& s = m_slots[static_cast<size_t>(slot)];
+    if (s.state == SlotState::Idle) {
+        return TransferStatus::Failed;
+    }
+
+    if (!m_completed.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                              [&]() { return s.state == SlotState::Done; })) {
+        return TransferStatus::Timeout;
+    }
+
+    s.state = SlotState::Idle;
+    bytesTransferred = s.transferred;
+    return s.status;
+}
+
+TransferStatus SimulatedFx3Transport::ReapAny(uint32_t timeoutMs, int& slot, size_t& bytesTransferred) {
+    slot = -1;
+    bytesTransferred = 0;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (std::all_of(m_slots.begin(), m_slots.end(),
+                    [](const Slot& s) { return s.state == SlotState::Idle; })) {
+        return TransferStatus::Failed;
+    }
+
+    auto findDone = [&]() {
+        for (size_t i = 0; i < m_slots.size(); ++i) {
+            if (m_slots[i].state == SlotState::Done) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    };
+    if (!m_completed.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                              [&]() { return (slot = findDone()) >= 0; })) {
+        return TransferStatus::Timeout;
+    }
+
+    Slot& s = m_slots[static_cast<size_t>(slot)];
+    s.state = SlotState::Idle;
+    bytesTransferred = s.transferred;
+    return s.status;
+}
+
+void SimulatedFx3Transport::Abort() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (int slot : m_queue) {
+        Slot& s = m_slots[static_cast<size_t>(slot)];
+        s.state = SlotState::Done;
+        s.status = TransferStatus::Aborted;
+        s.transferred = 0;
+    }
+    m_queue.clear();
+
+    // The transfer being filled right now is cancelled too, but we must not
+    // return until the device thread has stopped writing into its buffer.
+    if (m_activeSlot >= 0) {
+        Slot& s = m_slots[static_cast<size_t>(m_activeSlot)];
+        s.state = SlotState::Done;
+        s.status = TransferStatus::Aborted;
+        s.transferred = 0;
+        m_completed.wait(lock, [&]() { return m_activeSlot < 0; });
+    }
+}
+
+uint64_t SimulatedFx3Transport::DroppedBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_droppedBytes;
+}
+
+size_t SimulatedFx3Transport::CompletionLength(size_t requested) {
+    const uint32_t every = m_config.shortPacketEveryTransfers;
+    const size_t packet = m_config.maxPacketSize;
+    if (every == 0 || m_transferCount % every != 0 || requested <= 4 || packet < 8) {
+        return requested;
+    }
+
+    // Whole packets followed by one short one; the FX3 bus is 32 bits wide so
+    // lengths stay word-aligned.
+    const size_t wholePackets = requested / packet;
+    std::uniform_int_distribution<size_t> packets(0, wholePackets > 0 ? wholePackets - 1 : 0);
+    std::uniform_int_distribution<size_t> tailWords(1, packet / 4 - 1);
+    const size_t length = packets(m_rng) * packet + tailWords(m_rng) * 4;
+    return std::min<size_t>(length, requested - 4);
+}
+
+void SimulatedFx3Transport::DeviceThread() {
+    using Clock = std::chrono::steady_clock;
+    using Seconds = std::chrono::duration<double>;
+
+    const bool paced = m_config.bytesPerSecond > 0.0;
+    const auto slack = std::chrono::duration_cast<Clock::duration>(
+        Seconds(paced ? m_config.deviceBufferBytes / m_config.bytesPerSecond : 0.0));
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_submitted.wait(lock, [&]() { return m_stopping || !m_queue.empty(); });
+        if (m_stopping) {
+            break;
+        }
+
+        const int slot = m_queue.front();
+        m_queue.pop_front();
+        m_activeSlot = slot;
+
+        ++m_transferCount;
+        unsigned char* data = m_slots[static_cast<size_t>(slot)].data;
+        const size_t length = CompletionLength(m_slots[static_cast<size_t>(slot)].length);
+        const bool stall = m_config.stallEveryTransfers != 0 &&
+                           m_transferCount % m_config.stallEveryTransfers == 0;
+        const bool starved = m_starved;
+        m_starved = false;
+        lock.unlock();
+
+        uint64_t dropped = 0;
+        if (paced) {
+            const auto now = Clock::now();
+            if (m_nextCompletion == Clock::time_point()) {
+                m_nextCompletion = now;
+            }
+            else if (now > m_nextCompletion + slack) {
+                if (starved) {
+                    // Host left us without a transfer longer than the DMA
+                    // buffers last: that part of the sensor stream is gone.
+                    const double late = std::chrono::duration_cast<Seconds>(now - m_nextCompletion - slack).count();
+                    dropped = static_cast<uint64_t>(late * m_config.bytesPerSecond) & ~uint64_t(3);
+                    m_generator.Skip(static_cast<size_t>(dropped));
+                }
+                m_nextCompletion = now - slack;
+            }
+            m_nextCompletion += std::chrono::duration_cast<Clock::duration>(
+                Seconds(length / m_config.bytesPerSecond));
+        }
+
+        m_generator.Fill(data, length);
+
+        if (stall) {
+            // Device is quiet rather than overrunning, so nothing is dropped
+            std::this_thread::sleep_for(std::chrono::milliseconds(m_config.stallMs));
+            m_nextCompletion += std::chrono::milliseconds(m_config.stallMs);
+        }
+        if (paced) {
+            std::this_thread::sleep_until(m_nextCompletion);
+        }
+
+        lock.lock();
+        m_droppedBytes += dropped;
+        m_activeSlot = -1;
+
+        Slot& s = m_slots[static_cast<size_t>(slot)];
+        if (s.state == SlotState::Queued) {
+            s.state = SlotState::Done;
+            s.status = TransferStatus::Completed;
+            s.transferred = length;
+        }
+        m_starved = m_queue.empty();
+        m_completed.notify_all();
+    }
+}
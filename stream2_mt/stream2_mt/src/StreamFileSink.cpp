@@ -0,0 +1,48 @@
+#include "../include/StreamFileSink.h"
+#include <iostream>
+
+StreamFileSink::StreamFileSink()
+    : m_bytesSinceFlush(0)
+{
+}
+
+StreamFileSink::~StreamFileSink() {
+    Close();
+}
+
+bool StreamFileSink::Open(const std::string& path, size_t expectedBytes) {
+    (void)expectedBytes;  // The stream grows the file as it goes
+
+    // Configure file buffer size for more frequent writes
+    m_outFile.rdbuf()->pubsetbuf(nullptr, STREAM_BUFFER_SIZE);
+
+    m_outFile.open(path, std::ios::binary | std::ios::out);
+    if (!m_outFile.is_open()) {
+        std::cerr << "Failed to open output file" << std::endl;
+        return false;
+    }
+
+    m_bytesSinceFlush = 0;
+    return true;
+}
+
+bool StreamFileSink::Write(const unsigned char* data, size_t length) {
+    m_outFile.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(length));
+    m_bytesSinceFlush += length;
+
+    if (m_bytesSinceFlush >= FLUSH_THRESHOLD) {
+        m_outFile.flush();
+        m_bytesSinceFlush = 0;
+    }
+
+    return m_outFile.good();
+}
+
+bool StreamFileSink::Close() {
+    if (!m_outFile.is_open()) {
+        return true;
+    }
+
+    m_outFile.close();
+    return !m_outFile.fail();
+}
@@ -0,0 +1,45 @@
+#include "../include/SyncPairing.h"
+
+std::vector<size_t> IntersectSorted(const std::vector<size_t>& a, const std::vector<size_t>& b) {
+    std::vector<size_t> result;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            // a[i] stays: the next b may repeat it
+            result.push_back(b[j++]);
+        }
+    }
+    return result;
+}
+
+std::vector<size_t> FirstAfter(const std::vector<size_t>& keys, const std::vector<size_t>& values) {
+    std::vector<size_t> result(keys.size());
+    size_t j = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        while (j < values.size() && values[j] <= keys[i]) {
+            ++j;
+        }
+        result[i] = j;
+    }
+    return result;
+}
+
+void MatchSyncPairs(std::vector<size_t>& start, std::vector<size_t>& stop, const SyncPairWindow& window) {
+    std::vector<size_t> matched(start.size());
+    size_t j = 0;
+    for (size_t i = 0; i < start.size(); ++i) {
+        const size_t s = start[i];
+        // Stops too close to this start are too close to every later one
+        while (j < stop.size() && stop[j] < s + window.minBits) {
+            ++j;
+        }
+        const bool found = j < stop.size() && stop[j] <= s + window.maxBits;
+        matched[i] = found ? stop[j] : s + window.fallbackBits;
+    }
+    stop.swap(matched);
+}
@@ -0,0 +1,51 @@
+#include "../include/SyncScanner.h"
+#include <array>
+
+namespace {
+
+// Bit-reversed value of every byte
+const std::array<uint8_t, 256> kReversed = []() {
+    std::array<uint8_t, 256> table{};
+    for (int i = 0; i < 256; ++i) {
+        uint8_t reversed = 0;
+        for (int bit = 0; bit < 8; ++bit) {
+            reversed |= static_cast<uint8_t>(((i >> bit) & 1) << (7 - bit));
+        }
+        table[static_cast<size_t>(i)] = reversed;
+    }
+    return table;
+}();
+
+} // namespace
+
+void ExtractChannel(const uint32_t* words, size_t count, int channel, uint8_t* out) {
+    for (size_t i = 0; i < count; ++i) {
+        // Gather bits channel, channel + 4, ..., channel + 28 into the low byte
+        uint32_t x = (words[i] >> channel) & 0x11111111u;
+        x = (x | (x >> 3)) & 0x03030303u;
+        x = (x | (x >> 6)) & 0x000F000Fu;
+        x = (x | (x >> 12)) & 0xFFu;
+        out[i] = kReversed[x];  // Earliest bit to the MSB
+    }
+}
+
+SyncPositions ScanChannel(const uint32_t* words, size_t count, int channel) {
+    std::vector<uint8_t> packed(count);
+    ExtractChannel(words, count, channel, packed.data());
+
+    std::vector<SyncMark> marks;
+    SyncScanner scanner;
+    scanner.Feed(packed.data(), packed.size(), marks);
+
+    SyncPositions positions;
+    for (const SyncMark& mark : marks) {
+        const size_t bit = static_cast<size_t>(mark.bit);
+        switch (mark.code) {
+        case SyncCode::SAV: positions.sav.push_back(bit); break;
+        case SyncCode::EAV: positions.eav.push_back(bit); break;
+        case SyncCode::SAVI: positions.savi.push_back(bit); break;
+        case SyncCode::EAVI: positions.eavi.push_back(bit); break;
+        }
+    }
+    return positions;
+}
@@ -0,0 +1,446 @@
+#ifdef __linux__
+
+#include "../include/UringFileSink.h"
+#include "../include/DirectFileSink.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t kAlignment = DirectFileSink::ALIGNMENT;
+
+bool IsAligned(const void* pointer) {
+    return (reinterpret_cast<uintptr_t>(pointer) & (kAlignment - 1)) == 0;
+}
+
+size_t RoundUp(size_t bytes) {
+    return (bytes + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+} // namespace
+
+UringFileSink::UringFileSink(const UringConfig& config)
+    : m_config(config)
+    , m_fd(-1)
+    , m_ringFd(-1)
+    , m_sqPollActive(false)
+    , m_failed(false)
+    , m_sqRing(nullptr)
+    , m_cqRing(nullptr)
+    , m_sqRingBytes(0)
+    , m_cqRingBytes(0)
+    , m_sqes(nullptr)
+    , m_sqesBytes(0)
+    , m_sqHead(nullptr)
+    , m_sqTail(nullptr)
+    , m_sqMask(nullptr)
+    , m_sqFlags(nullptr)
+    , m_sqArray(nullptr)
+    , m_cqHead(nullptr)
+    , m_cqTail(nullptr)
+    , m_cqMask(nullptr)
+    , m_cqes(nullptr)
+    , m_sqEntries(0)
+    , m_allocations(std::make_shared<std::vector<iovec>>())
+    , m_inFlight(0)
+    , m_fileOffset(0)
+    , m_bytesQueued(0)
+    , m_bytesCompleted(0)
+    , m_bytesWritten(0)
+    , m_bounce(nullptr)
+    , m_pending(0)
+    , m_bounceBusy(false)
+{
+}
+
+UringFileSink::~UringFileSink() {
+    Close();
+}
+
+bool UringFileSink::Open(const std::string& path, size_t expectedBytes) {
+    if (IsOpen()) {
+        return false;
+    }
+
+    m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    if (m_fd < 0 && errno == EINVAL) {
+        std::cerr << "O_DIRECT not supported for " << path << ", writing buffered" << std::endl;
+        m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if (m_fd < 0) {
+        std::cerr << "Failed to open output file: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    m_bounce = DirectFileSink::AllocateAligned(BOUNCE_SIZE);
+    if (!m_bounce || !SetupRing()) {
+        Close();
+        return false;
+    }
+
+    if (expectedBytes > 0 && fallocate(m_fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(RoundUp(expectedBytes))) != 0) {
+        std::cerr << "Preallocation failed: " << std::strerror(errno) << ", continuing" << std::endl;
+    }
+
+    m_failed = false;
+    m_inFlight = 0;
+    m_fileOffset = 0;
+    m_bytesQueued = 0;
+    m_bytesCompleted = 0;
+    m_bytesWritten = 0;
+    m_pending = 0;
+    m_bounceBusy = false;
+    return true;
+}
+
+bool UringFileSink::Write(const unsigned char* data, size_t length) {
+    if (!IsOpen() || m_failed) {
+        return false;
+    }
+    m_bytesWritten += length;
+    return Stage(data, length);
+}
+
+bool UringFileSink::Submit(Buffer* buffer, size_t length, const ReleaseFn& release) {
+    if (!IsOpen() || m_failed) {
+        release(buffer);
+        return false;
+    }
+    if (!m_release) {
+        m_release = release;
+    }
+    m_bytesWritten += length;
+
+    const unsigned char* data = buffer->data.get();
+    const size_t blocks = length & ~(kAlignment - 1);
+    if (m_pending == 0 && blocks > 0 && IsAligned(data)) {
+        // The buffer itself goes to the kernel and comes back on completion;
+        // only an odd tail is copied out now
+        if (!QueueWrite(data, blocks, reinterpret_cast<uint64_t>(buffer))) {
+            release(buffer);
+            return false;
+        }
+        return Stage(data + blocks, length - blocks);
+    }
+
+    const bool ok = Stage(data, length);
+    release(buffer);
+    return ok;
+}
+
+bool UringFileSink::Reap(bool wait) {
+    if (m_ringFd < 0) {
+        return !m_failed;
+    }
+
+    unsigned head = *m_cqHead;
+    unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+    if (head == tail && wait && m_inFlight > 0) {
+        if (!Enter(0, 1, IORING_ENTER_GETEVENTS)) {
+            return false;
+        }
+        tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+    }
+
+    const io_uring_cqe* cqes = static_cast<const io_uring_cqe*>(m_cqes);
+    for (; head != tail; ++head) {
+        const io_uring_cqe& cqe = cqes[head & *m_cqMask];
+        --m_inFlight;
+        if (cqe.res < 0) {
+            std::cerr << "io_uring write failed: " << std::strerror(-cqe.res) << std::endl;
+            m_failed = true;
+        } else {
+            m_bytesCompleted += static_cast<uint64_t>(cqe.res);
+        }
+
+        if (cqe.user_data == BOUNCE_TAG) {
+            m_bounceBusy = false;
+        } else {
+            m_release(reinterpret_cast<Buffer*>(cqe.user_data));
+        }
+    }
+    __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+
+    return !m_failed;
+}
+
+bool UringFileSink::Close() {
+    if (!IsOpen()) {
+        return true;
+    }
+
+    bool ok = true;
+    if (m_ringFd >= 0) {
+        if (m_pending > 0 && !m_failed) {
+            const size_t padded = RoundUp(m_pending);
+            std::memset(m_bounce + m_pending, 0, padded - m_pending);
+            FlushBounce(padded);
+            m_pending = 0;
+        }
+        while (m_inFlight > 0 && Reap(true)) {
+        }
+        if (m_inFlight > 0) {
+            // Cannot tell which buffers are still the kernel's; leave them
+            // to BufferManager::Reset() rather than handing them out early
+            std::cerr << "io_uring writes still outstanding at close" << std::endl;
+        }
+        ok = !m_failed;
+    }
+    if (ok && m_bytesCompleted != m_bytesQueued) {
+        std::cerr << "Short io_uring write: " << m_bytesCompleted << " of " << m_bytesQueued << " bytes" << std::endl;
+        ok = false;
+    }
+    if (ftruncate(m_fd, static_cast<off_t>(m_bytesWritten)) != 0) {
+        std::cerr << "Failed to set final file size: " << std::strerror(errno) << std::endl;
+        ok = false;
+    }
+
+    TeardownRing();
+    close(m_fd);
+    m_fd = -1;
+    DirectFileSink::FreeAligned(m_bounce, BOUNCE_SIZE);
+    m_bounce = nullptr;
+    m_release = nullptr;
+    return ok;
+}
+
+BufferAllocator UringFileSink::Allocator() {
+    std::shared_ptr<std::vector<iovec>> allocations = m_allocations;
+    BufferAllocator allocator;
+    allocator.allocate = [allocations](size_t size) {
+        unsigned char* memory = DirectFileSink::AllocateAligned(size);
+        if (memory) {
+            allocations->push_back({ memory, size });
+        }
+        return memory;
+    };
+    allocator.release = [allocations](unsigned char* memory, size_t size) {
+        allocations->erase(std::remove_if(allocations->begin(), allocations->end(),
+            [memory](const iovec& v) { return v.iov_base == memory; }), allocations->end());
+        DirectFileSink::FreeAligned(memory, size);
+    };
+    return allocator;
+}
+
+bool UringFileSink::SetupRing() {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    if (m_config.sqPoll) {
+        params.flags = IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = m_config.sqIdleMs;
+    }
+
+    m_ringFd = static_cast<int>(syscall(__NR_io_uring_setup, m_config.entries, &params));
+    if (m_ringFd < 0 && m_config.sqPoll) {
+        std::cerr << "SQPOLL unavailable (" << std::strerror(errno) << "), submitting with io_uring_enter" << std::endl;
+        std::memset(&params, 0, sizeof(params));
+        m_ringFd = static_cast<int>(syscall(__NR_io_uring_setup, m_config.entries, &params));
+    }
+    if (m_ringFd < 0) {
+        std::cerr << "io_uring_setup failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    m_sqPollActive = (params.flags & IORING_SETUP_SQPOLL) != 0;
+    m_sqEntries = params.sq_entries;
+
+    m_sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) {
+        m_sqRingBytes = m_cqRingBytes = std::max<size_t>(m_sqRingBytes, m_cqRingBytes);
+    }
+
+    m_sqRing = mmap(nullptr, m_sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED) {
+        m_sqRing = nullptr;
+        std::cerr << "Failed to map io_uring: " << std::strerror(errno) << std::endl;
+        TeardownRing();
+        return false;
+    }
+    if (singleMmap) {
+        m_cqRing = m_sqRing;
+    } else {
+        m_cqRing = mmap(nullptr, m_cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_CQ_RING);
+        if (m_cqRing == MAP_FAILED) {
+            m_cqRing = nullptr;
+            std::cerr << "Failed to map io_uring: " << std::strerror(errno) << std::endl;
+            TeardownRing();
+            return false;
+        }
+    }
+    m_sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+    m_sqes = mmap(nullptr, m_sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES);
+    if (m_sqes == MAP_FAILED) {
+        m_sqes = nullptr;
+        std::cerr << "Failed to map io_uring: " << std::strerror(errno) << std::endl;
+        TeardownRing();
+        return false;
+    }
+
+    char* sq = static_cast<char*>(m_sqRing);
+    m_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    m_sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    m_sqFlags = reinterpret_cast<unsigned*>(sq + params.sq_off.flags);
+    m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(m_cqRing);
+    m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    m_cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    m_cqes = cq + params.cq_off.cqes;
+
+    // Fixed file: saves the fd lookup per write (and SQPOLL needs it on older kernels)
+    if (syscall(__NR_io_uring_register, m_ringFd, IORING_REGISTER_FILES, &m_fd, 1) != 0) {
+        std::cerr << "Failed to register output file: " << std::strerror(errno) << std::endl;
+        TeardownRing();
+        return false;
+    }
+    RegisterBuffers();
+
+    std::cout << "io_uring: " << m_sqEntries << " entries, "
+              << (m_sqPollActive ? "SQPOLL" : "io_uring_enter") << ", "
+              << m_fixedBuffers.size() << " registered buffers" << std::endl;
+    return true;
+}
+
+void UringFileSink::RegisterBuffers() {
+    // Pins the pages once instead of on every write
+    m_fixedBuffers = *m_allocations;
+    m_fixedBuffers.push_back({ m_bounce, BOUNCE_SIZE });
+    if (syscall(__NR_io_uring_register, m_ringFd, IORING_REGISTER_BUFFERS,
+                m_fixedBuffers.data(), static_cast<unsigned>(m_fixedBuffers.size())) != 0) {
+        std::cerr << "Buffer registration failed (" << std::strerror(errno)
+                  << "), using plain writes" << std::endl;
+        m_fixedBuffers.clear();
+    }
+}
+
+void UringFileSink::TeardownRing() {
+    if (m_sqes) {
+        munmap(m_sqes, m_sqesBytes);
+        m_sqes = nullptr;
+    }
+    if (m_cqRing && m_cqRing != m_sqRing) {
+        munmap(m_cqRing, m_cqRingBytes);
+    }
+    m_cqRing = nullptr;
+    if (m_sqRing) {
+        munmap(m_sqRing, m_sqRingBytes);
+        m_sqRing = nullptr;
+    }
+    if (m_ringFd >= 0) {
+        close(m_ringFd);  // Also drops the registered file and buffers
+        m_ringFd = -1;
+    }
+    m_fixedBuffers.clear();
+    m_sqPollActive = false;
+}
+
+int UringFileSink::FixedBufferIndex(const unsigned char* data, size_t length) const {
+    for (size_t i = 0; i < m_fixedBuffers.size(); ++i) {
+        const unsigned char* base = static_cast<const unsigned char*>(m_fixedBuffers[i].iov_base);
+        if (data >= base && data + length <= base + m_fixedBuffers[i].iov_len) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool UringFileSink::QueueWrite(const unsigned char* data, size_t length, uint64_t userData) {
+    // Every write owns a completion slot; make room first if the ring is full
+    while (m_inFlight >= m_sqEntries) {
+        if (!Reap(true)) {
+            return false;
+        }
+    }
+
+    const unsigned tail = *m_sqTail;
+    const unsigned index = tail & *m_sqMask;
+    io_uring_sqe& sqe = static_cast<io_uring_sqe*>(m_sqes)[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+
+    const int fixed = FixedBufferIndex(data, length);
+    sqe.opcode = fixed >= 0 ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe.buf_index = static_cast<uint16_t>(fixed >= 0 ? fixed : 0);
+    sqe.flags = IOSQE_FIXED_FILE;
+    sqe.fd = 0;  // Index into the registered files
+    sqe.addr = reinterpret_cast<uint64_t>(data);
+    sqe.len = static_cast<uint32_t>(length);
+    sqe.off = m_fileOffset;
+    sqe.user_data = userData;
+
+    m_sqArray[index] = index;
+    __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+    m_fileOffset += length;
+    m_bytesQueued += length;
+    ++m_inFlight;
+
+    // From here on the data belongs to the kernel; if the kick fails,
+    // m_failed makes the next call report it
+    if (m_sqPollActive) {
+        // The poller picks the entry up by itself unless it has gone idle
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(m_sqFlags, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP) {
+            Enter(0, 0, IORING_ENTER_SQ_WAKEUP);
+        }
+    } else {
+        Enter(1, 0, 0);
+    }
+    return true;
+}
+
+bool UringFileSink::Enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    for (;;) {
+        if (syscall(__NR_io_uring_enter, m_ringFd, toSubmit, minComplete, flags, nullptr, 0) >= 0) {
+            return true;
+        }
+        if (errno != EINTR) {
+            std::cerr << "io_uring_enter failed: " << std::strerror(errno) << std::endl;
+            m_failed = true;
+            return false;
+        }
+    }
+}
+
+bool UringFileSink::Stage(const unsigned char* data, size_t length) {
+    while (length > 0) {
+        const size_t chunk = std::min<size_t>(length, BOUNCE_SIZE - m_pending);
+        std::memcpy(m_bounce + m_pending, data, chunk);
+        m_pending += chunk;
+        data += chunk;
+        length -= chunk;
+
+        if (m_pending == BOUNCE_SIZE) {
+            if (!FlushBounce(BOUNCE_SIZE)) {
+                return false;
+            }
+            m_pending = 0;
+        }
+    }
+    return true;
+}
+
+bool UringFileSink::FlushBounce(size_t length) {
+    // Only one bounce buffer, so wait until the kernel is done with it
+    m_bounceBusy = true;
+    if (!QueueWrite(m_bounce, length, BOUNCE_TAG)) {
+        m_bounceBusy = false;
+        return false;
+    }
+    while (m_bounceBusy) {
+        if (!Reap(true)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif // __linux__
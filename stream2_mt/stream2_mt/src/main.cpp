@@ -1,20 +1,355 @@
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
-#include <WinDef.h>
-#include <basetsd.h>   // Add this for additional type definitions
-#include <wtypes.h>    // Add this for additional type definitions
-#include <minwindef.h> // Add this for additional type definitions
+#include "../include/CaptureScanner.h"
 #include "../include/DataStreamer.h"
+#include "../include/DirectFileSink.h"
+#include "../include/FileReplayTransport.h"
+#include "../include/FrameViewer.h"
+#include "../include/MappedFile.h"
+#include "../include/Metrics.h"
+#include "../include/QueueTuner.h"
+#include "../include/SimulatedFx3Transport.h"
+#include "../include/StreamFileSink.h"
+#include "../include/UringFileSink.h"
+#ifdef _WIN32
+#include "../include/CyUsbTransport.h"
+#endif
+#ifdef USE_LIBUSB
+#include "../include/LibUsbTransport.h"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
 
-int main() {
+static void PrintUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --out <path>          Output file\n"
+              << "  --mb <n>              Megabytes to capture (default 100)\n"
+              << "  --depth <n>           Transfers kept in flight (default 4)\n"
+              << "  --xfer <KB>           Size of each transfer (default 256)\n"
+              << "  --autotune            Sweep depth x size against the source first and use the\n"
+              << "                        smallest queue that sustains --target-rate without drops\n"
+              << "  --target-rate <MB/s>  Rate --autotune has to sustain (default 297)\n"
+              << "  --sink <name>         Disk writer: ofstream (default), direct (unbuffered I/O)\n"
+#ifdef __linux__
+              << "                        or io_uring (direct I/O, many writes in flight)\n"
+#endif
+              << "  --sim                 Use the FX3 simulator instead of the board\n"
+#ifdef USE_LIBUSB
+              << "  --libusb [vid:pid]    Use libusb (default 04b4:00f1; g_zero is 0525:a4a0)\n"
+              << "  --endpoint <addr>     libusb bulk-IN endpoint (default 0x81)\n"
+              << "  --zerocopy            Allocate buffers with libusb_dev_mem_alloc\n"
+#endif
+              << "  --replay <file>       Play a saved capture back instead of the board\n"
+              << "  --loop                Replay wraps around at the end of the capture\n"
+              << "  --counter             Simulator sends the counter pattern instead of video\n"
+              << "  --rate <MB/s>         Simulator/replay rate, 0 = unthrottled\n"
+              << "                        (default 297 for the simulator, 0 for replay)\n"
+              << "  --stall-every <n>     Simulator stalls every n transfers...\n"
+              << "  --stall-ms <ms>       ...for this long\n"
+              << "  --short-every <n>     Simulator ends every n-th transfer on a short packet\n"
+              << "  --scan <file>         Parse a saved capture into lines on all cores and exit\n"
+              << "  --threads <n>         Threads for --scan (default: one per core)\n"
+              << "  --view <file>         Play a capture through the parser into a headless viewer\n"
+              << "                        at --rate and report frames produced vs presented\n"
+              << "  --equalize            Show --view frames through CLAHE\n"
+              << "  --metrics <file>      Export metrics every second: Prometheus text if the\n"
+              << "                        name ends in .prom, otherwise appended JSON lines\n";
+}
+
+// Offline parse of a saved capture: sync code and line counts, and how fast
+static int ScanCaptureFile(const std::string& path, unsigned threads) {
+    MappedFile capture;
+    if (!capture.Open(path)) {
+        return -1;
+    }
+
+    CaptureScanConfig config;
+    config.threads = threads;
+    const auto start = std::chrono::steady_clock::now();
+    const CaptureScan scan = ScanCapture(reinterpret_cast<const uint32_t*>(capture.Data()), capture.Size() / 4, config);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t codes[4] = {};
+    for (const SyncMark& mark : scan.marks) {
+        switch (mark.code) {
+        case SyncCode::SAV: ++codes[0]; break;
+        case SyncCode::EAV: ++codes[1]; break;
+        case SyncCode::SAVI: ++codes[2]; break;
+        case SyncCode::EAVI: ++codes[3]; break;
+        }
+    }
+    size_t frames = 0;
+    size_t withoutEav = 0;
+    for (const LineSpan& line : scan.lines) {
+        frames += line.newFrame ? 1 : 0;
+        withoutEav += line.hasEav ? 0 : 1;
+    }
+
+    std::cout << "SAV: " << codes[0] << "  EAV: " << codes[1]
+              << "  SAVI: " << codes[2] << "  EAVI: " << codes[3] << std::endl;
+    std::cout << "Lines: " << scan.lines.size() << " (" << withoutEav << " without EAV)  Frames: " << frames << std::endl;
+    std::cout << "Scanned " << capture.Size() / (1024.0 * 1024.0) << " MB in " << seconds * 1000.0 << " ms ("
+              << capture.Size() / (1024.0 * 1024.0) / seconds << " MB/s)" << std::endl;
+    return 0;
+}
+
+// Plays a capture through the line parser into a headless FrameViewer, the
+// way Vis0's live view runs, and reports frames produced against presented
+static int ViewCaptureFile(const std::string& path, const ReplayConfig& config, const DisplaySettings& settings,
+                           MetricsReporter& metrics, size_t maxBytes) {
+    const size_t bufferBytes = 65280;  // Vis0's acquisition buffer
+    FileReplayTransport transport(path, config);
+    if (!transport.Open() || !transport.Configure(1, bufferBytes)) {
+        return -1;
+    }
+
+    FramePool pool(3);
+    FramePublisher publisher(pool);
+    HeadlessSurface surface;
+    FrameViewer viewer(pool, surface);
+    viewer.SetSettings(settings);
+    if (!viewer.Start()) {
+        return -1;
+    }
+
+    LineParser parser;
+    std::vector<unsigned char> buffer(bufferBytes);
+    size_t replayed = 0;
+    size_t buffers = 0;
+    double parseSeconds = 0.0;
+    while (replayed < maxBytes && transport.Submit(0, buffer.data(), buffer.size())) {
+        size_t transferred = 0;
+        if (transport.Reap(0, 1000, transferred) != TransferStatus::Completed) {
+            break;  // End of the capture
+        }
+        const auto start = std::chrono::steady_clock::now();
+        parser.Feed(reinterpret_cast<const uint32_t*>(buffer.data()), transferred / 4, publisher);
+        parseSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        replayed += transferred;
+        ++buffers;
+    }
+    parser.Flush(publisher);
+    publisher.Finish();
+
+    // Give the last frame a refresh to reach the surface
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    viewer.Stop();
+
+    const FrameViewerStats stats = viewer.Stats();
+    const ViewerTexture& last = surface.Offscreen();
+    std::cout << "Frames: " << stats.produced << " produced (" << stats.produced / stats.seconds << " fps), "
+              << stats.uploaded << " uploaded, " << stats.presented << " presented ("
+              << stats.presented / stats.seconds << " fps) in " << stats.seconds << " s" << std::endl;
+    std::cout << "Last presented: frame " << last.frameNumber << " (" << last.width << "x" << last.height << ")"
+              << ", " << publisher.LostLines() << " lines lost waiting for a free frame" << std::endl;
+    std::cout << "Metrics: " << metrics.Tick() << std::endl;
+    if (buffers > 0) {
+        std::cout << "Parse cost: " << parseSeconds * 1e6 / buffers << " us per buffer over " << buffers
+                  << " buffers" << std::endl;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
     try {
-        DataStreamer streamer;
-        
         // Specify the desired file size (e.g., 100MB)
-        const size_t TARGET_SIZE = 100 * 1024 * 1024;  // 100 MB
+        size_t targetMb = 100;
+#ifdef _WIN32
+        std::string outputPath = "C:/Users/cmirand4/Documents/MATLAB/VI_Data/streamTest/counter2.bin";
+        bool useSimulator = false;
+#else
+        std::string outputPath = "counter2.bin";
+#ifdef USE_LIBUSB
+        bool useSimulator = false;
+#else
+        bool useSimulator = true;  // No device backend built in
+#endif
+#endif
+        int queueDepth = 0;          // 0 = DataStreamer default
+        size_t transferSize = 0;
+        bool autoTune = false;
+        std::string sinkName = "ofstream";
+        QueueTuneOptions tuneOptions;
+        SimulatorConfig simConfig;
+        std::string replayPath;
+        ReplayConfig replayConfig;
+        std::string scanPath;
+        unsigned scanThreads = 0;
+        std::string viewPath;
+        DisplaySettings viewSettings;
+        MetricsReporter metrics;
+#ifdef USE_LIBUSB
+#ifdef _WIN32
+        bool useLibUsb = false;
+#else
+        bool useLibUsb = true;
+#endif
+        LibUsbConfig usbConfig;
+#endif
 
-        if (!streamer.Initialize(TARGET_SIZE)) {
+        for (int i = 1; i < argc; ++i) {
+            const char* arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (std::strcmp(arg, "--sim") == 0) {
+                useSimulator = true;
+            }
+#ifdef USE_LIBUSB
+            else if (std::strcmp(arg, "--libusb") == 0) {
+                useLibUsb = true;
+                unsigned vid = 0, pid = 0;
+                if (hasValue && std::sscanf(argv[i + 1], "%x:%x", &vid, &pid) == 2) {
+                    usbConfig.vendorId = static_cast<uint16_t>(vid);
+                    usbConfig.productId = static_cast<uint16_t>(pid);
+                    ++i;
+                }
+            } else if (std::strcmp(arg, "--endpoint") == 0 && hasValue) {
+                usbConfig.endpoint = static_cast<unsigned char>(std::strtoul(argv[++i], nullptr, 0));
+            } else if (std::strcmp(arg, "--zerocopy") == 0) {
+                usbConfig.useDeviceMemory = true;
+            }
+#endif
+            else if (std::strcmp(arg, "--replay") == 0 && hasValue) {
+                replayPath = argv[++i];
+            } else if (std::strcmp(arg, "--scan") == 0 && hasValue) {
+                scanPath = argv[++i];
+            } else if (std::strcmp(arg, "--view") == 0 && hasValue) {
+                viewPath = argv[++i];
+            } else if (std::strcmp(arg, "--metrics") == 0 && hasValue) {
+                if (!metrics.SetExport(argv[++i])) {
+                    return -1;
+                }
+            } else if (std::strcmp(arg, "--equalize") == 0) {
+                viewSettings.equalize = true;
+            } else if (std::strcmp(arg, "--threads") == 0 && hasValue) {
+                scanThreads = static_cast<unsigned>(std::atoi(argv[++i]));
+            } else if (std::strcmp(arg, "--loop") == 0) {
+                replayConfig.loop = true;
+            } else if (std::strcmp(arg, "--counter") == 0) {
+                simConfig.pattern = SimulatorPattern::Counter;
+            } else if (std::strcmp(arg, "--out") == 0 && hasValue) {
+                outputPath = argv[++i];
+            } else if (std::strcmp(arg, "--mb") == 0 && hasValue) {
+                targetMb = std::strtoull(argv[++i], nullptr, 10);
+            } else if (std::strcmp(arg, "--depth") == 0 && hasValue) {
+                queueDepth = std::atoi(argv[++i]);
+            } else if (std::strcmp(arg, "--xfer") == 0 && hasValue) {
+                transferSize = std::strtoull(argv[++i], nullptr, 10) * 1024;
+            } else if (std::strcmp(arg, "--sink") == 0 && hasValue) {
+                sinkName = argv[++i];
+            } else if (std::strcmp(arg, "--autotune") == 0) {
+                autoTune = true;
+            } else if (std::strcmp(arg, "--target-rate") == 0 && hasValue) {
+                tuneOptions.targetBytesPerSecond = std::atof(argv[++i]) * 1024 * 1024;
+            } else if (std::strcmp(arg, "--rate") == 0 && hasValue) {
+                simConfig.bytesPerSecond = std::atof(argv[++i]) * 1024 * 1024;
+                replayConfig.bytesPerSecond = simConfig.bytesPerSecond;
+            } else if (std::strcmp(arg, "--stall-every") == 0 && hasValue) {
+                simConfig.stallEveryTransfers = static_cast<uint32_t>(std::atoi(argv[++i]));
+            } else if (std::strcmp(arg, "--stall-ms") == 0 && hasValue) {
+                simConfig.stallMs = static_cast<uint32_t>(std::atoi(argv[++i]));
+            } else if (std::strcmp(arg, "--short-every") == 0 && hasValue) {
+                simConfig.shortPacketEveryTransfers = static_cast<uint32_t>(std::atoi(argv[++i]));
+            } else {
+                PrintUsage(argv[0]);
+                return -1;
+            }
+        }
+
+        if (!scanPath.empty()) {
+            return ScanCaptureFile(scanPath, scanThreads);
+        }
+        if (!viewPath.empty()) {
+            return ViewCaptureFile(viewPath, replayConfig, viewSettings, metrics, targetMb * 1024 * 1024);
+        }
+
+        size_t targetBytes = targetMb * 1024 * 1024;
+
+        std::unique_ptr<BulkInTransport> transport;
+        if (!replayPath.empty()) {
+            auto replay = std::make_unique<FileReplayTransport>(replayPath, replayConfig);
+            if (!replay->Open()) {
+                return -1;
+            }
+            // A single pass can only deliver what is in the file
+            if (!replayConfig.loop) {
+                targetBytes = std::min<size_t>(targetBytes, replay->FileBytes());
+            }
+            transport = std::move(replay);
+        }
+        else if (useSimulator) {
+            transport = std::make_unique<SimulatedFx3Transport>(simConfig);
+        }
+#ifdef USE_LIBUSB
+        else if (useLibUsb) {
+            transport = std::make_unique<LibUsbTransport>(usbConfig);
+        }
+#endif
+#ifdef _WIN32
+        else {
+            transport = std::make_unique<CyUsbTransport>(0);
+        }
+#endif
+
+        if (!transport) {
+            std::cerr << "No USB backend available" << std::endl;
+            return -1;
+        }
+
+        if (autoTune) {
+            if (!transport->IsOpen() && !transport->Open()) {
+                std::cerr << "Failed to open " << transport->Name() << " transport" << std::endl;
+                return -1;
+            }
+
+            std::cout << "Tuning queue against " << transport->Name() << " for "
+                      << tuneOptions.targetBytesPerSecond / (1024 * 1024) << " MB/s..." << std::endl;
+            QueueTuner tuner(*transport, tuneOptions);
+            const auto points = tuner.Sweep();
+            QueueTuner::PrintCurve(points, std::cout);
+
+            QueueTunePoint best;
+            if (!QueueTuner::PickSmallest(points, best)) {
+                std::cerr << "No queue sustained the target rate; using the fastest one" << std::endl;
+            }
+            queueDepth = best.depth;
+            transferSize = best.transferSize;
+        }
+
+        DataStreamer streamer(std::move(transport));
+        if (queueDepth > 0 || transferSize > 0) {
+            const int depth = queueDepth > 0 ? queueDepth : streamer.NumBuffers();
+            const size_t size = transferSize > 0 ? transferSize : streamer.BufferSize();
+            if (!streamer.SetQueueConfig(depth, size)) {
+                std::cerr << "Invalid queue configuration" << std::endl;
+                return -1;
+            }
+        }
+
+        std::unique_ptr<FileSink> sink;
+        if (sinkName == "ofstream") {
+            sink = std::make_unique<StreamFileSink>();
+        } else if (sinkName == "direct") {
+            sink = std::make_unique<DirectFileSink>();
+        }
+#ifdef __linux__
+        else if (sinkName == "io_uring") {
+            sink = std::make_unique<UringFileSink>();
+        }
+#endif
+        else {
+            std::cerr << "Unknown disk writer: " << sinkName << std::endl;
+            return -1;
+        }
+        streamer.SetFileSink(std::move(sink));
+
+        const size_t TARGET_SIZE = targetBytes;
+
+        if (!streamer.Initialize(TARGET_SIZE, outputPath)) {
             std::cerr << "Failed to initialize streamer" << std::endl;
             return -1;
         }
@@ -24,17 +359,34 @@ int main() {
             return -1;
         }
 
-        std::cout << "Streaming data... Target size: " << TARGET_SIZE / (1024*1024) << " MB" << std::endl;
+        std::cout << "Streaming data... Target size: " << TARGET_SIZE / (1024.0*1024.0) << " MB" << std::endl;
         std::cout << "Will automatically stop when target size is reached." << std::endl;
+        const auto streamStart = std::chrono::steady_clock::now();
 
-        // Wait for completion
-        while (!streamer.IsComplete()) {
-            Sleep(100);  // Small delay to prevent CPU spinning
+        // Wait for completion, reporting once a second so a queue that has
+        // lost depth after a stall is visible
+        int ticks = 0;
+        while (!streamer.IsComplete() && streamer.IsRunning()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));  // Small delay to prevent CPU spinning
+            if (++ticks % 10 == 0) {
+                std::cout << "Written " << streamer.BytesWritten() / (1024 * 1024) << " MB | "
+                          << metrics.Tick() << std::endl;
+            }
         }
 
-        std::cout << "Target size reached. Stopping..." << std::endl;
+        metrics.Tick();  // The export ends with the whole run
+        const bool complete = streamer.IsComplete();
+        std::cout << (complete ? "Target size reached. Stopping..." : "Capture stopped early.") << std::endl;
         streamer.StopStreaming();
-        return 0;
+
+        // Includes the final flush/truncate, so this is the sustained rate
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - streamStart).count();
+        const LatencyHistogram& latency = streamer.WriteLatency();
+        std::cout << "Disk (" << streamer.FileSinkName() << "): "
+                  << streamer.BytesWritten() / (1024.0 * 1024.0) / seconds << " MB/s, write p50 "
+                  << latency.Percentile(50) << " us, p99 " << latency.Percentile(99) << " us, max "
+                  << latency.Max() << " us" << std::endl;
+        return complete ? 0 : -1;
     }
     catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;